@@ -30,101 +30,496 @@
 #include "app.h"
 #include "../gui/gui.h"
 #include "../serial/serial.h"
+#include "../serial/tx_engine.h"
+#include "../time_funcs/time_funcs.h"
+#include "../reactor/reactor.h"
+#include "../time_funcs/timer_wheel.h"
+#include "../log/log.h"
+#include "../trace/trace.h"
+#include "../stats/profiler.h"
+#include "../stats/metrics.h"
+#include "../stats/flow.h"
+#include "app_ping.h"
+#include "app_send.h"
+#include "app_script.h"
+#include "app_perf.h"
+#include "app_metrics.h"
+#include "app_bridge.h"
 #include <stdio.h>
 
 /****************************************************************************
  * Definitions
  *****************************************************************************/
 
+
+/* Resolution of the timer wheel */
+#define APP_TIMER_TICK_NS NSEC_PER_MSEC
+
+/* Longest sleep when no timer is due sooner, in ms */
+#define APP_MAX_SLEEP_MS 1000U
+
+/* Sleep while every RX chunk is in use. Chunks come back from other threads
+ * without waking the loop, so it looks again after this long. */
+#define APP_POOL_RETRY_MS 1U
+
+/* Rates the sinks can sustain in bytes per second. Faster data is
+ * summarised for that sink only, decoding still sees every byte. The hex
+ * dump writes a log line per byte, the GUI is limited by its queue and
+ * frame budget. */
+#ifndef APP_DUMP_MAX_RATE
+#define APP_DUMP_MAX_RATE (16U * 1024U)
+#endif
+#ifndef APP_GUI_MAX_RATE
+#define APP_GUI_MAX_RATE (256U * 1024U)
+#endif
+
+/* Bytes per hex dump line */
+#define APP_DUMP_LINE_BYTES 16U
+
+/* How often summarising sinks report skipped bytes and get a chance to recover */
+#define APP_FLOW_TICK_MS 250U
+
+/**
+ * @brief A consumer of the RX bytes with its flow control state and metrics.
+ */
+typedef struct app_sink_t {
+    flow_t flow;
+    metric_t *summary_metric;       /**< 1 while summarising */
+    metric_t *skipped_metric;       /**< Bytes summarised */
+    metric_t *degraded_metric;      /**< Switches to summary mode */
+} app_sink_t;
+
 /****************************************************************************
  * Variables
  *****************************************************************************/
 
+/* Every timed callback in the main loop (ping, perf, scripts) is scheduled
+ * here. The GUI thread runs its frames and LEDs on its own. */
+static timer_wheel_t wheel;
+
+/* The GUI sink only runs when the GUI thread was started */
+static bool gui_enabled = false;
+
+static metric_t *loop_latency_metric;
+
+static app_sink_t dump_sink;
+static app_sink_t gui_sink;
+static tw_timer_t flow_timer;
+
+/* Bytes on the current hex dump line */
+static uint32_t dump_column = 0;
+
 /****************************************************************************
  * Prototypes
  *****************************************************************************/
 
 
 /**
- * @brief Dumps a byte as hexadecimal.
+ * @brief Dumps bytes as hexadecimal, APP_DUMP_LINE_BYTES to a line.
  *
- * This function takes a byte as input and prints its hexadecimal representation.
+ * Each completed line is one log message, and so is whatever is left of
+ * the line at the end, so a slow trickle of bytes still shows up straight away.
  *
- * @param byte The byte to be dumped.
+ * @param data The bytes to be dumped.
+ * @param len Number of bytes.
  */
-static void dump_byte_as_hex(uint8_t byte);
+static void dump_bytes_as_hex(const uint8_t *data, size_t len);
 
 /**
- * @brief Processes the given data.
+ * @brief Processes a received chunk.
  *
- * This function is responsible for processing the provided data.
- * It takes a uint8_t data as input and performs the necessary operations.
+ * The parsers see the whole chunk first, then the sinks. Each stage is
+ * timed once per chunk rather than once per byte. Sinks that keep the data
+ * take their own reference to the chunk instead of copying it.
  *
- * @param data The data to be processed.
+ * @param chunk The received bytes.
+ */
+static void process_chunk(chunk_t *chunk);
+
+/**
+ * @brief Set up a sink's flow control and register its metrics.
+ */
+static void sink_init(app_sink_t *sink, const char *name, uint64_t max_rate,
+                      const char *summary_name, const char *skipped_name, const char *degraded_name);
+
+/**
+ * @brief Log and count a sink switching between full and summary mode.
+ */
+static void sink_changed(app_sink_t *sink);
+
+/**
+ * @brief Record bytes a sink got as a summary only.
+ */
+static void sink_skip(app_sink_t *sink, size_t len);
+
+/**
+ * @brief Print a "bytes skipped" line for what the hex dump summarised since the last one.
+ */
+static void dump_skipped_marker(void);
+
+/**
+ * @brief Feed the hex dump sink.
+ */
+static void dump_sink_write(const uint8_t *data, size_t len, uint64_t now_ns);
+
+/**
+ * @brief Feed the GUI sink.
+ */
+static void gui_sink_write(chunk_t *chunk, uint64_t now_ns);
+
+/**
+ * @brief Timer callback: skipped markers, the GUI status line and recovery of idle sinks.
  */
-static void process_data(uint8_t data);
+static void on_flow_timer(tw_timer_t *timer, void *ctx);
+
+/**
+ * @brief Reactor callback for the serial port: do the I/O and process what arrived.
+ */
+static void on_serial(int fd, uint32_t events, void *ctx);
+
+/**
+ * @brief Reactor callback for the TX engine pacing timer.
+ */
+static void on_tx_timer(int fd, uint32_t events, void *ctx);
+
+/**
+ * @brief Runs before the loop sleeps: work that isn't driven by a descriptor.
+ *
+ * @return int longest time the loop may sleep in ms, -1 for no limit
+ */
+static int on_prepare(void *ctx);
 
 /****************************************************************************
  * Functions
  *****************************************************************************/
 
-bool app_init(const char *serial_port_path)
+bool app_init(const char *serial_port_path, bool headless)
 {   
     bool result = false;
 
+    /* Calibrate the cycle counter before anything starts timing with it */
+    time_funcs_init();
+
+    if (!reactor_init()) {
+        return false;
+    }
+
+    timer_wheel_init(&wheel, APP_TIMER_TICK_NS, get_nanos());
+    app_ping_init(&wheel);
+    app_send_init();
+    app_perf_init(&wheel);
+    app_metrics_init(&wheel);
+    app_bridge_init();
+
+    loop_latency_metric = metrics_histogram("loop_latency_seconds", "Time one main loop iteration spent handling events");
+
+    sink_init(&dump_sink, "hex dump", APP_DUMP_MAX_RATE, "dump_sink_summarising",
+              "dump_sink_skipped_bytes_total", "dump_sink_degraded_total");
+    sink_init(&gui_sink, "GUI", APP_GUI_MAX_RATE, "gui_sink_summarising",
+              "gui_sink_skipped_bytes_total", "gui_sink_degraded_total");
+    timer_wheel_timer_init(&flow_timer);
+    timer_wheel_schedule(&wheel, &flow_timer, APP_FLOW_TICK_MS * NSEC_PER_MSEC, on_flow_timer, NULL);
+
     result = serial_init(serial_port_path);
     if (!result) {
         serial_close();
-        printf("port %s INVALID\n", serial_port_path);
+        log_error("port %s INVALID\n", serial_port_path);
         return false;
     }
 
-    printf("port %s opened successfully\n", serial_port_path);
+    log_info("port %s opened successfully\n", serial_port_path);
 
-    return gui_init(5);
+    if (!tx_engine_init()) {
+        return false;
+    }
+
+    if (!headless && !APP_HEADLESS) {
+        if (!gui_init(GUI_DEFAULT_FPS)) {
+            return false;
+        }
+        gui_enabled = true;
+    }
+
+    /* Everything below is driven by the reactor instead of being polled */
+    result = reactor_add_fd(serial_get_fd(), REACTOR_EV_READ, on_serial, NULL);
+    result = result && reactor_add_fd(tx_engine_get_fd(), REACTOR_EV_READ, on_tx_timer, NULL);
+    result = result && reactor_add_prepare(on_prepare, NULL);
+    result = result && app_script_init(&wheel);
+    if (!result) {
+        log_error("app: failed to register with the reactor\n");
+        return false;
+    }
+
+    return true;
 }
 
 void app_deinit(void)
 {
+    app_ping_stop();
+    app_script_deinit();
+    app_perf_deinit();
+    app_metrics_deinit();
+    app_bridge_deinit();
+    timer_wheel_cancel(&wheel, &flow_timer);
+    gui_deinit();
+    reactor_deinit();
+    tx_engine_deinit();
     serial_close();
 }
 
 void app_task_handler(void)
 {
-    char c;
+    TRACE_BEGIN("app_task_handler");
+
+    /* Sleep until the port, a timer or another thread has something for us */
+    reactor_run_once(-1);
+
+    TRACE_END("app_task_handler");
+}
+
+static void on_serial(int fd, uint32_t events, void *ctx)
+{
+    chunk_t *chunk;
+    (void)ctx;
+
+    if (events & REACTOR_EV_ERROR) {
+        log_error("serial port error or hang up, no longer watching it\n");
+        reactor_remove(fd);
+        return;
+    }
 
-    /* Call the serial task periodically or as fast as is reasonable */
     serial_task();
 
     /* Do something with any data currently in the RX buffer */
-    if (!serial_rx_buf_is_empty()) {
-        do {   
-            if (serial_rx_buf_pop((uint8_t*)&c)) {
-                process_data((uint8_t)c);
-            }
-        } while (!serial_rx_buf_is_empty());
-    } 
-
-    gui_task();   
+    while ((chunk = serial_rx_chunk_pop()) != NULL) {
+        process_chunk(chunk);
+        chunk_release(chunk);
+    }
+}
+
+static void on_tx_timer(int fd, uint32_t events, void *ctx)
+{
+    (void)fd;
+    (void)events;
+    (void)ctx;
+
+    tx_engine_task();
+}
+
+static int on_prepare(void *ctx)
+{
+    uint64_t next_ns;
+    uint32_t serial_events;
+    (void)ctx;
+
+    /* Everything since the last wait returned was spent handling events */
+    uint64_t woke_ns = reactor_get_wake_ns();
+    if (woke_ns != 0) {
+        metrics_observe(loop_latency_metric, get_nanos() - woke_ns);
+    }
+
+    /* Run everything that came due while handling the last events */
+    timer_wheel_advance(&wheel, get_nanos());
+
+    /* A max rate transmission (or one just started from the CLI) tops up here */
+    tx_engine_task();
+
+    /* Only ask for writable events while there is something to write, and
+     * for readable ones while there is a chunk to read into, otherwise the
+     * loop would wake up constantly */
+    bool rx_stalled = serial_rx_buf_is_full();
+    serial_events = rx_stalled ? 0U : REACTOR_EV_READ;
+    if (!serial_tx_buf_is_empty()) {
+        serial_events |= REACTOR_EV_WRITE;
+    }
+    reactor_set_events(serial_get_fd(), serial_events);
+
+    /* Sleep until the next timer is due. Round up so the loop doesn't wake
+     * just before the deadline and find nothing to do. */
+    next_ns = timer_wheel_next_ns(&wheel, get_nanos());
+    if (UINT64_MAX == next_ns) {
+        return rx_stalled ? (int)APP_POOL_RETRY_MS : -1;
+    }
+
+    next_ns = (next_ns + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC;
+    if (rx_stalled && (next_ns > APP_POOL_RETRY_MS)) {
+        return (int)APP_POOL_RETRY_MS;
+    }
+    return (next_ns > APP_MAX_SLEEP_MS) ? (int)APP_MAX_SLEEP_MS : (int)next_ns;
+}
+
+
+static void process_chunk(chunk_t *chunk)
+{
+    const uint8_t *data = chunk->data;
+    const size_t len = chunk->len;
+    uint64_t start = now_cycles();
+
+    // Decode: look for ping responses and script expectations
+    for (size_t i = 0; i < len; i++) {
+        app_ping_process_byte(data[i], chunk->first_index + i);
+        app_script_process_byte(data[i]);
+    }
+
+    uint64_t decoded = now_cycles();
+    profiler_record(PROF_STAGE_DECODE, decoded - start, len);
+
+    // Sinks: show the data, or a summary of it if they can't keep up
+    uint64_t now = get_nanos();
+    dump_sink_write(data, len, now);
+    if (gui_enabled) {
+        gui_sink_write(chunk, now);
+    }
+    app_bridge_write(chunk);
+
+    profiler_record(PROF_STAGE_SINKS, now_cycles() - decoded, len);
+}
+
+static void sink_init(app_sink_t *sink, const char *name, uint64_t max_rate,
+                      const char *summary_name, const char *skipped_name, const char *degraded_name)
+{
+    flow_init(&sink->flow, name, max_rate, get_nanos());
+    sink->summary_metric = metrics_gauge(summary_name, "1 while the sink only gets a summary of the RX data");
+    sink->skipped_metric = metrics_counter(skipped_name, "RX bytes the sink got as a summary only");
+    sink->degraded_metric = metrics_counter(degraded_name, "Times the sink fell behind and switched to a summary");
 }
 
+static void sink_changed(app_sink_t *sink)
+{
+    if (FLOW_MODE_SUMMARY == flow_get_mode(&sink->flow)) {
+        log_info("\n[flow] %s can't keep up (%llu B/s max), summarising\n",
+                 sink->flow.name, (unsigned long long)sink->flow.max_rate);
+        metrics_set(sink->summary_metric, 1);
+        metrics_add(sink->degraded_metric, 1);
+    }
+    else {
+        if (&dump_sink == sink) {
+            dump_skipped_marker();
+        }
+        else {
+            gui_set_status_text(NULL);
+        }
+        log_info("\n[flow] %s caught up, showing every byte again\n", sink->flow.name);
+        metrics_set(sink->summary_metric, 0);
+    }
 
-static void process_data(uint8_t data)
+    /* The dump starts a fresh line after its own mode change, the GUI sink
+     * changing mode must not move where the dump breaks its lines */
+    if (&dump_sink == sink) {
+        dump_column = 0;
+    }
+}
+
+static void sink_skip(app_sink_t *sink, size_t len)
 {
-    // Process the data
-    dump_byte_as_hex(data);
-    gui_process_byte(data);
+    flow_skip(&sink->flow, len);
+    metrics_add(sink->skipped_metric, len);
 }
 
-static void dump_byte_as_hex(uint8_t byte)
+static void dump_skipped_marker(void)
 {
-    static int count = 0;
-    printf("%02X ", byte);
-    count++;
-    if (count == 16)
-    {
-        printf("\n");
-        count = 0;
-    }
-    fflush(stdout);
+    uint64_t skipped = flow_take_skipped(&dump_sink.flow);
+
+    if (skipped > 0) {
+        log_info("\n[flow] %llu bytes skipped (%llu B/s)\n",
+                 (unsigned long long)skipped, (unsigned long long)dump_sink.flow.last_rate);
+        dump_column = 0;
+    }
+}
+
+static void dump_sink_write(const uint8_t *data, size_t len, uint64_t now_ns)
+{
+    if (flow_offer(&dump_sink.flow, len, now_ns)) {
+        sink_changed(&dump_sink);
+    }
+
+    // Summarised by the "bytes skipped" markers from on_flow_timer()
+    if (FLOW_MODE_SUMMARY == flow_get_mode(&dump_sink.flow)) {
+        sink_skip(&dump_sink, len);
+        return;
+    }
+
+    dump_bytes_as_hex(data, len);
+}
+
+static void gui_sink_write(chunk_t *chunk, uint64_t now_ns)
+{
+    const size_t len = chunk->len;
+
+    if (flow_offer(&gui_sink.flow, len, now_ns)) {
+        sink_changed(&gui_sink);
+    }
+
+    if (FLOW_MODE_FULL == flow_get_mode(&gui_sink.flow)) {
+        // Only hands over a reference, the GUI thread draws it
+        if (!gui_post_chunk(chunk, 1) && flow_report_backlog(&gui_sink.flow, now_ns)) {
+            sink_changed(&gui_sink);
+        }
+        return;
+    }
+
+    // The hex view still gets every byte through the history, the chart
+    // enough of them to stay within the GUI's rate (and at most every other one)
+    uint64_t rate = (gui_sink.flow.last_rate > gui_sink.flow.max_rate) ? gui_sink.flow.last_rate : gui_sink.flow.max_rate;
+    uint32_t step = (uint32_t)((rate + gui_sink.flow.max_rate - 1U) / gui_sink.flow.max_rate) + 1U;
+    if (gui_post_chunk(chunk, step)) {
+        sink_skip(&gui_sink, len - ((len + step - 1U) / step));
+    }
+    else if (flow_report_backlog(&gui_sink.flow, now_ns)) {
+        // Dropped rather than summarised (counted by the GUI), and still behind
+        sink_changed(&gui_sink);
+    }
+}
+
+static void on_flow_timer(tw_timer_t *timer, void *ctx)
+{
+    char text[96];
+    uint64_t now = get_nanos();
+    (void)ctx;
+
+    if (flow_tick(&dump_sink.flow, now)) {
+        sink_changed(&dump_sink);
+    }
+    if (FLOW_MODE_SUMMARY == flow_get_mode(&dump_sink.flow)) {
+        dump_skipped_marker();
+    }
+
+    if (gui_enabled) {
+        if (flow_tick(&gui_sink.flow, now)) {
+            sink_changed(&gui_sink);
+        }
+        if (FLOW_MODE_SUMMARY == flow_get_mode(&gui_sink.flow)) {
+            snprintf(text, sizeof(text), "Summarising: %llu B/s, %llu bytes not charted",
+                     (unsigned long long)gui_sink.flow.last_rate, (unsigned long long)gui_sink.flow.skipped_total);
+            gui_set_status_text(text);
+        }
+    }
+
+    timer_wheel_schedule(&wheel, timer, APP_FLOW_TICK_MS * NSEC_PER_MSEC, on_flow_timer, NULL);
+}
+
+static void dump_bytes_as_hex(const uint8_t *data, size_t len)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    char line[APP_DUMP_LINE_BYTES * 3 + 1];
+    size_t used = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        line[used++] = hex[data[i] >> 4];
+        line[used++] = hex[data[i] & 0x0F];
+        line[used++] = ' ';
+
+        if (++dump_column == APP_DUMP_LINE_BYTES) {
+            line[used] = '\0';
+            log_info("%s\n", line);
+            used = 0;
+            dump_column = 0;
+        }
+    }
+
+    /* The rest of the line carries on from the next bytes' message */
+    if (used > 0) {
+        line[used] = '\0';
+        log_info("%s", line);
+    }
 }
\ No newline at end of file
@@ -41,6 +41,11 @@ extern "C" {
  * Definitions
  *****************************************************************************/
 
+/* 1 in the serial_tool_headless target: no GUI is compiled in, the app always runs headless */
+#ifndef APP_HEADLESS
+#define APP_HEADLESS 0
+#endif
+
 /****************************************************************************
  * Structs, Unions, Enums, & Typedefs
  *****************************************************************************/
@@ -49,8 +54,15 @@ extern "C" {
  * Function Prototypes
  *****************************************************************************/
 
-
-bool app_init(const char *serial_port_path);
+/**
+ * @brief Open the port and set up everything the main loop runs.
+ *
+ * @param serial_port_path the serial port, e.g. /dev/ttyUSB0
+ * @param headless true to run without the GUI: no window, no LEDs and no
+ *        frames, the serial, decode, capture and metrics pipeline only
+ * @return true if successful
+ */
+bool app_init(const char *serial_port_path, bool headless);
 
 void app_deinit(void);
 
@@ -0,0 +1,385 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        app_perf.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+/* accept4() */
+#define _GNU_SOURCE
+
+#include "app_bridge.h"
+#include "app_cli.h"
+#include "app_listen.h"
+#include "../reactor/reactor.h"
+#include "../serial/serial.h"
+#include "../stats/metrics.h"
+#include "../log/log.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Most bytes read from a client at once for the serial TX buffer */
+#define BRIDGE_READ_SIZE    1024U
+
+/**
+ * @brief A connected client: the RX chunks it hasn't been sent yet.
+ */
+typedef struct client_t {
+    int fd;                                     /**< -1 when the slot is free */
+    chunk_t *queue[APP_BRIDGE_CLIENT_QUEUE];    /**< References to the chunks still to send */
+    uint32_t head;                              /**< Oldest chunk in the queue */
+    uint32_t count;                             /**< Chunks in the queue */
+    size_t offset;                              /**< Bytes of the oldest chunk already sent */
+    bool blocked;                               /**< Socket buffer full, waiting to be writable */
+    uint64_t sent;                              /**< RX bytes sent to the client */
+    uint64_t received;                          /**< Bytes from the client loaded into the TX buffer */
+} client_t;
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+static cli_status_t bridge_func(int argc, char **argv);
+static void close_listener(void);
+static void close_client(client_t *client);
+static void flush_client(client_t *client);
+static void read_client(client_t *client);
+static void on_listen(int fd, uint32_t events, void *ctx);
+static void on_client(int fd, uint32_t events, void *ctx);
+
+/**
+ * @brief Runs before the loop sleeps: one gathered write per client for
+ *        everything queued since, and TX reads paused while the buffer is full.
+ */
+static int on_prepare(void *ctx);
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+static const cmd_t bridge_cmd = {
+    .cmd = "bridge",
+    .func = bridge_func,
+    .help_text =
+        "bridge                        - Show the connected bridge clients\n"
+        "  bridge listen <port|path>     - Share the port on 127.0.0.1:<port> or a Unix socket\n"
+        "  bridge off                    - Disconnect the clients and stop sharing",
+    .min_args = 0,
+    .max_args = 3
+};
+
+static app_listener_t listener = APP_LISTENER_INIT;
+static client_t clients[APP_BRIDGE_MAX_CLIENTS];
+static uint32_t client_count = 0;
+
+static metric_t *clients_metric;
+static metric_t *rx_bytes_metric;
+static metric_t *tx_bytes_metric;
+static metric_t *slow_clients_metric;
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+bool app_bridge_init(void)
+{
+    for (uint32_t i = 0; i < APP_BRIDGE_MAX_CLIENTS; i++) {
+        clients[i].fd = -1;
+        clients[i].count = 0;
+    }
+
+    clients_metric = metrics_gauge("bridge_clients", "Clients connected to the bridge");
+    rx_bytes_metric = metrics_counter("bridge_rx_bytes_total", "RX bytes sent to bridge clients");
+    tx_bytes_metric = metrics_counter("bridge_tx_bytes_total", "Bytes from bridge clients loaded into the TX buffer");
+    slow_clients_metric = metrics_counter("bridge_slow_clients_total", "Bridge clients disconnected for falling behind");
+
+    return reactor_add_prepare(on_prepare, NULL) && app_cli_register(&bridge_cmd);
+}
+
+void app_bridge_deinit(void)
+{
+    close_listener();
+}
+
+bool app_bridge_listen(const char *where)
+{
+    close_listener();
+
+    if (!app_listen_open(&listener, where, "bridge", APP_BRIDGE_MAX_CLIENTS, on_listen, NULL)) {
+        return false;
+    }
+
+    log_info("[bridge] Sharing the port on %s%s\n", app_listen_is_tcp(&listener) ? "127.0.0.1:" : "", where);
+    return true;
+}
+
+void app_bridge_write(chunk_t *chunk)
+{
+    if (0 == client_count) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < APP_BRIDGE_MAX_CLIENTS; i++) {
+        client_t *client = &clients[i];
+
+        if (client->fd < 0) {
+            continue;
+        }
+
+        /* Holding up the pipeline, or skipping bytes the client would never
+         * know it missed, are both worse than cutting it off */
+        if (APP_BRIDGE_CLIENT_QUEUE == client->count) {
+            log_info("[bridge] client %d fell behind, disconnecting\n", client->fd);
+            metrics_add(slow_clients_metric, 1);
+            close_client(client);
+            continue;
+        }
+
+        chunk_ref(chunk);
+        client->queue[(client->head + client->count) % APP_BRIDGE_CLIENT_QUEUE] = chunk;
+        client->count++;
+    }
+}
+
+static cli_status_t bridge_func(int argc, char **argv)
+{
+    if (argc == 1) {
+        if (!app_listen_is_open(&listener)) {
+            log_print("[bridge] Not listening\n");
+            return CLI_OK;
+        }
+
+        log_print("[bridge] %u of %u clients\n", client_count, APP_BRIDGE_MAX_CLIENTS);
+        for (uint32_t i = 0; i < APP_BRIDGE_MAX_CLIENTS; i++) {
+            if (clients[i].fd >= 0) {
+                log_print("[bridge] client %d: %llu bytes out, %llu bytes in, %u chunks queued\n", clients[i].fd,
+                         (unsigned long long)clients[i].sent, (unsigned long long)clients[i].received,
+                         clients[i].count);
+            }
+        }
+        return CLI_OK;
+    }
+
+    if ((0 == strcmp(argv[1], "listen")) && (argc == 3)) {
+        return app_bridge_listen(argv[2]) ? CLI_OK : CLI_E_IO;
+    }
+
+    if ((0 == strcmp(argv[1], "off")) && (argc == 2)) {
+        app_bridge_deinit();
+        return CLI_OK;
+    }
+
+    return CLI_E_INVALID_ARGS;
+}
+
+static void close_listener(void)
+{
+    for (uint32_t i = 0; i < APP_BRIDGE_MAX_CLIENTS; i++) {
+        close_client(&clients[i]);
+    }
+
+    app_listen_close(&listener);
+}
+
+static void close_client(client_t *client)
+{
+    if (client->fd < 0) {
+        return;
+    }
+
+    while (client->count > 0) {
+        chunk_release(client->queue[client->head]);
+        client->head = (client->head + 1) % APP_BRIDGE_CLIENT_QUEUE;
+        client->count--;
+    }
+
+    reactor_remove(client->fd);
+    close(client->fd);
+    client->fd = -1;
+    client_count--;
+    metrics_set(clients_metric, client_count);
+}
+
+static void flush_client(client_t *client)
+{
+    struct iovec iov[APP_BRIDGE_CLIENT_QUEUE];
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = client->count };
+
+    for (uint32_t i = 0; i < client->count; i++) {
+        chunk_t *chunk = client->queue[(client->head + i) % APP_BRIDGE_CLIENT_QUEUE];
+        size_t skip = (0 == i) ? client->offset : 0;
+        iov[i].iov_base = chunk->data + skip;
+        iov[i].iov_len = chunk->len - skip;
+    }
+
+    /* writev() with MSG_NOSIGNAL: a client that went away mustn't raise SIGPIPE */
+    ssize_t n = sendmsg(client->fd, &msg, MSG_NOSIGNAL);
+    if (n < 0) {
+        if ((errno == EAGAIN) || (errno == EINTR)) {
+            client->blocked = true;
+        }
+        else {
+            close_client(client);
+        }
+        return;
+    }
+
+    client->sent += (uint64_t)n;
+    metrics_add(rx_bytes_metric, (uint64_t)n);
+
+    /* Release what went out completely, remember how far into the next one it got */
+    size_t left = (size_t)n;
+    while ((client->count > 0) && (left >= client->queue[client->head]->len - client->offset)) {
+        left -= client->queue[client->head]->len - client->offset;
+        chunk_release(client->queue[client->head]);
+        client->head = (client->head + 1) % APP_BRIDGE_CLIENT_QUEUE;
+        client->count--;
+        client->offset = 0;
+    }
+    client->offset += left;
+
+    /* A short write means the socket buffer is full */
+    client->blocked = (client->count > 0);
+}
+
+static void read_client(client_t *client)
+{
+    uint8_t buf[BRIDGE_READ_SIZE];
+
+    /* Only take what fits, the rest waits in the socket buffer */
+    size_t space = serial_tx_buf_space();
+    if (0 == space) {
+        return;
+    }
+
+    ssize_t n = read(client->fd, buf, (space < sizeof(buf)) ? space : sizeof(buf));
+    if (n == 0) {
+        log_info("[bridge] client %d disconnected\n", client->fd);
+        close_client(client);
+        return;
+    }
+    if (n < 0) {
+        if ((errno != EAGAIN) && (errno != EINTR)) {
+            close_client(client);
+        }
+        return;
+    }
+
+    size_t loaded = serial_tx_write(buf, (size_t)n);
+    client->received += loaded;
+    metrics_add(tx_bytes_metric, loaded);
+}
+
+static void on_listen(int fd, uint32_t events, void *ctx)
+{
+    (void)events;
+    (void)ctx;
+
+    int client_fd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (client_fd < 0) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < APP_BRIDGE_MAX_CLIENTS; i++) {
+        if (clients[i].fd < 0) {
+            if (reactor_add_fd(client_fd, REACTOR_EV_READ, on_client, &clients[i])) {
+                clients[i].fd = client_fd;
+                clients[i].head = 0;
+                clients[i].count = 0;
+                clients[i].offset = 0;
+                clients[i].blocked = false;
+                clients[i].sent = 0;
+                clients[i].received = 0;
+                client_count++;
+                metrics_set(clients_metric, client_count);
+                log_info("[bridge] client %d connected\n", client_fd);
+                return;
+            }
+            break;
+        }
+    }
+
+    log_info("[bridge] no room for another client\n");
+    close(client_fd);
+}
+
+static void on_client(int fd, uint32_t events, void *ctx)
+{
+    client_t *client = ctx;
+    (void)fd;
+
+    if (events & REACTOR_EV_ERROR) {
+        close_client(client);
+        return;
+    }
+
+    if (events & REACTOR_EV_WRITE) {
+        flush_client(client);
+    }
+
+    if ((events & REACTOR_EV_READ) && (client->fd >= 0)) {
+        read_client(client);
+    }
+}
+
+static int on_prepare(void *ctx)
+{
+    (void)ctx;
+
+    if (0 == client_count) {
+        return -1;
+    }
+
+    bool tx_space = (serial_tx_buf_space() > 0);
+
+    for (uint32_t i = 0; i < APP_BRIDGE_MAX_CLIENTS; i++) {
+        client_t *client = &clients[i];
+
+        if (client->fd < 0) {
+            continue;
+        }
+
+        /* Everything queued since the last wait goes out in one call. A
+         * blocked client is flushed when the reactor says it's writable. */
+        if ((client->count > 0) && !client->blocked) {
+            flush_client(client);
+            if (client->fd < 0) {
+                continue;
+            }
+        }
+
+        reactor_set_events(client->fd, (tx_space ? REACTOR_EV_READ : 0U) | (client->blocked ? REACTOR_EV_WRITE : 0U));
+    }
+
+    return -1;
+}
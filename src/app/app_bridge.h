@@ -0,0 +1,95 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        app_perf.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#ifndef APP_BRIDGE_H_
+#define APP_BRIDGE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../buffer/chunk_pool.h"
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Clients connected at the same time, more are refused */
+#define APP_BRIDGE_MAX_CLIENTS  16U
+
+/* RX chunks waiting for one client. A client that falls further behind is
+ * disconnected, so all clients together never pin more than half the
+ * serial RX pool. */
+#define APP_BRIDGE_CLIENT_QUEUE 8U
+
+/****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Register the bridge command, its metrics and the batched client writes.
+ *
+ * @return true if successful
+ */
+bool app_bridge_init(void);
+
+/**
+ * @brief Disconnect every client and close the socket.
+ *
+ * The clients hold references to serial RX chunks, call this before serial_close().
+ */
+void app_bridge_deinit(void);
+
+/**
+ * @brief Share the serial port over a socket.
+ *
+ * Every client gets a copy of the RX stream and anything a client writes is
+ * sent out of the port.
+ *
+ * @param where a port number (listens on 127.0.0.1) or a Unix socket path
+ * @return true if listening
+ */
+bool app_bridge_listen(const char *where);
+
+/**
+ * @brief Queue a received chunk for every client.
+ *
+ * Each client takes its own reference, nothing is copied. The writes are
+ * batched and done before the main loop next sleeps.
+ *
+ * @param chunk received bytes, the caller keeps its own reference
+ */
+void app_bridge_write(chunk_t *chunk);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* APP_BRIDGE_H_ */
@@ -27,6 +27,9 @@
  * 
  */
 
+/* memrchr() */
+#define _GNU_SOURCE
+
 #include "app_cli.h"
 
 #include <stdio.h>
@@ -34,17 +37,30 @@
 #include <string.h>
 #include <stdarg.h>
 #include <pthread.h>
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/eventfd.h>
 
 #include "../cli/cli.h"
 #include "../time_funcs/time_funcs.h"
 #include "../buffer/ring_buf.h"
+#include "../reactor/reactor.h"
+#include "../log/log.h"
+#include "../trace/trace.h"
+#include "../stats/profiler.h"
+#include "../stats/metrics.h"
 
 
 /****************************************************************************
  * Definitions
  *****************************************************************************/
 
-#define CLI_INPUT_BUF_LENGTH (1024U)
+/* Longest command line */
+#define CLI_LINE_LENGTH (1024U)
+
+/* Complete lines waiting for the main loop, several pasted lines fit */
+#define CLI_INPUT_BUF_LENGTH (4096U)
 
 /****************************************************************************
  * Variables
@@ -56,37 +72,57 @@ static pthread_mutex_t lock;
 static ring_buf_t cli_input_buf;
 static char cli_input_data[CLI_INPUT_BUF_LENGTH];
 
-static uint8_t cli_buffer[CLI_INPUT_BUF_LENGTH] = {0};
+static uint8_t cli_buffer[CLI_LINE_LENGTH] = {0};
+
+/* Lines taken off the queue in one go, only touched by the main loop */
+static char cli_lines[CLI_INPUT_BUF_LENGTH];
+
+/* Signalled when the main loop has made room in the queue */
+static pthread_cond_t input_space;
+static bool input_thread_running = false;
+static bool input_stop = false;     /* Protected by lock */
+
+/* Written by app_cli_deinit to stop the input thread */
+static int input_stop_fd = -1;
 
 static cli_t cli;
 static cli_status_t rslt = CLI_OK;
 
 static bool *keep_running = NULL;
 
+/* Wakes the main loop when the input thread has queued lines */
+static int input_wakeup_fd = -1;
+
+/* Updated from the input thread, the counter is atomic */
+static metric_t *dropped_lines_metric = NULL;
+
 /****************************************************************************
  * Prototypes
  *****************************************************************************/
 
-static bool put_cli_buf_data(char c);
-static bool pop_cli_buf_data(char *c);
-static bool cli_buf_is_empty(void);
+static bool publish_lines(const char *lines, size_t len);
+static size_t take_lines(char *lines, size_t max);
 
 static void user_println(const char * format, ...);
 
 static void* get_input(void* arg);
+static void on_input_wakeup(int fd, uint32_t events, void *ctx);
 
 static cli_status_t help_func(int argc, char **argv);
 static cli_status_t exit_func(int argc, char **argv);
+static cli_status_t log_func(int argc, char **argv);
+static cli_status_t trace_func(int argc, char **argv);
 
-
-cmd_t cmd_tbl[8] = {
+cmd_t cmd_tbl[] = {
     {
         .cmd = "help",
-        .func = help_func
+        .func = help_func,
+        .help_text = "help - List the available commands"
     },
     {
         .cmd = "quit",
-        .func = exit_func
+        .func = exit_func,
+        .help_text = "quit | exit | stop | q - Exit the program"
     },
     {
         .cmd = "exit",
@@ -100,7 +136,20 @@ cmd_t cmd_tbl[8] = {
         .cmd = "q",
         .func = exit_func
     },
-
+    {
+        .cmd = "log",
+        .func = log_func,
+        .help_text = "log level <error|warn|info|debug> | log stats - Set the log level or show logger statistics",
+        .min_args = 1,
+        .max_args = 2
+    },
+    {
+        .cmd = "trace",
+        .func = trace_func,
+        .help_text = "trace start | stop | clear | status | dump <file.json> - Record trace events, dump them for chrome://tracing or Perfetto",
+        .min_args = 1,
+        .max_args = 2
+    },
 };
 
 /****************************************************************************
@@ -112,13 +161,13 @@ bool app_cli_init(bool *shutdown_flag)
     keep_running = shutdown_flag;
 
     if(NULL == keep_running){
-        printf("The shutdown flag cannot be NULL\n");
+        log_error("The shutdown flag cannot be NULL\n");
         return false;
     }
 
     if(*keep_running == false)
     {
-        printf("Initialize the shutdown_flag to true or the keyboard input won't run\n");
+        log_error("Initialize the shutdown_flag to true or the keyboard input won't run\n");
         return false;
     }
 
@@ -129,90 +178,283 @@ bool app_cli_init(bool *shutdown_flag)
     /* initialize the cli api */
     if((rslt = cli_init(&cli, cli_buffer, sizeof(cli_buffer))) != CLI_OK)
     {
-        printf("CLI: Failed to initialise");
+        log_error("CLI: Failed to initialise\n");
         return false;
     }
 
     /* Initialize a buffer to hold data from the keyboard input thread */
     ring_buf_init(&cli_input_buf, cli_input_data, CLI_INPUT_BUF_LENGTH, sizeof(char));
 
+    dropped_lines_metric = metrics_counter("cli_dropped_lines_total", "CLI input lines too long to run");
+
+    /* The input thread signals this when there is something to process */
+    input_wakeup_fd = reactor_add_wakeup(on_input_wakeup, NULL);
+    if (input_wakeup_fd < 0) {
+        log_error("CLI: can't create the input wakeup\n");
+        return false;
+    }
+
+    input_stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (input_stop_fd < 0) {
+        log_error("CLI: can't create the input stop event\n");
+        return false;
+    }
+
     /* create a mutex for shared keyboard input data between threads */
     if (pthread_mutex_init(&lock, NULL) != 0) { 
-        printf("\n mutex init has failed\n"); 
+        log_error("\n mutex init has failed\n"); 
         return false; 
     } 
+    pthread_cond_init(&input_space, NULL);
 
     /* Create the keyboard input thread */
     int error = pthread_create(&cli_input_thread, NULL, &get_input, NULL); 
     if (error != 0) 
     {
-        printf("\nThread can't be created :[%s]", strerror(error)); 
+        log_error("\nThread can't be created :[%s]", strerror(error)); 
         return false;
     }
-
-    /* detach the cli input thread */
-    pthread_detach(cli_input_thread);
+    input_thread_running = true;
 
     return true;
 }
 
 void app_cli_deinit()
 {
+    uint64_t one = 1;
+
+    /* Wake the input thread out of poll() or a full queue and wait for it */
+    if (input_thread_running) {
+        if (write(input_stop_fd, &one, sizeof(one)) < 0) {
+            log_error("CLI: can't stop the input thread\n");
+        }
+        pthread_mutex_lock(&lock);
+        input_stop = true;
+        pthread_cond_signal(&input_space);
+        pthread_mutex_unlock(&lock);
+        pthread_join(cli_input_thread, NULL);
+        input_thread_running = false;
+    }
+
+    if (input_stop_fd >= 0) {
+        close(input_stop_fd);
+        input_stop_fd = -1;
+    }
+
+    pthread_cond_destroy(&input_space);
     pthread_mutex_destroy(&lock); 
 }
 
-void app_cli_process()
+bool app_cli_register(const cmd_t *cmd)
 {
-    char c;
+    cli_status_t status = cli_register(&cli, cmd);
 
-    if(cli_buf_is_empty()){
-        return;
+    if (CLI_OK != status) {
+        log_error("CLI: can't register \"%s\" (%d)\n", (NULL == cmd) ? "" : cmd->cmd, (int)status);
+        return false;
     }
 
-    do
-    {
-        if(pop_cli_buf_data(&c))
-        {
-            cli_put(&cli, c);
-            cli_process(&cli);
+    return true;
+}
+
+const cmd_t *app_cli_resolve(const char *name)
+{
+    return cli_resolve(&cli, name);
+}
+
+cli_status_t app_cli_call(const cmd_t *cmd, int argc, char **argv)
+{
+    return cli_call(&cli, cmd, argc, argv);
+}
+
+void app_cli_process()
+{
+    TRACE_BEGIN("app_cli_process");
+
+    uint64_t start = now_cycles();
+    size_t len = take_lines(cli_lines, sizeof(cli_lines));
+    char *line = cli_lines;
+    char *end = cli_lines + len;
+
+    /* Only whole lines are queued, each ends in a newline */
+    while (line < end) {
+        char *nl = memchr(line, '\n', (size_t)(end - line));
+        if (NULL == nl) {
+            break;
         }
-    } while (!cli_buf_is_empty());
+        *nl = '\0';
+        cli_exec(&cli, line);
+        line = nl + 1;
+    }
+
+    if (len > 0) {
+        profiler_record(PROF_STAGE_CLI, now_cycles() - start, len);
+    }
+    TRACE_END("app_cli_process");
 }
 
 static void* get_input(void* arg) 
 { 
-    char c;
+    static char pending[CLI_LINE_LENGTH];
+    size_t pending_len = 0;
+    bool discarding = false;
     (void)arg;
 
-    do
+    struct pollfd fds[2] = {
+        { .fd = STDIN_FILENO, .events = POLLIN },
+        { .fd = input_stop_fd, .events = POLLIN },
+    };
+
+    while (true == *keep_running)
     {
-        /* wait for a character from stdin */
-        c = fgetc(stdin);
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[1].revents != 0) {
+            break;
+        }
 
-        /* Got the char. Put it in the buffer */
-        put_cli_buf_data(c);
+        /* Read whatever is there: one line from a terminal, many when pasted or piped */
+        ssize_t n = read(STDIN_FILENO, pending + pending_len, sizeof(pending) - pending_len);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+            break;
+        }
+        if (n == 0) {
+            /* End of input: run what is left as the last line. There is
+             * always room, a full buffer is flushed or dropped below. */
+            if ((pending_len > 0) && !discarding) {
+                pending[pending_len++] = '\n';
+                publish_lines(pending, pending_len);
+            }
+            break;
+        }
+        pending_len += (size_t)n;
+
+        /* Hand over everything up to the last newline in one go */
+        char *last_nl = memrchr(pending, '\n', pending_len);
+        if (NULL == last_nl) {
+            if (pending_len == sizeof(pending)) {
+                /* No newline in a whole line's worth, drop it up to the next newline */
+                if (!discarding) {
+                    log_warn("CLI: line longer than %u characters ignored\n", CLI_LINE_LENGTH);
+                    metrics_add(dropped_lines_metric, 1);
+                }
+                discarding = true;
+                pending_len = 0;
+            }
+            continue;
+        }
 
-    } while (true == *keep_running);
+        size_t lines_len = (size_t)(last_nl - pending) + 1;
+        char *lines = pending;
+        if (discarding) {
+            /* The first line is the end of the one being dropped */
+            lines = (char *)memchr(pending, '\n', lines_len) + 1;
+            discarding = false;
+        }
+        if ((lines < pending + lines_len) && !publish_lines(lines, (size_t)(pending + lines_len - lines))) {
+            break;
+        }
+
+        pending_len -= lines_len;
+        memmove(pending, pending + lines_len, pending_len);
+    }
 
     return NULL; 
 } 
 
+static void on_input_wakeup(int fd, uint32_t events, void *ctx)
+{
+    (void)fd;
+    (void)events;
+    (void)ctx;
+
+    app_cli_process();
+}
+
 static void user_println(const char * format, ...)
 {
     va_list args;
     va_start (args, format);
-    vprintf (format, args);
+    log_vprint(format, args);
     va_end (args);
 }
 
 static cli_status_t help_func(int argc, char **argv)
 {
-    cli_status_t ok = CLI_OK;
+    const cmd_t *cmd;
     (void)argc;
     (void)argv;
+
     cli.println("[cli] CLI HELP. Available commands:\n");
-    cli.println("  quit, exit, stop, q - Exit the Program\n"); 
-    return ok;
+
+    /* Aliases have no help text of their own */
+    for (size_t i = 0; (cmd = cli_get_cmd(&cli, i)) != NULL; i++) {
+        if (NULL != cmd->help_text) {
+            cli.println("  %s\n", cmd->help_text);
+        }
+    }
+
+    return CLI_OK;
+}
+
+static cli_status_t log_func(int argc, char **argv)
+{
+    static const char *const level_names[LOG_LEVEL_MAX] = {"error", "warn", "info", "debug"};
+
+    if (0 == strcmp(argv[1], "stats")) {
+        cli.println("[log] level %s, %llu messages dropped\n",
+                    level_names[log_get_level()], (unsigned long long)log_get_dropped());
+        return CLI_OK;
+    }
+
+    if ((0 == strcmp(argv[1], "level")) && (argc == 3)) {
+        for (int level = 0; level < LOG_LEVEL_MAX; level++) {
+            if (0 == strcmp(argv[2], level_names[level])) {
+                log_set_level((log_level_t)level);
+                return CLI_OK;
+            }
+        }
+    }
+
+    log_error("[log] usage: log level <error|warn|info|debug> | log stats\n");
+    return CLI_E_INVALID_ARGS;
+}
+
+static cli_status_t trace_func(int argc, char **argv)
+{
+    if (!TRACE_ENABLED) {
+        cli.println("[trace] Trace points were compiled out (TRACE_ENABLED=0)\n");
+    }
+
+    if (0 == strcmp(argv[1], "start")) {
+        trace_start();
+    }
+    else if (0 == strcmp(argv[1], "stop")) {
+        trace_stop();
+    }
+    else if (0 == strcmp(argv[1], "clear")) {
+        trace_clear();
+    }
+    else if (0 == strcmp(argv[1], "status")) {
+        cli.println("[trace] %s, %zu events recorded\n",
+                    trace_is_running() ? "recording" : "stopped", trace_get_count());
+    }
+    else if ((0 == strcmp(argv[1], "dump")) && (argc == 3)) {
+        if (!trace_dump_chrome(argv[2])) {
+            return CLI_E_IO;
+        }
+        cli.println("[trace] Wrote %s\n", argv[2]);
+    }
+    else {
+        return CLI_E_INVALID_ARGS;
+    }
+
+    return CLI_OK;
 }
 
 static cli_status_t exit_func(int argc, char **argv)
@@ -228,26 +470,44 @@ static cli_status_t exit_func(int argc, char **argv)
     return ok;
 }
 
-static bool put_cli_buf_data(char c)
+/**
+ * @brief Queue complete lines for the main loop with one lock and one wakeup.
+ *        Waits while the queue is too full, returns false if stopped meanwhile.
+ */
+static bool publish_lines(const char *lines, size_t len)
 {
-    bool put_success;
-    pthread_mutex_lock(&lock); 
-    put_success = ring_buf_push(&cli_input_buf, &c);
-    pthread_mutex_unlock(&lock);  
-    return put_success;  
-}
+    bool ok;
 
-static bool pop_cli_buf_data(char *c)
-{
-    bool pop_success;
-    if(c == NULL) return false;
-    pthread_mutex_lock(&lock); 
-    pop_success = ring_buf_pop(&cli_input_buf, c);
-    pthread_mutex_unlock(&lock);  
-    return pop_success;
+    pthread_mutex_lock(&lock);
+    while ((ring_buf_space(&cli_input_buf) < len) && !input_stop) {
+        pthread_cond_wait(&input_space, &lock);
+    }
+    ok = !input_stop;
+    if (ok) {
+        ring_buf_push_n(&cli_input_buf, lines, len);
+    }
+    pthread_mutex_unlock(&lock);
+
+    if (ok) {
+        reactor_wakeup(input_wakeup_fd);
+    }
+    return ok;
 }
 
-static bool cli_buf_is_empty(void)
+/**
+ * @brief Take all queued lines. Only whole lines are ever queued and max is
+ *        the queue size, so no line is split.
+ */
+static size_t take_lines(char *lines, size_t max)
 {
-    return ring_buf_is_empty(&cli_input_buf);
-}
\ No newline at end of file
+    size_t len;
+
+    pthread_mutex_lock(&lock);
+    len = ring_buf_pop_n(&cli_input_buf, lines, max);
+    if (len > 0) {
+        pthread_cond_signal(&input_space);
+    }
+    pthread_mutex_unlock(&lock);
+
+    return len;
+}
@@ -36,6 +36,7 @@ extern "C" {
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "../cli/cli_defs.h"
 
 /****************************************************************************
  * Definitions
@@ -53,6 +54,33 @@ bool app_cli_init(bool *shutdown_flag);
 void app_cli_deinit();
 void app_cli_process();
 
+/**
+ * @brief Adds a command to the CLI. Modules register their own commands,
+ *        this can be called before app_cli_init.
+ *
+ * @param cmd The command, must stay valid for the life of the program.
+ * @return true if registered
+ */
+bool app_cli_register(const cmd_t *cmd);
+
+/**
+ * @brief Looks a command up by name or unambiguous prefix, reporting errors.
+ *
+ * @param name command name
+ * @return the command, NULL if there is no single match
+ */
+const cmd_t *app_cli_resolve(const char *name);
+
+/**
+ * @brief Runs a command that was looked up with app_cli_resolve.
+ *
+ * @param cmd the command
+ * @param argc number of arguments, including the command name
+ * @param argv the arguments
+ * @return cli_status_t the command's result
+ */
+cli_status_t app_cli_call(const cmd_t *cmd, int argc, char **argv);
+
 #ifdef __cplusplus
 }
 #endif
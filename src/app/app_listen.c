@@ -0,0 +1,168 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        app_perf.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#include "app_listen.h"
+#include "../cli/cli_args.h"
+#include "../log/log.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+static int bind_tcp(const char *where, const char *who, uint64_t port);
+static int bind_unix(app_listener_t *listener, const char *where, const char *who);
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+bool app_listen_open(app_listener_t *listener, const char *where, const char *who, int backlog,
+                     reactor_cb_t cb, void *ctx)
+{
+    uint64_t port;
+    int fd;
+
+    listener->addr.sun_path[0] = '\0';
+
+    if (cli_parse_u64(where, &port)) {
+        fd = bind_tcp(where, who, port);
+    }
+    else {
+        fd = bind_unix(listener, where, who);
+    }
+    if (fd < 0) {
+        return false;
+    }
+
+    if ((listen(fd, backlog) < 0) || !reactor_add_fd(fd, REACTOR_EV_READ, cb, ctx)) {
+        log_error("%s: can't listen on %s\n", who, where);
+        close(fd);
+        if ('\0' != listener->addr.sun_path[0]) {
+            unlink(listener->addr.sun_path);
+            listener->addr.sun_path[0] = '\0';
+        }
+        return false;
+    }
+
+    listener->fd = fd;
+    return true;
+}
+
+void app_listen_close(app_listener_t *listener)
+{
+    if (listener->fd >= 0) {
+        reactor_remove(listener->fd);
+        close(listener->fd);
+        listener->fd = -1;
+    }
+
+    if ('\0' != listener->addr.sun_path[0]) {
+        unlink(listener->addr.sun_path);
+        listener->addr.sun_path[0] = '\0';
+    }
+}
+
+bool app_listen_is_open(const app_listener_t *listener)
+{
+    return (listener->fd >= 0);
+}
+
+bool app_listen_is_tcp(const app_listener_t *listener)
+{
+    return ('\0' == listener->addr.sun_path[0]);
+}
+
+static int bind_tcp(const char *where, const char *who, uint64_t port)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons((uint16_t)port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    int one = 1;
+
+    if ((0 == port) || (port > 65535)) {
+        log_error("%s: bad port %s\n", who, where);
+        return -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        log_error("%s: socket failed: %s\n", who, strerror(errno));
+        return -1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        log_error("%s: can't bind 127.0.0.1:%s: %s\n", who, where, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int bind_unix(app_listener_t *listener, const char *where, const char *who)
+{
+    struct stat st;
+
+    if (strlen(where) >= sizeof(listener->addr.sun_path)) {
+        log_error("%s: socket path too long\n", who);
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        log_error("%s: socket failed: %s\n", who, strerror(errno));
+        return -1;
+    }
+
+    memset(&listener->addr, 0, sizeof(listener->addr));
+    listener->addr.sun_family = AF_UNIX;
+    strcpy(listener->addr.sun_path, where);
+
+    /* A socket left behind by an earlier run would make bind fail. Only a
+     * socket is removed, any other file at the path makes bind fail. */
+    if ((0 == lstat(where, &st)) && S_ISSOCK(st.st_mode)) {
+        unlink(where);
+    }
+    if (bind(fd, (struct sockaddr *)&listener->addr, sizeof(listener->addr)) < 0) {
+        log_error("%s: can't bind %s: %s\n", who, where, strerror(errno));
+        listener->addr.sun_path[0] = '\0';
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
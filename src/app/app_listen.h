@@ -0,0 +1,102 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        app_perf.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#ifndef APP_LISTEN_H_
+#define APP_LISTEN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/un.h>
+#include "../reactor/reactor.h"
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Initial value of an app_listener_t, not listening */
+#define APP_LISTENER_INIT { .fd = -1 }
+
+/****************************************************************************
+ * Structs, Unions, Enums, & Typedefs
+ *****************************************************************************/
+
+/**
+ * @brief A listening socket on 127.0.0.1 or a Unix socket path, watched by the reactor.
+ */
+typedef struct app_listener_t {
+    int fd;                     /**< -1 when not listening */
+    struct sockaddr_un addr;    /**< Unix socket to unlink on close, empty path for TCP */
+} app_listener_t;
+
+/****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Listen on a port on 127.0.0.1 or on a Unix socket and watch for connections.
+ *
+ * A socket left at the path by an earlier run is replaced, any other kind
+ * of file is left alone and the call fails.
+ *
+ * @param listener closed listener
+ * @param where a port number or a Unix socket path
+ * @param who prefix of the error messages
+ * @param backlog connections waiting to be accepted
+ * @param cb called when a connection is waiting, accept4() it
+ * @param ctx passed to the callback
+ * @return true if listening
+ */
+bool app_listen_open(app_listener_t *listener, const char *where, const char *who, int backlog,
+                     reactor_cb_t cb, void *ctx);
+
+/**
+ * @brief Stop listening and remove the Unix socket. Does nothing if not listening.
+ *
+ * @param listener listener
+ */
+void app_listen_close(app_listener_t *listener);
+
+/**
+ * @brief Returns true while listening.
+ */
+bool app_listen_is_open(const app_listener_t *listener);
+
+/**
+ * @brief Returns true if listening on TCP rather than a Unix socket.
+ */
+bool app_listen_is_tcp(const app_listener_t *listener);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* APP_LISTEN_H_ */
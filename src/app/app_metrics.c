@@ -0,0 +1,399 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        app_perf.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+
+/* accept4() */
+#define _GNU_SOURCE
+
+#include "app_metrics.h"
+#include "app_cli.h"
+#include "app_listen.h"
+#include "../cli/cli_args.h"
+#include "../reactor/reactor.h"
+#include "../stats/metrics.h"
+#include "../time_funcs/time_funcs.h"
+#include "../log/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Scrapes served at the same time, more are refused */
+#define METRICS_MAX_CLIENTS     4U
+
+/* Longest file path accepted */
+#define METRICS_PATH_LENGTH     256U
+
+/* Space kept in front of the text for the HTTP header */
+#define METRICS_HEADER_ROOM     160U
+
+/* First guess at the size of the text, grows to fit */
+#define METRICS_TEXT_SIZE       8192U
+
+/**
+ * @brief One scrape: read the request, write the response, close.
+ */
+typedef struct client_t {
+    int fd;                 /**< -1 when the slot is free */
+    char *out;              /**< Buffer holding the response, NULL until the request arrived */
+    size_t len;             /**< End of the response in out */
+    size_t sent;            /**< Offset in out of the next byte to write */
+} client_t;
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+static cli_status_t metrics_func(int argc, char **argv);
+static void close_listener(void);
+static void close_client(client_t *client);
+static void on_listen(int fd, uint32_t events, void *ctx);
+static void on_client(int fd, uint32_t events, void *ctx);
+static char *format_text(size_t room, size_t *len);
+static char *build_response(size_t *start, size_t *len);
+static bool write_file(void);
+static void on_file_timer(tw_timer_t *timer, void *ctx);
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+static const cmd_t metrics_cmd = {
+    .cmd = "metrics",
+    .func = metrics_func,
+    .help_text =
+        "metrics                       - Print the metrics (Prometheus text format)\n"
+        "  metrics listen <port|path>    - Serve them over HTTP on 127.0.0.1:<port> or a Unix socket\n"
+        "  metrics file <path> [ms]      - Rewrite a file with them periodically\n"
+        "  metrics off                   - Stop serving and writing",
+    .min_args = 0,
+    .max_args = 3
+};
+
+static timer_wheel_t *timers = NULL;
+static tw_timer_t file_timer;
+
+static app_listener_t listener = APP_LISTENER_INIT;
+static client_t clients[METRICS_MAX_CLIENTS];
+
+/* Size the text needed last time, so it usually fits on the first pass */
+static size_t text_size = METRICS_TEXT_SIZE;
+
+static char file_path[METRICS_PATH_LENGTH];
+static uint32_t file_period_ms = 0;
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+bool app_metrics_init(timer_wheel_t *wheel)
+{
+    timers = wheel;
+    timer_wheel_timer_init(&file_timer);
+
+    for (uint32_t i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        clients[i].fd = -1;
+    }
+
+    metrics_register_fn("log_dropped_total", "Log messages dropped because a log ring was full",
+                        METRIC_COUNTER, log_get_dropped);
+
+    return app_cli_register(&metrics_cmd);
+}
+
+void app_metrics_deinit(void)
+{
+    close_listener();
+    app_metrics_set_file(NULL, 0);
+}
+
+bool app_metrics_listen(const char *where)
+{
+    close_listener();
+
+    if (!app_listen_open(&listener, where, "metrics", METRICS_MAX_CLIENTS, on_listen, NULL)) {
+        return false;
+    }
+
+    log_info("[metrics] Serving on %s%s\n", app_listen_is_tcp(&listener) ? "127.0.0.1:" : "", where);
+    return true;
+}
+
+bool app_metrics_set_file(const char *path, uint32_t period_ms)
+{
+    if (NULL != timers) {
+        timer_wheel_cancel(timers, &file_timer);
+    }
+    file_path[0] = '\0';
+
+    if (NULL == path) {
+        return true;
+    }
+
+    if ((NULL == timers) || (strlen(path) >= sizeof(file_path))) {
+        return false;
+    }
+
+    strcpy(file_path, path);
+    file_period_ms = (0 == period_ms) ? APP_METRICS_FILE_PERIOD_MS : period_ms;
+
+    /* Write it now so a bad path is reported straight away */
+    if (!write_file()) {
+        file_path[0] = '\0';
+        return false;
+    }
+
+    timer_wheel_schedule(timers, &file_timer, (uint64_t)file_period_ms * NSEC_PER_MSEC, on_file_timer, NULL);
+    return true;
+}
+
+static cli_status_t metrics_func(int argc, char **argv)
+{
+    uint64_t period_ms = 0;
+
+    if (argc == 1) {
+        size_t len;
+        char *text = format_text(0, &len);
+        if (NULL == text) {
+            return CLI_E_IO;
+        }
+
+        /* One message per line keeps each under the log record size */
+        char *line = text;
+        while ('\0' != *line) {
+            char *nl = strchr(line, '\n');
+            int n = (NULL != nl) ? (int)(nl - line) : (int)strlen(line);
+            log_print("%.*s\n", n, line);
+            line += n + ((NULL != nl) ? 1 : 0);
+        }
+        free(text);
+        return CLI_OK;
+    }
+
+    if ((0 == strcmp(argv[1], "listen")) && (argc == 3)) {
+        return app_metrics_listen(argv[2]) ? CLI_OK : CLI_E_IO;
+    }
+
+    if ((0 == strcmp(argv[1], "file")) && (argc >= 3)) {
+        if ((argc == 4) && (!cli_parse_u64(argv[3], &period_ms) || (0 == period_ms) || (period_ms > UINT32_MAX))) {
+            return CLI_E_INVALID_ARGS;
+        }
+        return app_metrics_set_file(argv[2], (uint32_t)period_ms) ? CLI_OK : CLI_E_IO;
+    }
+
+    if ((0 == strcmp(argv[1], "off")) && (argc == 2)) {
+        app_metrics_deinit();
+        return CLI_OK;
+    }
+
+    return CLI_E_INVALID_ARGS;
+}
+
+static void close_listener(void)
+{
+    for (uint32_t i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        close_client(&clients[i]);
+    }
+
+    app_listen_close(&listener);
+}
+
+static void close_client(client_t *client)
+{
+    if (client->fd >= 0) {
+        reactor_remove(client->fd);
+        close(client->fd);
+        client->fd = -1;
+    }
+    free(client->out);
+    client->out = NULL;
+}
+
+static void on_listen(int fd, uint32_t events, void *ctx)
+{
+    (void)events;
+    (void)ctx;
+
+    int client_fd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (client_fd < 0) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        if (clients[i].fd < 0) {
+            if (reactor_add_fd(client_fd, REACTOR_EV_READ, on_client, &clients[i])) {
+                clients[i].fd = client_fd;
+                clients[i].out = NULL;
+                clients[i].sent = 0;
+                return;
+            }
+            break;
+        }
+    }
+
+    /* Busy: the scraper retries on its next interval */
+    close(client_fd);
+}
+
+static void on_client(int fd, uint32_t events, void *ctx)
+{
+    client_t *client = ctx;
+    char request[1024];
+
+    if (events & REACTOR_EV_ERROR) {
+        close_client(client);
+        return;
+    }
+
+    if (NULL == client->out) {
+        /* Any request gets the metrics, only its arrival matters */
+        ssize_t n = read(fd, request, sizeof(request));
+        if ((n == 0) || ((n < 0) && (errno != EAGAIN) && (errno != EINTR))) {
+            close_client(client);
+            return;
+        }
+        if (n < 0) {
+            return;
+        }
+
+        client->out = build_response(&client->sent, &client->len);
+        if (NULL == client->out) {
+            close_client(client);
+            return;
+        }
+        reactor_set_events(fd, REACTOR_EV_WRITE);
+        return;
+    }
+
+    ssize_t n = write(fd, client->out + client->sent, client->len - client->sent);
+    if (n < 0) {
+        if ((errno != EAGAIN) && (errno != EINTR)) {
+            close_client(client);
+        }
+        return;
+    }
+
+    client->sent += (size_t)n;
+    if (client->sent >= client->len) {
+        close_client(client);
+    }
+}
+
+static char *format_text(size_t room, size_t *len)
+{
+    size_t size = text_size;
+    char *buf = NULL;
+
+    /* The values change while they are read (other threads, the logger), so
+     * sizing with one pass and formatting with another could cut the text.
+     * Only a pass that fit is used, a bigger buffer gets a fresh pass. */
+    for (;;) {
+        char *grown = realloc(buf, room + size);
+        if (NULL == grown) {
+            free(buf);
+            return NULL;
+        }
+        buf = grown;
+
+        *len = metrics_format(buf + room, size);
+        if (*len < size) {
+            text_size = size;
+            return buf;
+        }
+        size = *len + *len / 2;
+    }
+}
+
+static char *build_response(size_t *start, size_t *len)
+{
+    char header[METRICS_HEADER_ROOM];
+    size_t body_len;
+
+    char *out = format_text(METRICS_HEADER_ROOM, &body_len);
+    if (NULL == out) {
+        return NULL;
+    }
+
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.0 200 OK\r\n"
+                              "Content-Type: text/plain; version=0.0.4\r\n"
+                              "Content-Length: %zu\r\n"
+                              "Connection: close\r\n\r\n", body_len);
+
+    /* The header goes right in front of the text, the response starts there */
+    *start = METRICS_HEADER_ROOM - (size_t)header_len;
+    memcpy(out + *start, header, (size_t)header_len);
+    *len = METRICS_HEADER_ROOM + body_len;
+    return out;
+}
+
+static bool write_file(void)
+{
+    char tmp_path[METRICS_PATH_LENGTH + sizeof(".tmp")];
+    size_t len;
+    bool ok = false;
+
+    char *text = format_text(0, &len);
+    if (NULL == text) {
+        return false;
+    }
+
+    /* Write next to it and rename, so the file is always complete */
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", file_path);
+    FILE *out = fopen(tmp_path, "w");
+    if (NULL != out) {
+        ok = (fwrite(text, 1, len, out) == len);
+        ok = (0 == fclose(out)) && ok;
+        ok = ok && (0 == rename(tmp_path, file_path));
+        if (!ok) {
+            unlink(tmp_path);
+        }
+    }
+    free(text);
+
+    if (!ok) {
+        log_error("metrics: can't write %s: %s\n", file_path, strerror(errno));
+    }
+    return ok;
+}
+
+static void on_file_timer(tw_timer_t *timer, void *ctx)
+{
+    (void)ctx;
+
+    write_file();
+    timer_wheel_schedule(timers, timer, (uint64_t)file_period_ms * NSEC_PER_MSEC, on_file_timer, NULL);
+}
@@ -0,0 +1,88 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        app_perf.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+
+#ifndef APP_METRICS_H_
+#define APP_METRICS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../time_funcs/timer_wheel.h"
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* How often the metrics file is rewritten when no period is given */
+#define APP_METRICS_FILE_PERIOD_MS  10000U
+
+/****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Register the metrics command and the app wide metrics.
+ *
+ * @param wheel timer wheel the file writes are scheduled on
+ * @return true if successful
+ */
+bool app_metrics_init(timer_wheel_t *wheel);
+
+/**
+ * @brief Close the endpoint and stop writing the file.
+ */
+void app_metrics_deinit(void);
+
+/**
+ * @brief Serve the metrics over HTTP in the Prometheus text format.
+ *
+ * @param where a port number (listens on 127.0.0.1) or a Unix socket path
+ * @return true if listening
+ */
+bool app_metrics_listen(const char *where);
+
+/**
+ * @brief Rewrite a file with the metrics periodically (node_exporter textfile style).
+ *        The file is replaced atomically, readers never see a partial file.
+ *
+ * @param path file to write, NULL to stop
+ * @param period_ms time between writes, 0 for APP_METRICS_FILE_PERIOD_MS
+ * @return true if successful
+ */
+bool app_metrics_set_file(const char *path, uint32_t period_ms);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* APP_METRICS_H_ */
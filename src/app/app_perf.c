@@ -0,0 +1,191 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        app_perf.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+
+#include "app_perf.h"
+#include "app_cli.h"
+#include "../gui/gui.h"
+#include "../stats/profiler.h"
+#include "../time_funcs/time_funcs.h"
+#include "../log/log.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Length of one profiler window, the overlay is updated at the same rate (2 Hz) */
+#define PERF_WINDOW_MS      500U
+
+/* Room for the formatted table */
+#define PERF_TEXT_LENGTH    640U
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+static cli_status_t perf_func(int argc, char **argv);
+static cli_status_t fps_func(int argc, char **argv);
+static void on_window(tw_timer_t *timer, void *ctx);
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+static const cmd_t perf_cmd = {
+    .cmd = "perf",
+    .func = perf_func,
+    .help_text = "perf [overlay [on|off] | fps [n]] - Show time per second, max, p99 and throughput of each stage, or the GUI frame rate",
+    .min_args = 0,
+    .max_args = 2
+};
+
+static timer_wheel_t *timers = NULL;
+static tw_timer_t window_timer;
+
+static prof_report_t last_report;
+
+/* GUI frames in the last window, for the achieved frame rate */
+static uint64_t last_frames = 0;
+static double drawn_fps = 0.0;
+static bool overlay_on = false;
+static char text[PERF_TEXT_LENGTH];
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+bool app_perf_init(timer_wheel_t *wheel)
+{
+    timers = wheel;
+    timer_wheel_timer_init(&window_timer);
+
+    profiler_init(get_nanos());
+    timer_wheel_schedule(timers, &window_timer, PERF_WINDOW_MS * NSEC_PER_MSEC, on_window, NULL);
+
+    return app_cli_register(&perf_cmd);
+}
+
+void app_perf_deinit(void)
+{
+    if (NULL != timers) {
+        timer_wheel_cancel(timers, &window_timer);
+    }
+}
+
+void app_perf_set_overlay(bool show)
+{
+    overlay_on = show;
+
+    if (overlay_on) {
+        profiler_format(&last_report, text, sizeof(text));
+        gui_set_perf_text(text);
+    }
+    else {
+        gui_set_perf_text(NULL);
+    }
+}
+
+static cli_status_t perf_func(int argc, char **argv)
+{
+    if (argc == 1) {
+        profiler_format(&last_report, text, sizeof(text));
+        log_print("[perf] Last %u ms:\n%s\n", PERF_WINDOW_MS, text);
+        return CLI_OK;
+    }
+
+    if (0 == strcmp(argv[1], "fps")) {
+        return fps_func(argc, argv);
+    }
+
+    if (0 != strcmp(argv[1], "overlay")) {
+        return CLI_E_INVALID_ARGS;
+    }
+
+    if (argc == 2) {
+        app_perf_set_overlay(!overlay_on);
+    }
+    else if (0 == strcmp(argv[2], "on")) {
+        app_perf_set_overlay(true);
+    }
+    else if (0 == strcmp(argv[2], "off")) {
+        app_perf_set_overlay(false);
+    }
+    else {
+        return CLI_E_INVALID_ARGS;
+    }
+
+    return CLI_OK;
+}
+
+static cli_status_t fps_func(int argc, char **argv)
+{
+    gui_frame_stats_t stats;
+    char *end;
+
+    if (argc == 3) {
+        unsigned long fps = strtoul(argv[2], &end, 10);
+        if ((end == argv[2]) || (*end != '\0') || (fps < GUI_MIN_FPS) || (fps > GUI_MAX_FPS)) {
+            log_error("[perf] fps must be %u to %u\n", GUI_MIN_FPS, GUI_MAX_FPS);
+            return CLI_E_INVALID_ARGS;
+        }
+        gui_set_target_fps((uint32_t)fps);
+    }
+
+    gui_get_frame_stats(&stats);
+    log_print("[perf] GUI target %u fps, drawing %.1f fps; frames %llu, skipped %llu, merged %llu, stretched %llu\n",
+             gui_get_target_fps(), drawn_fps,
+             (unsigned long long)stats.frames, (unsigned long long)stats.skipped,
+             (unsigned long long)stats.merged, (unsigned long long)stats.stretched);
+
+    return CLI_OK;
+}
+
+static void on_window(tw_timer_t *timer, void *ctx)
+{
+    gui_frame_stats_t stats;
+    (void)ctx;
+
+    profiler_roll(get_nanos(), &last_report);
+
+    gui_get_frame_stats(&stats);
+    drawn_fps = (double)(stats.frames - last_frames) * 1000.0 / (double)PERF_WINDOW_MS;
+    last_frames = stats.frames;
+
+    /* Formatting and relabelling only cost anything while the overlay is shown */
+    if (overlay_on) {
+        profiler_format(&last_report, text, sizeof(text));
+        gui_set_perf_text(text);
+    }
+
+    timer_wheel_schedule(timers, timer, PERF_WINDOW_MS * NSEC_PER_MSEC, on_window, NULL);
+}
@@ -0,0 +1,69 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        app_perf.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+
+#ifndef APP_PERF_H_
+#define APP_PERF_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include "../time_funcs/timer_wheel.h"
+
+/****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Start the profiler windows and register the perf command with the CLI.
+ *
+ * @param wheel timer wheel the report timer is scheduled on
+ * @return true if successful
+ */
+bool app_perf_init(timer_wheel_t *wheel);
+
+/**
+ * @brief Stop the report timer.
+ */
+void app_perf_deinit(void);
+
+/**
+ * @brief Show or hide the profiler overlay.
+ *
+ * @param show true to show it
+ */
+void app_perf_set_overlay(bool show);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* APP_PERF_H_ */
@@ -0,0 +1,427 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2024 David Burke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        app_ping.c
+ * Created by  David Burke
+ * Version     1.0
+ * 
+ */
+
+#include "app_ping.h"
+#include "app_cli.h"
+#include "../cli/cli_args.h"
+#include "../gui/gui.h"
+#include "../serial/serial.h"
+#include "../time_funcs/time_funcs.h"
+#include "../log/log.h"
+#include "../stats/metrics.h"
+#include <stdio.h>
+#include <string.h>
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* How often the on-screen summary is refreshed */
+#define PING_GUI_PERIOD_MS 500U
+
+typedef enum ping_state_t {
+    PING_STATE_IDLE,        /**< Not running */
+    PING_STATE_WAITING,     /**< Probe sent, waiting for the response */
+    PING_STATE_GAP,         /**< Waiting for the next probe to be due */
+} ping_state_t;
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+static ping_cfg_t cfg;
+static ping_state_t state = PING_STATE_IDLE;
+static ping_stats_t stats;
+static histogram_t rtt_hist;
+
+static uint8_t seq = 0;
+static uint8_t expected[PING_MAX_FRAME];
+static size_t expected_len = 0;
+
+/* The last expected_len bytes received, as a ring */
+static uint8_t window[PING_MAX_FRAME];
+static size_t window_pos = 0;
+static size_t window_fill = 0;
+
+static uint64_t probe_last_index = 0;
+static uint64_t probe_sent_ns = 0;
+static uint64_t gui_received = UINT64_MAX;
+
+static timer_wheel_t *timers = NULL;
+static tw_timer_t probe_timer;      /* Next probe is due */
+static tw_timer_t timeout_timer;    /* Response is overdue */
+static tw_timer_t gui_timer;        /* Refresh the on-screen summary */
+
+static metric_t *responses_metric;
+static metric_t *timeouts_metric;
+static metric_t *rtt_metric;
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+static void send_probe(void);
+static void probe_done(void);
+static bool window_matches(void);
+static void on_probe_due(tw_timer_t *timer, void *ctx);
+static void on_timeout(tw_timer_t *timer, void *ctx);
+static void on_gui_update(tw_timer_t *timer, void *ctx);
+static cli_status_t ping_func(int argc, char **argv);
+
+static const cmd_t ping_cmd = {
+    .cmd = "ping",
+    .func = ping_func,
+    .help_text =
+        "ping <probe bytes> [opts]   - Measure round trip time to the device\n"
+        "    opts: -p <response bytes> (default: echo), -s <seq byte offset>, -i <interval ms>,\n"
+        "          -t <timeout ms>, -c <count> (default: until stopped)\n"
+        "  ping stats | stop | reset   - Show round trip times (p50/p99/p999) / stop / clear",
+    .min_args = 1,
+    .max_args = CLI_ARGS_ANY
+};
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+void app_ping_init(timer_wheel_t *wheel)
+{
+    timers = wheel;
+    timer_wheel_timer_init(&probe_timer);
+    timer_wheel_timer_init(&timeout_timer);
+    timer_wheel_timer_init(&gui_timer);
+    app_cli_register(&ping_cmd);
+
+    responses_metric = metrics_counter("ping_responses_total", "Ping response frames matched");
+    timeouts_metric = metrics_counter("ping_timeouts_total", "Ping probes with no response in time");
+    rtt_metric = metrics_histogram("ping_rtt_seconds", "Ping round trip time, read() minus write()");
+}
+
+bool app_ping_start(const ping_cfg_t *config)
+{
+    if ((NULL == config) || (0 == config->probe_len) || (config->probe_len > PING_MAX_FRAME) ||
+        (config->response_len > PING_MAX_FRAME)) {
+        return false;
+    }
+
+    if ((config->seq_offset != PING_NO_SEQ) &&
+        ((config->seq_offset < 0) || ((size_t)config->seq_offset >= config->probe_len))) {
+        log_info("ping: sequence offset %d is outside the probe\n", (int)config->seq_offset);
+        return false;
+    }
+
+    if (NULL == timers) {
+        log_info("ping: not initialized\n");
+        return false;
+    }
+
+    cfg = *config;
+    app_ping_reset();
+
+    stats.running = true;
+    state = PING_STATE_GAP;
+
+    /* First probe on the next tick, then the summary twice a second */
+    timer_wheel_schedule(timers, &probe_timer, 0, on_probe_due, NULL);
+    timer_wheel_schedule(timers, &gui_timer, PING_GUI_PERIOD_MS * NSEC_PER_MSEC, on_gui_update, NULL);
+
+    return true;
+}
+
+void app_ping_stop(void)
+{
+    state = PING_STATE_IDLE;
+    stats.running = false;
+
+    timer_wheel_cancel(timers, &probe_timer);
+    timer_wheel_cancel(timers, &timeout_timer);
+    timer_wheel_cancel(timers, &gui_timer);
+}
+
+void app_ping_reset(void)
+{
+    bool running = stats.running;
+
+    memset(&stats, 0, sizeof(stats));
+    stats.running = running;
+    histogram_init(&rtt_hist);
+    gui_received = UINT64_MAX;
+}
+
+void app_ping_process_byte(uint8_t byte, uint64_t index)
+{
+    uint64_t rx_ns, tx_ns;
+
+    if (PING_STATE_WAITING != state)
+        return;
+
+    window[window_pos] = byte;
+    window_pos = (window_pos + 1) % expected_len;
+    if (window_fill < expected_len) {
+        window_fill++;
+    }
+
+    /* Cheap reject on the last byte before comparing the whole frame */
+    if ((byte != expected[expected_len - 1]) || !window_matches())
+        return;
+
+    /* Both timestamps come from the read()/write() calls, not from when we got here */
+    if (serial_rx_stamp(index, &rx_ns) && serial_tx_stamp(probe_last_index, &tx_ns) && (rx_ns >= tx_ns)) {
+        histogram_record(&rtt_hist, rx_ns - tx_ns);
+        metrics_observe(rtt_metric, rx_ns - tx_ns);
+        stats.received++;
+    }
+    else {
+        stats.unstamped++;
+    }
+
+    metrics_add(responses_metric, 1);
+    timer_wheel_cancel(timers, &timeout_timer);
+    probe_done();
+}
+
+void app_ping_get_stats(ping_stats_t *out)
+{
+    if (NULL != out) {
+        *out = stats;
+    }
+}
+
+const histogram_t *app_ping_get_histogram(void)
+{
+    return &rtt_hist;
+}
+
+void app_ping_format_summary(char *buf, size_t len)
+{
+    if ((NULL == buf) || (0 == len))
+        return;
+
+    if (0 == rtt_hist.total) {
+        snprintf(buf, len, "ping: sent %llu, received 0, timeouts %llu",
+            (unsigned long long)stats.sent, (unsigned long long)stats.timeouts);
+        return;
+    }
+
+    snprintf(buf, len, "ping: sent %llu, received %llu, timeouts %llu | rtt us min %.1f p50 %.1f p99 %.1f p999 %.1f max %.1f",
+        (unsigned long long)stats.sent, (unsigned long long)stats.received, (unsigned long long)stats.timeouts,
+        (double)rtt_hist.min / 1000.0,
+        (double)histogram_percentile(&rtt_hist, 50.0) / 1000.0,
+        (double)histogram_percentile(&rtt_hist, 99.0) / 1000.0,
+        (double)histogram_percentile(&rtt_hist, 99.9) / 1000.0,
+        (double)rtt_hist.max / 1000.0);
+}
+
+static void send_probe(void)
+{
+    uint8_t probe[PING_MAX_FRAME];
+
+    /* No room in the TX buffer (a transmission is hogging it), try again next tick */
+    if (serial_tx_buf_space() < cfg.probe_len) {
+        timer_wheel_schedule(timers, &probe_timer, 0, on_probe_due, NULL);
+        return;
+    }
+
+    memcpy(probe, cfg.probe, cfg.probe_len);
+    if (cfg.seq_offset != PING_NO_SEQ) {
+        probe[cfg.seq_offset] = seq;
+    }
+
+    /* The device either echoes the probe or answers with a fixed response */
+    if (0 == cfg.response_len) {
+        memcpy(expected, probe, cfg.probe_len);
+        expected_len = cfg.probe_len;
+    }
+    else {
+        memcpy(expected, cfg.response, cfg.response_len);
+        expected_len = cfg.response_len;
+        if ((cfg.seq_offset != PING_NO_SEQ) && ((size_t)cfg.seq_offset < expected_len)) {
+            expected[cfg.seq_offset] = seq;
+        }
+    }
+    seq++;
+
+    window_pos = 0;
+    window_fill = 0;
+
+    serial_tx_write(probe, cfg.probe_len);
+    probe_last_index = serial_tx_push_count() - 1;
+    probe_sent_ns = get_nanos();
+
+    stats.sent++;
+    state = PING_STATE_WAITING;
+
+    /* The interval runs from probe to probe, whether or not a response came */
+    timer_wheel_schedule(timers, &probe_timer, (uint64_t)cfg.interval_ms * NSEC_PER_MSEC, on_probe_due, NULL);
+    timer_wheel_schedule(timers, &timeout_timer, (uint64_t)cfg.timeout_ms * NSEC_PER_MSEC, on_timeout, NULL);
+}
+
+static bool window_matches(void)
+{
+    if (window_fill < expected_len)
+        return false;
+
+    /* window_pos is the oldest byte once the window is full */
+    for (size_t i = 0; i < expected_len; i++) {
+        if (window[(window_pos + i) % expected_len] != expected[i])
+            return false;
+    }
+
+    return true;
+}
+
+static void probe_done(void)
+{
+    state = PING_STATE_GAP;
+
+    /* The interval already passed while waiting, send the next one right away */
+    if (!timer_wheel_is_pending(&probe_timer)) {
+        timer_wheel_schedule(timers, &probe_timer, 0, on_probe_due, NULL);
+    }
+}
+
+static void on_probe_due(tw_timer_t *timer, void *ctx)
+{
+    char summary[160];
+    (void)timer;
+    (void)ctx;
+
+    /* Still waiting for the previous response: the next probe goes out as
+     * soon as it arrives or times out */
+    if (PING_STATE_WAITING == state)
+        return;
+
+    if ((cfg.count != 0) && (stats.sent >= cfg.count)) {
+        app_ping_stop();
+        app_ping_format_summary(summary, sizeof(summary));
+        log_print("%s\n", summary);
+        gui_set_info_text(summary);
+        return;
+    }
+
+    send_probe();
+}
+
+static void on_timeout(tw_timer_t *timer, void *ctx)
+{
+    (void)timer;
+    (void)ctx;
+
+    if (PING_STATE_WAITING == state) {
+        stats.timeouts++;
+        metrics_add(timeouts_metric, 1);
+        probe_done();
+    }
+}
+
+static void on_gui_update(tw_timer_t *timer, void *ctx)
+{
+    char summary[160];
+    (void)ctx;
+
+    timer_wheel_schedule(timers, timer, PING_GUI_PERIOD_MS * NSEC_PER_MSEC, on_gui_update, NULL);
+
+    if (gui_received == stats.received)
+        return;
+
+    gui_received = stats.received;
+
+    app_ping_format_summary(summary, sizeof(summary));
+    gui_set_info_text(summary);
+}
+
+static cli_status_t ping_func(int argc, char **argv)
+{
+    static ping_cfg_t request;
+    char summary[256];
+    uint64_t value;
+    size_t len;
+
+    if (strcmp(argv[1], "stop") == 0) {
+        app_ping_stop();
+        return CLI_OK;
+    }
+
+    if (strcmp(argv[1], "reset") == 0) {
+        app_ping_reset();
+        return CLI_OK;
+    }
+
+    if (strcmp(argv[1], "stats") == 0) {
+        app_ping_format_summary(summary, sizeof(summary));
+        log_print("[%s]\n", summary);
+        return CLI_OK;
+    }
+
+    memset(&request, 0, sizeof(request));
+    request.seq_offset = PING_NO_SEQ;
+    request.interval_ms = 100;
+    request.timeout_ms = 1000;
+
+    for (int i = 1; i < argc; i++) {
+        if ((argv[i][0] == '-') && (argv[i][1] != '\0') && (argv[i][2] == '\0') && (i + 1 < argc)) {
+            i++;
+            if (argv[i - 1][1] == 'p') {
+                if (!cli_parse_hex(argv[i], request.response, sizeof(request.response), &request.response_len)) {
+                    log_error("[ping] invalid response \"%s\"\n", argv[i]);
+                    return CLI_E_INVALID_ARGS;
+                }
+                continue;
+            }
+            if (!cli_parse_u64(argv[i], &value)) {
+                log_error("[ping] option %s needs a number\n", argv[i - 1]);
+                return CLI_E_INVALID_ARGS;
+            }
+            switch (argv[i - 1][1]) {
+            case 's': request.seq_offset = (int32_t)value; break;
+            case 'i': request.interval_ms = (uint32_t)value; break;
+            case 't': request.timeout_ms = (uint32_t)value; break;
+            case 'c': request.count = value; break;
+            default:
+                log_error("[ping] unknown option %s\n", argv[i - 1]);
+                return CLI_E_INVALID_ARGS;
+            }
+        }
+        else {
+            len = request.probe_len;
+            if (!cli_parse_hex(argv[i], request.probe, sizeof(request.probe), &len)) {
+                log_error("[ping] invalid probe \"%s\" (max %u bytes)\n", argv[i], PING_MAX_FRAME);
+                return CLI_E_INVALID_ARGS;
+            }
+            request.probe_len = len;
+        }
+    }
+
+    if (0 == request.probe_len) {
+        log_error("[ping] usage: ping <probe bytes> [opts]\n");
+        return CLI_E_INVALID_ARGS;
+    }
+
+    return app_ping_start(&request) ? CLI_OK : CLI_E_INVALID_ARGS;
+}
@@ -0,0 +1,144 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        app_ping.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#ifndef APP_PING_H_
+#define APP_PING_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../stats/histogram.h"
+#include "../time_funcs/timer_wheel.h"
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Largest probe or response frame */
+#define PING_MAX_FRAME      64U
+
+/* No sequence number in the frames */
+#define PING_NO_SEQ         (-1)
+
+/****************************************************************************
+ * Structs, Unions, Enums, & Typedefs
+ *****************************************************************************/
+
+/**
+ * @brief Ping (round trip time) configuration.
+ */
+typedef struct ping_cfg_t {
+    uint8_t probe[PING_MAX_FRAME];      /**< Frame sent to the device */
+    size_t probe_len;                   /**< Length of the probe */
+    uint8_t response[PING_MAX_FRAME];   /**< Expected response, see response_len */
+    size_t response_len;                /**< Length of the response, 0 = the device echoes the probe */
+    int32_t seq_offset;                 /**< Offset of a sequence byte in probe and response, or PING_NO_SEQ */
+    uint32_t interval_ms;               /**< Time from one probe to the next */
+    uint32_t timeout_ms;                /**< Time to wait for a response */
+    uint64_t count;                     /**< Number of probes, 0 = until stopped */
+} ping_cfg_t;
+
+/**
+ * @brief Ping results so far.
+ */
+typedef struct ping_stats_t {
+    bool running;                       /**< Probes are still being sent */
+    uint64_t sent;                      /**< Probes sent */
+    uint64_t received;                  /**< Responses matched */
+    uint64_t timeouts;                  /**< Probes with no response in time */
+    uint64_t unstamped;                 /**< Responses whose I/O timestamps were no longer available */
+} ping_stats_t;
+
+/****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Set the wheel used for probe intervals, timeouts and display updates.
+ *
+ * @param wheel timer wheel advanced by the main loop
+ */
+void app_ping_init(timer_wheel_t *wheel);
+
+/**
+ * @brief Start sending probes. Clears the previous results.
+ *
+ * @param cfg ping configuration
+ * @return true if started
+ */
+bool app_ping_start(const ping_cfg_t *cfg);
+
+/**
+ * @brief Stop sending probes. The results are kept.
+ */
+void app_ping_stop(void);
+
+/**
+ * @brief Clear the results.
+ */
+void app_ping_reset(void);
+
+/**
+ * @brief Feed one received byte to the response matcher.
+ *
+ * @param byte the byte
+ * @param index stream index of the byte (see serial_rx_pop_count())
+ */
+void app_ping_process_byte(uint8_t byte, uint64_t index);
+
+/**
+ * @brief Get the counters.
+ *
+ * @param stats filled in with the current counters
+ */
+void app_ping_get_stats(ping_stats_t *stats);
+
+/**
+ * @brief Get the round trip time histogram (ns).
+ *
+ * @return const histogram_t*
+ */
+const histogram_t *app_ping_get_histogram(void);
+
+/**
+ * @brief Format a one line summary: counts and min/p50/p99/p999/max in us.
+ *
+ * @param buf output buffer
+ * @param len size of buf
+ */
+void app_ping_format_summary(char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* APP_PING_H_ */
@@ -0,0 +1,523 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        app_script.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+#include "app_script.h"
+#include "app_cli.h"
+#include "../cli/cli.h"
+#include "../cli/cli_args.h"
+#include "../reactor/reactor.h"
+#include "../time_funcs/time_funcs.h"
+#include "../log/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Time an expect step waits when the script doesn't say */
+#define SCRIPT_EXPECT_TIMEOUT_MS 1000U
+
+typedef enum script_op_t {
+    SCRIPT_OP_CMD,          /**< Run a CLI command */
+    SCRIPT_OP_SLEEP,        /**< Pause for value ms */
+    SCRIPT_OP_EXPECT,       /**< Wait up to value ms for the pattern */
+} script_op_t;
+
+typedef enum script_state_t {
+    SCRIPT_STATE_IDLE,      /**< Nothing loaded */
+    SCRIPT_STATE_RUNNING,   /**< Steps run from the main loop */
+    SCRIPT_STATE_WAITING,   /**< Sleeping or waiting for a pattern */
+} script_state_t;
+
+/**
+ * @brief One parsed script line. Arguments point into the script text.
+ */
+typedef struct script_step_t {
+    const cmd_t *cmd;       /**< Command to run (SCRIPT_OP_CMD) */
+    uint32_t argv_first;    /**< First argument in the argument pool */
+    uint16_t argc;          /**< Number of arguments, or the pattern length for expect */
+    uint8_t op;             /**< script_op_t */
+    bool must_pass;         /**< assert: a failure stops the script */
+    uint32_t line;          /**< Line number, for messages */
+    uint32_t value;         /**< Sleep time or expect timeout in ms */
+} script_step_t;
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+static char path_name[256];
+static char *text = NULL;               /* The whole script, tokenised in place */
+static char **args = NULL;              /* Arguments of all steps, NULL after each step's */
+static size_t args_count = 0;
+static size_t args_size = 0;
+static script_step_t *steps = NULL;
+static size_t steps_count = 0;
+static size_t steps_size = 0;
+
+static script_state_t state = SCRIPT_STATE_IDLE;
+static size_t pc = 0;                   /* Next step */
+static uint32_t failures = 0;
+static uint64_t start_ns = 0;
+
+static timer_wheel_t *timers = NULL;
+static tw_timer_t wait_timer;
+
+/* Expect: KMP matcher over the received bytes */
+static const uint8_t *pattern = NULL;
+static size_t pattern_len = 0;
+static size_t matched = 0;
+static uint8_t fallback[SCRIPT_MAX_PATTERN];
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+static bool parse(void);
+static bool parse_line(char *line, uint32_t line_no);
+static bool add_step(const script_step_t *step, char **argv, int argc);
+static void run_steps(void);
+static void finish(const char *reason);
+static void start_expect(const script_step_t *step);
+static void on_wait_done(tw_timer_t *timer, void *ctx);
+static int on_prepare(void *ctx);
+static cli_status_t source_func(int argc, char **argv);
+
+static const cmd_t source_cmd = {
+    .cmd = "source",
+    .func = source_func,
+    .help_text = "source <file>               - Run the commands in a script file (sleep, expect, assert)",
+    .min_args = 1,
+    .max_args = 1
+};
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+bool app_script_init(timer_wheel_t *wheel)
+{
+    timers = wheel;
+    timer_wheel_timer_init(&wait_timer);
+
+    if (!reactor_add_prepare(on_prepare, NULL)) {
+        log_error("script: failed to register with the reactor\n");
+        return false;
+    }
+
+    return app_cli_register(&source_cmd);
+}
+
+void app_script_deinit(void)
+{
+    if (NULL != timers) {
+        timer_wheel_cancel(timers, &wait_timer);
+    }
+
+    free(text);
+    free(args);
+    free(steps);
+    text = NULL;
+    args = NULL;
+    steps = NULL;
+    args_count = args_size = 0;
+    steps_count = steps_size = 0;
+    state = SCRIPT_STATE_IDLE;
+}
+
+bool app_script_run(const char *path)
+{
+    FILE *fp;
+    long len;
+
+    if ((NULL == path) || (NULL == timers)) {
+        return false;
+    }
+
+    if (SCRIPT_STATE_IDLE != state) {
+        log_error("script: %s is still running\n", path_name);
+        return false;
+    }
+
+    fp = fopen(path, "rb");
+    if (NULL == fp) {
+        log_error("script: can't open %s\n", path);
+        return false;
+    }
+
+    app_script_deinit();
+
+    /* Read it all at once, the steps point into it */
+    if ((fseek(fp, 0, SEEK_END) != 0) || ((len = ftell(fp)) < 0) || (fseek(fp, 0, SEEK_SET) != 0) ||
+        (NULL == (text = malloc((size_t)len + 1))) || (fread(text, 1, (size_t)len, fp) != (size_t)len)) {
+        log_error("script: can't read %s\n", path);
+        fclose(fp);
+        app_script_deinit();
+        return false;
+    }
+    fclose(fp);
+    text[len] = '\0';
+
+    snprintf(path_name, sizeof(path_name), "%s", path);
+
+    if (!parse()) {
+        app_script_deinit();
+        return false;
+    }
+
+    pc = 0;
+    failures = 0;
+    start_ns = get_nanos();
+    state = SCRIPT_STATE_RUNNING;
+
+    return true;
+}
+
+bool app_script_is_running(void)
+{
+    return (SCRIPT_STATE_IDLE != state);
+}
+
+void app_script_process_byte(uint8_t byte)
+{
+    if ((SCRIPT_STATE_WAITING != state) || (NULL == pattern)) {
+        return;
+    }
+
+    while ((matched > 0) && (pattern[matched] != byte)) {
+        matched = fallback[matched - 1];
+    }
+    if (pattern[matched] == byte) {
+        matched++;
+    }
+
+    if (matched == pattern_len) {
+        pattern = NULL;
+        timer_wheel_cancel(timers, &wait_timer);
+        state = SCRIPT_STATE_RUNNING;
+    }
+}
+
+/**
+ * @brief Split the text into lines and turn each into a step. Stops at the first error.
+ */
+static bool parse(void)
+{
+    char *line = text;
+    uint32_t line_no = 1;
+
+    while ('\0' != *line) {
+        char *nl = strchr(line, '\n');
+        if (NULL != nl) {
+            *nl = '\0';
+        }
+
+        if (!parse_line(line, line_no)) {
+            return false;
+        }
+
+        if (NULL == nl) {
+            break;
+        }
+        line = nl + 1;
+        line_no++;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Tokenise one line, resolve its command and append the step.
+ */
+static bool parse_line(char *line, uint32_t line_no)
+{
+    char *argv[MAX_ARGS + 1];
+    int argc = 0;
+    script_step_t step = { .op = SCRIPT_OP_CMD, .line = line_no };
+    uint64_t value;
+
+    /* Blank lines and comments */
+    line += strspn(line, " \t\r");
+    if (('\0' == *line) || ('#' == *line)) {
+        return true;
+    }
+
+    if (cli_tokenize(line, &argc, argv, MAX_ARGS) != CLI_OK) {
+        log_error("script: %s:%u: too many arguments, unterminated quote or bad escape\n", path_name, line_no);
+        return false;
+    }
+    if (0 == argc) {
+        return true;
+    }
+
+    char **av = argv;
+    if (strcmp(av[0], "assert") == 0) {
+        step.must_pass = true;
+        av++;
+        argc--;
+        if (0 == argc) {
+            log_error("script: %s:%u: assert needs a command\n", path_name, line_no);
+            return false;
+        }
+    }
+
+    if (strcmp(av[0], "sleep") == 0) {
+        if ((argc != 2) || !cli_parse_u64(av[1], &value) || (value > UINT32_MAX)) {
+            log_error("script: %s:%u: usage: sleep <ms>\n", path_name, line_no);
+            return false;
+        }
+        step.op = SCRIPT_OP_SLEEP;
+        step.value = (uint32_t)value;
+        return add_step(&step, NULL, 0);
+    }
+
+    if (strcmp(av[0], "expect") == 0) {
+        size_t len = 0;
+        uint8_t *bytes;
+        bool ok = (argc == 3) || (argc == 4);
+
+        step.op = SCRIPT_OP_EXPECT;
+        step.value = SCRIPT_EXPECT_TIMEOUT_MS;
+        if (ok && (argc == 4)) {
+            ok = cli_parse_u64(av[3], &value) && (value <= UINT32_MAX);
+            step.value = (uint32_t)value;
+        }
+
+        /* The pattern is decoded in place, it is never longer than its text */
+        if (ok && (strcmp(av[1], "hex") == 0)) {
+            bytes = (uint8_t *)av[2];
+            ok = cli_parse_hex(av[2], bytes, SCRIPT_MAX_PATTERN, &len);
+        }
+        else if (ok && (strcmp(av[1], "text") == 0)) {
+            bytes = (uint8_t *)av[2];
+            len = strlen(av[2]);
+            ok = (len > 0) && (len <= SCRIPT_MAX_PATTERN);
+        }
+        else {
+            ok = false;
+        }
+
+        if (!ok) {
+            log_error("script: %s:%u: usage: expect hex|text <pattern, max %u bytes> [timeout ms]\n",
+                path_name, line_no, SCRIPT_MAX_PATTERN);
+            return false;
+        }
+        step.argc = (uint16_t)len;
+        return add_step(&step, &av[2], 1);
+    }
+
+    /* Look the command up now so running it is just a call */
+    step.cmd = app_cli_resolve(av[0]);
+    if (NULL == step.cmd) {
+        log_error("script: %s:%u: unknown command \"%s\"\n", path_name, line_no, av[0]);
+        return false;
+    }
+    if (step.cmd == &source_cmd) {
+        log_error("script: %s:%u: scripts can't run other scripts\n", path_name, line_no);
+        return false;
+    }
+
+    step.argc = (uint16_t)argc;
+    return add_step(&step, av, argc);
+}
+
+/**
+ * @brief Append a step and copy its argument pointers to the pool.
+ */
+static bool add_step(const script_step_t *step, char **argv, int argc)
+{
+    if (steps_count == steps_size) {
+        size_t size = (0 == steps_size) ? 64 : (steps_size * 2);
+        script_step_t *grown = realloc(steps, size * sizeof(*steps));
+        if (NULL == grown) {
+            log_error("script: out of memory\n");
+            return false;
+        }
+        steps = grown;
+        steps_size = size;
+    }
+
+    if (args_count + (size_t)argc + 1 > args_size) {
+        size_t size = (0 == args_size) ? 256 : (args_size * 2);
+        while (args_count + (size_t)argc + 1 > size) {
+            size *= 2;
+        }
+        char **grown = realloc(args, size * sizeof(*args));
+        if (NULL == grown) {
+            log_error("script: out of memory\n");
+            return false;
+        }
+        args = grown;
+        args_size = size;
+    }
+
+    steps[steps_count] = *step;
+    steps[steps_count].argv_first = (uint32_t)args_count;
+    steps_count++;
+
+    for (int i = 0; i < argc; i++) {
+        args[args_count++] = argv[i];
+    }
+    args[args_count++] = NULL;
+
+    return true;
+}
+
+/**
+ * @brief Run steps until the script waits, ends or has used up its batch.
+ */
+static void run_steps(void)
+{
+    uint32_t budget = SCRIPT_BATCH_STEPS;
+
+    while ((SCRIPT_STATE_RUNNING == state) && (budget-- > 0)) {
+        if (pc >= steps_count) {
+            finish("done");
+            return;
+        }
+
+        const script_step_t *step = &steps[pc++];
+
+        switch (step->op) {
+        case SCRIPT_OP_SLEEP:
+            state = SCRIPT_STATE_WAITING;
+            timer_wheel_schedule(timers, &wait_timer, (uint64_t)step->value * NSEC_PER_MSEC, on_wait_done, NULL);
+            break;
+
+        case SCRIPT_OP_EXPECT:
+            start_expect(step);
+            break;
+
+        case SCRIPT_OP_CMD:
+        default:
+        {
+            cli_status_t rslt = app_cli_call(step->cmd, step->argc, &args[step->argv_first]);
+            if (CLI_OK != rslt) {
+                failures++;
+                log_error("script: %s:%u: %s failed (%d)\n", path_name, step->line, step->cmd->cmd, (int)rslt);
+                if (step->must_pass) {
+                    finish("assert failed");
+                    return;
+                }
+            }
+            break;
+        }
+        }
+    }
+}
+
+/**
+ * @brief Report how the script went and free it.
+ */
+static void finish(const char *reason)
+{
+    uint64_t elapsed_us = (get_nanos() - start_ns) / NSEC_PER_USEC;
+
+    log_print("script: %s %s after %zu of %zu steps, %u failed, %llu us\n", path_name, reason,
+        pc, steps_count, failures, (unsigned long long)elapsed_us);
+
+    pattern = NULL;
+    app_script_deinit();
+}
+
+/**
+ * @brief Build the KMP fallback table for the pattern and wait for it.
+ */
+static void start_expect(const script_step_t *step)
+{
+    size_t k = 0;
+
+    pattern = (const uint8_t *)args[step->argv_first];
+    pattern_len = step->argc;
+    matched = 0;
+
+    fallback[0] = 0;
+    for (size_t i = 1; i < pattern_len; i++) {
+        while ((k > 0) && (pattern[i] != pattern[k])) {
+            k = fallback[k - 1];
+        }
+        if (pattern[i] == pattern[k]) {
+            k++;
+        }
+        fallback[i] = (uint8_t)k;
+    }
+
+    state = SCRIPT_STATE_WAITING;
+    timer_wheel_schedule(timers, &wait_timer, (uint64_t)step->value * NSEC_PER_MSEC, on_wait_done, NULL);
+}
+
+/**
+ * @brief Sleep over, or the expected pattern didn't arrive in time.
+ */
+static void on_wait_done(tw_timer_t *timer, void *ctx)
+{
+    (void)timer;
+    (void)ctx;
+
+    if (SCRIPT_STATE_WAITING != state) {
+        return;
+    }
+
+    if (NULL != pattern) {
+        failures++;
+        log_error("script: %s:%u: expected pattern not received\n", path_name, steps[pc - 1].line);
+        finish("stopped");
+        return;
+    }
+
+    state = SCRIPT_STATE_RUNNING;
+}
+
+/**
+ * @brief Main loop hook: run a batch of steps. Keeps the loop from sleeping while there is more.
+ */
+static int on_prepare(void *ctx)
+{
+    (void)ctx;
+
+    if (SCRIPT_STATE_RUNNING != state) {
+        return -1;
+    }
+
+    /* Don't sleep after running steps: the next pass either continues the
+     * script or takes a timer or TX data the steps just set up into account */
+    run_steps();
+
+    return 0;
+}
+
+static cli_status_t source_func(int argc, char **argv)
+{
+    (void)argc;
+
+    return app_script_run(argv[1]) ? CLI_OK : CLI_E_IO;
+}
@@ -0,0 +1,107 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        app_script.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+#ifndef APP_SCRIPT_H_
+#define APP_SCRIPT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../time_funcs/timer_wheel.h"
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Longest pattern an expect step can wait for */
+#define SCRIPT_MAX_PATTERN      64U
+
+/* Steps run per pass of the main loop, so serial I/O and the GUI keep up */
+#define SCRIPT_BATCH_STEPS      256U
+
+/****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Register the source command and the main loop hook that runs scripts.
+ *
+ * Call after the app adds its own prepare callback, which advances the
+ * wheel, so a sleep or timeout that just ended is seen in the same pass.
+ *
+ * @param wheel timer wheel advanced by the main loop (sleep and expect timeouts)
+ * @return true if successful
+ */
+bool app_script_init(timer_wheel_t *wheel);
+
+/**
+ * @brief Free the current script, if any.
+ */
+void app_script_deinit(void);
+
+/**
+ * @brief Load a script and start running it from the main loop.
+ *
+ * The whole file is checked and turned into a list of steps before anything
+ * runs: each line is tokenised once and its command looked up once. A script
+ * is one command per line, plus:
+ *
+ *   # comment
+ *   sleep <ms>                          pause the script
+ *   expect hex|text <pattern> [ms]      wait for the bytes on the serial port (default 1000 ms),
+ *                                       stops the script if they don't arrive in time
+ *   assert <command ...>                stop the script if the command fails
+ *
+ * Other failing commands are reported and the script carries on.
+ *
+ * @param path script file
+ * @return true if the script was loaded and started
+ */
+bool app_script_run(const char *path);
+
+/**
+ * @brief Returns true while a script is loaded and not finished.
+ */
+bool app_script_is_running(void);
+
+/**
+ * @brief Feed a received byte to a waiting expect step.
+ *
+ * @param byte the byte
+ */
+void app_script_process_byte(uint8_t byte);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* APP_SCRIPT_H_ */
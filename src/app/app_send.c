@@ -0,0 +1,151 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        app_send.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+#include "app_send.h"
+#include "app_cli.h"
+#include "../cli/cli_args.h"
+#include "../serial/tx_engine.h"
+#include "../log/log.h"
+#include <stdio.h>
+#include <string.h>
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Largest hex string / pattern accepted by the send command */
+#define SEND_MAX_BYTES (512U)
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+static cli_status_t send_func(int argc, char **argv);
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+static const cmd_t send_cmd = {
+    .cmd = "send",
+    .func = send_func,
+    .help_text =
+        "send hex <bytes> [opts]     - Send hex bytes, e.g. send hex DEADBEEF 0D0A\n"
+        "  send pattern <bytes> [opts] - Repeat hex bytes until stopped (or -n times)\n"
+        "  send file <path> [opts]     - Stream a file\n"
+        "  send status | stop          - Show progress / abort the transmission\n"
+        "    opts: -r <bytes/s> (k/M suffix ok), -f <frame bytes>, -g <frame gap us>, -n <repeat>\n"
+        "          no -r/-g sends at the maximum rate",
+    .min_args = 1,
+    .max_args = CLI_ARGS_ANY
+};
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+bool app_send_init(void)
+{
+    return app_cli_register(&send_cmd);
+}
+
+static cli_status_t send_func(int argc, char **argv)
+{
+    static uint8_t data[SEND_MAX_BYTES];
+    size_t len = 0;
+    tx_pacing_t pacing = {0};
+    const char *path = NULL;
+    uint64_t value;
+    int i;
+
+    if (strcmp(argv[1], "stop") == 0) {
+        tx_engine_stop();
+        return CLI_OK;
+    }
+
+    if (strcmp(argv[1], "status") == 0) {
+        tx_status_t status;
+        tx_engine_get_status(&status);
+        log_print("[send] %s: %llu/%llu bytes, %llu frames, %llu us\n",
+            status.active ? "active" : "idle",
+            (unsigned long long)status.sent, (unsigned long long)status.total,
+            (unsigned long long)status.frames, (unsigned long long)status.elapsed_us);
+        return CLI_OK;
+    }
+
+    /* Pattern repeats until stopped unless -n says otherwise */
+    pacing.repeat = (strcmp(argv[1], "pattern") == 0) ? 0 : 1;
+
+    for (i = 2; i < argc; i++) {
+        if ((argv[i][0] == '-') && (argv[i][1] != '\0') && (argv[i][2] == '\0')) {
+            if ((i + 1 >= argc) || !cli_parse_u64(argv[i + 1], &value)) {
+                log_error("[send] option %s needs a number\n", argv[i]);
+                return CLI_E_INVALID_ARGS;
+            }
+            switch (argv[i][1]) {
+            case 'r': pacing.rate = value; break;
+            case 'f': pacing.frame_size = (uint32_t)value; break;
+            case 'g': pacing.frame_gap_us = value; break;
+            case 'n': pacing.repeat = value; break;
+            default:
+                log_error("[send] unknown option %s\n", argv[i]);
+                return CLI_E_INVALID_ARGS;
+            }
+            i++;
+        }
+        else if (strcmp(argv[1], "file") == 0) {
+            path = argv[i];
+        }
+        else if (!cli_parse_hex(argv[i], data, sizeof(data), &len)) {
+            log_error("[send] invalid hex \"%s\" (max %u bytes)\n", argv[i], SEND_MAX_BYTES);
+            return CLI_E_INVALID_ARGS;
+        }
+    }
+
+    if (strcmp(argv[1], "file") == 0) {
+        if (NULL == path) {
+            log_error("[send] usage: send file <path> [opts]\n");
+            return CLI_E_INVALID_ARGS;
+        }
+        return tx_engine_send_file(path, &pacing) ? CLI_OK : CLI_E_IO;
+    }
+
+    if ((strcmp(argv[1], "hex") != 0) && (strcmp(argv[1], "pattern") != 0)) {
+        log_error("[send] unknown source %s\n", argv[1]);
+        return CLI_E_INVALID_ARGS;
+    }
+
+    if (0 == len) {
+        log_print("[send] nothing to send\n");
+        return CLI_E_INVALID_ARGS;
+    }
+
+    return tx_engine_send_buffer(data, len, &pacing) ? CLI_OK : CLI_E_IO;
+}
@@ -0,0 +1,147 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2024 David Burke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        chunk_pool.c
+ * Created by  David Burke
+ * Version     1.0
+ * 
+ */
+
+#include "chunk_pool.h"
+#include <stdlib.h>
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+bool chunk_pool_init(chunk_pool_t *pool, size_t count, size_t chunk_size)
+{
+    if ((pool == NULL) || (chunk_size == 0)) {
+        return false;
+    }
+
+    pool->chunks = calloc(count, sizeof(chunk_t));
+    pool->slab = malloc(count * chunk_size);
+    pool->free_items = calloc(count, sizeof(chunk_t *));
+    pool->free_seq = calloc(count, sizeof(atomic_size_t));
+
+    // The free queue checks that count is a power of two
+    if ((pool->chunks == NULL) || (pool->slab == NULL) || (pool->free_items == NULL) || (pool->free_seq == NULL) ||
+        !mpsc_queue_init(&pool->free, pool->free_items, pool->free_seq, count, sizeof(chunk_t *))) {
+        chunk_pool_deinit(pool);
+        return false;
+    }
+
+    pool->count = count;
+    pool->chunk_size = chunk_size;
+    atomic_init(&pool->exhausted, 0);
+
+    // The queue has a slot for every chunk, so a release always finds room
+    for (size_t i = 0; i < count; i++) {
+        chunk_t *chunk = &pool->chunks[i];
+        atomic_init(&chunk->refs, 0);
+        chunk->pool = pool;
+        chunk->data = &pool->slab[i * chunk_size];
+        mpsc_queue_push(&pool->free, &chunk);
+    }
+
+    return true;
+}
+
+void chunk_pool_deinit(chunk_pool_t *pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+
+    free(pool->chunks);
+    free(pool->slab);
+    free(pool->free_items);
+    free(pool->free_seq);
+    pool->chunks = NULL;
+    pool->slab = NULL;
+    pool->free_items = NULL;
+    pool->free_seq = NULL;
+    pool->count = 0;
+}
+
+chunk_t *chunk_pool_get(chunk_pool_t *pool)
+{
+    chunk_t *chunk;
+
+    if ((pool == NULL) || (pool->chunks == NULL)) {
+        return NULL;
+    }
+
+    if (!mpsc_queue_pop(&pool->free, &chunk)) {
+        atomic_fetch_add_explicit(&pool->exhausted, 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    atomic_store_explicit(&chunk->refs, 1, memory_order_relaxed);
+    chunk->len = 0;
+    chunk->port = 0;
+    chunk->timestamp_ns = 0;
+    chunk->first_index = 0;
+
+    return chunk;
+}
+
+size_t chunk_pool_available(chunk_pool_t *pool)
+{
+    return (pool == NULL) ? 0 : mpsc_queue_count(&pool->free);
+}
+
+uint64_t chunk_pool_exhausted(chunk_pool_t *pool)
+{
+    return (pool == NULL) ? 0 : atomic_load_explicit(&pool->exhausted, memory_order_relaxed);
+}
+
+void chunk_ref(chunk_t *chunk)
+{
+    atomic_fetch_add_explicit(&chunk->refs, 1, memory_order_relaxed);
+}
+
+void chunk_release(chunk_t *chunk)
+{
+    if (chunk == NULL) {
+        return;
+    }
+
+    // The last holder's reads of the data happen before the chunk is reused
+    if (atomic_fetch_sub_explicit(&chunk->refs, 1, memory_order_acq_rel) == 1) {
+        mpsc_queue_push(&chunk->pool->free, &chunk);
+    }
+}
@@ -0,0 +1,146 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        chunk_pool.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#ifndef CHUNK_POOL_H_
+#define CHUNK_POOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "mpsc_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+struct chunk_pool_t;
+
+/**
+ * @brief A block of received bytes shared by every consumer that needs it.
+ *
+ * Whoever keeps the chunk beyond the call that handed it over takes a
+ * reference with chunk_ref() and drops it with chunk_release(). The last
+ * release returns the chunk to its pool.
+ */
+typedef struct chunk_t {
+    atomic_uint refs;               /**< References held, 0 while in the pool */
+    uint32_t len;                   /**< Bytes used in data */
+    uint32_t port;                  /**< Port the bytes came from */
+    uint64_t timestamp_ns;          /**< get_nanos() time of the read() that filled it */
+    uint64_t first_index;           /**< Stream index of data[0] */
+    struct chunk_pool_t *pool;      /**< Pool the chunk goes back to */
+    uint8_t *data;                  /**< chunk_size bytes in the pool's slab */
+} chunk_t;
+
+/**
+ * @brief Fixed number of fixed size chunks, allocated once.
+ *
+ * Free chunks wait in an MPSC queue: any thread may release a chunk, one
+ * thread (the one filling them) takes them out again. Taking and releasing
+ * never allocate, and a release never blocks.
+ */
+typedef struct chunk_pool_t {
+    chunk_t *chunks;                /**< count chunk headers */
+    uint8_t *slab;                  /**< count * chunk_size bytes of data */
+    size_t count;                   /**< Number of chunks, a power of two */
+    size_t chunk_size;              /**< Bytes of data per chunk */
+    mpsc_queue_t free;              /**< Chunks not in use, holds chunk_t pointers */
+    chunk_t **free_items;           /**< Storage of the free queue */
+    atomic_size_t *free_seq;        /**< Sequence numbers of the free queue */
+    atomic_uint_fast64_t exhausted; /**< chunk_pool_get() calls that found no free chunk */
+} chunk_pool_t;
+
+/*****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Allocates the chunks. Not thread safe, call before any get or release.
+ * 
+ * @param pool Pointer to the pool object.
+ * @param count Number of chunks, must be a power of two.
+ * @param chunk_size Bytes of data per chunk.
+ * @return True if the pool was created.
+ */
+bool chunk_pool_init(chunk_pool_t *pool, size_t count, size_t chunk_size);
+
+/**
+ * @brief Frees the chunks. Every chunk must have been released.
+ * 
+ * @param pool Pointer to the pool object.
+ */
+void chunk_pool_deinit(chunk_pool_t *pool);
+
+/**
+ * @brief Takes a free chunk with one reference and no data. Only one thread may get.
+ * 
+ * @param pool Pointer to the pool object.
+ * @return Pointer to the chunk, NULL if all of them are in use.
+ */
+chunk_t *chunk_pool_get(chunk_pool_t *pool);
+
+/**
+ * @brief Returns the number of free chunks. Call from the thread that gets them.
+ * 
+ * @param pool Pointer to the pool object.
+ * @return Number of chunks in the pool.
+ */
+size_t chunk_pool_available(chunk_pool_t *pool);
+
+/**
+ * @brief Returns the number of times a get found the pool empty.
+ * 
+ * @param pool Pointer to the pool object.
+ * @return Number of failed gets.
+ */
+uint64_t chunk_pool_exhausted(chunk_pool_t *pool);
+
+/**
+ * @brief Takes another reference to a chunk. Safe to call from any thread.
+ * 
+ * @param chunk Pointer to a chunk the caller already holds a reference to.
+ */
+void chunk_ref(chunk_t *chunk);
+
+/**
+ * @brief Drops a reference, the last one returns the chunk to its pool. Safe to call from any thread.
+ * 
+ * @param chunk Pointer to the chunk, may be NULL.
+ */
+void chunk_release(chunk_t *chunk);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CHUNK_POOL_H_ */
@@ -0,0 +1,174 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2024 David Burke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        history.c
+ * Created by  David Burke
+ * Version     1.0
+ * 
+ */
+
+#include "history.h"
+#include <stdlib.h>
+#include <string.h>
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+bool history_init(history_t *obj, size_t chunk_size, size_t max_bytes)
+{
+    if ((obj == NULL) || (chunk_size == 0)) {
+        return false;
+    }
+
+    obj->chunk_size = chunk_size;
+    obj->max_chunks = (max_bytes < chunk_size) ? 1 : (max_bytes / chunk_size);
+    obj->chunks = calloc(obj->max_chunks, sizeof(uint8_t *));
+    if (obj->chunks == NULL) {
+        return false;
+    }
+
+    atomic_init(&obj->start, 0);
+    atomic_init(&obj->end, 0);
+    obj->dropped = 0;
+
+    return true;
+}
+
+void history_deinit(history_t *obj)
+{
+    if ((obj == NULL) || (obj->chunks == NULL)) {
+        return;
+    }
+
+    for (size_t i = 0; i < obj->max_chunks; i++) {
+        free(obj->chunks[i]);
+    }
+    free(obj->chunks);
+    obj->chunks = NULL;
+}
+
+size_t history_append(history_t *obj, const uint8_t *data, size_t len)
+{
+    if ((obj == NULL) || (obj->chunks == NULL) || (data == NULL)) {
+        return 0;
+    }
+
+    uint64_t end = atomic_load_explicit(&obj->end, memory_order_relaxed);
+    size_t stored = 0;
+
+    while (stored < len) {
+        const uint64_t chunk = end / obj->chunk_size;
+        const size_t slot = (size_t)(chunk % obj->max_chunks);
+        const size_t ofs = (size_t)(end % obj->chunk_size);
+
+        if (ofs == 0) {
+            if (obj->chunks[slot] == NULL) {
+                obj->chunks[slot] = malloc(obj->chunk_size);
+                if (obj->chunks[slot] == NULL) {
+                    obj->dropped += len - stored;
+                    break;
+                }
+            }
+            else {
+                // Reusing the oldest chunk: readers must see it gone before it changes
+                atomic_store_explicit(&obj->start, (chunk - obj->max_chunks + 1) * obj->chunk_size,
+                                      memory_order_relaxed);
+                atomic_thread_fence(memory_order_release);
+            }
+        }
+
+        size_t n = obj->chunk_size - ofs;
+        if (n > len - stored) {
+            n = len - stored;
+        }
+        memcpy(&obj->chunks[slot][ofs], &data[stored], n);
+
+        stored += n;
+        end += n;
+    }
+
+    // Publishes the bytes (and any new chunk pointer) to readers
+    atomic_store_explicit(&obj->end, end, memory_order_release);
+
+    return stored;
+}
+
+size_t history_read(history_t *obj, uint64_t offset, uint8_t *out, size_t len)
+{
+    if ((obj == NULL) || (obj->chunks == NULL) || (out == NULL)) {
+        return 0;
+    }
+
+    const uint64_t end = atomic_load_explicit(&obj->end, memory_order_acquire);
+    if ((offset < atomic_load_explicit(&obj->start, memory_order_acquire)) || (offset >= end)) {
+        return 0;
+    }
+    if (len > end - offset) {
+        len = (size_t)(end - offset);
+    }
+
+    size_t copied = 0;
+    while (copied < len) {
+        const uint64_t pos = offset + copied;
+        const size_t slot = (size_t)((pos / obj->chunk_size) % obj->max_chunks);
+        const size_t ofs = (size_t)(pos % obj->chunk_size);
+
+        size_t n = obj->chunk_size - ofs;
+        if (n > len - copied) {
+            n = len - copied;
+        }
+        memcpy(&out[copied], &obj->chunks[slot][ofs], n);
+        copied += n;
+    }
+
+    // If the writer started reusing any of these chunks meanwhile, the copy may be torn
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&obj->start, memory_order_relaxed) > offset) {
+        return 0;
+    }
+
+    return copied;
+}
+
+uint64_t history_start(history_t *obj)
+{
+    return (obj == NULL) ? 0 : atomic_load_explicit(&obj->start, memory_order_acquire);
+}
+
+uint64_t history_end(history_t *obj)
+{
+    return (obj == NULL) ? 0 : atomic_load_explicit(&obj->end, memory_order_acquire);
+}
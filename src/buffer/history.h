@@ -0,0 +1,128 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        history.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/**
+ * @brief Append-only byte history in fixed size chunks, bounded by a memory cap.
+ *
+ * Byte offset n always lives in chunk n / chunk_size, in slot
+ * (n / chunk_size) % max_chunks, so finding a byte is arithmetic and a read
+ * costs only the bytes copied. Chunks are allocated as the history grows
+ * and, once the cap is reached, the oldest chunk is reused for the newest.
+ *
+ * One thread appends, any thread may read. The writer never waits for
+ * readers: it moves start past a chunk before reusing it, and a reader that
+ * finds start moved past what it copied discards the copy.
+ */
+typedef struct history_t {
+    uint8_t **chunks;               /**< max_chunks chunk pointers, NULL until first used */
+    size_t chunk_size;              /**< Bytes per chunk */
+    size_t max_chunks;              /**< Chunks allowed by the memory cap */
+    atomic_uint_fast64_t start;     /**< Offset of the oldest byte still held */
+    atomic_uint_fast64_t end;       /**< Offset one past the newest byte (bytes ever appended) */
+    uint64_t dropped;               /**< Bytes not stored because a chunk couldn't be allocated */
+} history_t;
+
+/*****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Initializes an empty history. No chunk is allocated yet.
+ * 
+ * @param obj Pointer to the history object.
+ * @param chunk_size Bytes per chunk.
+ * @param max_bytes Memory cap, rounded down to whole chunks (at least one).
+ * @return True if the history was initialized.
+ */
+bool history_init(history_t *obj, size_t chunk_size, size_t max_bytes);
+
+/**
+ * @brief Frees every chunk. No reader or writer may use the history any more.
+ * 
+ * @param obj Pointer to the history object.
+ */
+void history_deinit(history_t *obj);
+
+/**
+ * @brief Appends bytes, evicting the oldest chunks when the cap is reached. Writer only.
+ * 
+ * @param obj Pointer to the history object.
+ * @param data Bytes to append.
+ * @param len Number of bytes.
+ * @return Number of bytes stored, less than len only if a chunk couldn't be allocated.
+ */
+size_t history_append(history_t *obj, const uint8_t *data, size_t len);
+
+/**
+ * @brief Copies bytes starting at an absolute offset.
+ * 
+ * @param obj Pointer to the history object.
+ * @param offset Offset of the first byte, between history_start() and history_end().
+ * @param out Storage for at least len bytes.
+ * @param len Maximum number of bytes to copy.
+ * @return Number of bytes copied, 0 if offset has been evicted (or was overwritten while copying) or isn't written yet.
+ */
+size_t history_read(history_t *obj, uint64_t offset, uint8_t *out, size_t len);
+
+/**
+ * @brief Returns the offset of the oldest byte still held.
+ * 
+ * @param obj Pointer to the history object.
+ * @return uint64_t Offset of the oldest byte.
+ */
+uint64_t history_start(history_t *obj);
+
+/**
+ * @brief Returns the number of bytes ever appended, the offset the next byte gets.
+ * 
+ * @param obj Pointer to the history object.
+ * @return uint64_t Offset one past the newest byte.
+ */
+uint64_t history_end(history_t *obj);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* HISTORY_H_ */
@@ -0,0 +1,160 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2024 David Burke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        mpsc_queue.c
+ * Created by  David Burke
+ * Version     1.0
+ * 
+ */
+
+#include "mpsc_queue.h"
+#include <string.h>
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+bool mpsc_queue_init(mpsc_queue_t *obj, void *buf, atomic_size_t *seq, size_t size, size_t item_size)
+{
+    if ((obj == NULL) || (buf == NULL) || (seq == NULL)) {
+        return false;
+    }
+
+    // The position is mapped to a slot with a mask
+    if ((size == 0) || ((size & (size - 1)) != 0)) {
+        return false;
+    }
+
+    obj->buf = buf;
+    obj->seq = seq;
+    obj->size = size;
+    obj->item_size = item_size;
+    obj->tail = 0;
+    atomic_init(&obj->head, 0);
+    atomic_init(&obj->dropped, 0);
+
+    // Slot i is free for the producer that claims position i
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&seq[i], i);
+    }
+
+    return true;
+}
+
+bool mpsc_queue_push(mpsc_queue_t *obj, const void *item)
+{
+    if ((obj == NULL) || (item == NULL)) {
+        return false;
+    }
+
+    const size_t mask = obj->size - 1;
+    size_t pos = atomic_load_explicit(&obj->head, memory_order_relaxed);
+    atomic_size_t *slot_seq;
+
+    for (;;) {
+        slot_seq = &obj->seq[pos & mask];
+        size_t seq = atomic_load_explicit(slot_seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            // The slot is free, try to claim the position
+            if (atomic_compare_exchange_weak_explicit(&obj->head, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+            // pos now holds the current head, try again from there
+        }
+        else if (diff < 0) {
+            // The consumer hasn't freed the slot from the previous lap yet
+            atomic_fetch_add_explicit(&obj->dropped, 1, memory_order_relaxed);
+            return false;
+        }
+        else {
+            // Another producer took this position
+            pos = atomic_load_explicit(&obj->head, memory_order_relaxed);
+        }
+    }
+
+    memcpy((uint8_t *)obj->buf + (pos & mask) * obj->item_size, item, obj->item_size);
+
+    // Publish the item to the consumer
+    atomic_store_explicit(slot_seq, pos + 1, memory_order_release);
+
+    return true;
+}
+
+bool mpsc_queue_pop(mpsc_queue_t *obj, void *item)
+{
+    if ((obj == NULL) || (item == NULL)) {
+        return false;
+    }
+
+    const size_t mask = obj->size - 1;
+    const size_t pos = obj->tail;
+    atomic_size_t *slot_seq = &obj->seq[pos & mask];
+
+    // Empty, or the producer that claimed this position is still copying
+    if (atomic_load_explicit(slot_seq, memory_order_acquire) != pos + 1) {
+        return false;
+    }
+
+    memcpy(item, (uint8_t *)obj->buf + (pos & mask) * obj->item_size, obj->item_size);
+
+    // Hand the slot back to the producers for the next lap
+    atomic_store_explicit(slot_seq, pos + obj->size, memory_order_release);
+    obj->tail = pos + 1;
+
+    return true;
+}
+
+size_t mpsc_queue_count(mpsc_queue_t *obj)
+{
+    if (obj == NULL) {
+        return 0;
+    }
+
+    size_t head = atomic_load_explicit(&obj->head, memory_order_relaxed);
+
+    return head - obj->tail;
+}
+
+uint64_t mpsc_queue_dropped(mpsc_queue_t *obj)
+{
+    if (obj == NULL) {
+        return 0;
+    }
+
+    return atomic_load_explicit(&obj->dropped, memory_order_relaxed);
+}
@@ -0,0 +1,117 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        mpsc_queue.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#ifndef MPSC_QUEUE_H_
+#define MPSC_QUEUE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/**
+ * @brief Bounded queue of fixed size items, any number of producers and one consumer.
+ *
+ * Each slot carries a sequence number that tells whether it is free for the
+ * producer claiming that position or holds an item for the consumer. Producers
+ * only contend on the head index; a push never blocks and never waits for the
+ * consumer, it fails (and is counted) when the queue is full.
+ */
+typedef struct mpsc_queue_t {
+    void *buf;                      /**< Item storage, size * item_size bytes */
+    atomic_size_t *seq;             /**< One sequence number per slot */
+    size_t size;                    /**< Number of slots, a power of two */
+    size_t item_size;               /**< Size of each item */
+    atomic_size_t head;             /**< Next position claimed by a producer */
+    size_t tail;                    /**< Next position read by the consumer */
+    atomic_uint_fast64_t dropped;   /**< Pushes that failed because the queue was full */
+} mpsc_queue_t;
+
+/*****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Initializes a queue object. Not thread safe, call before any push or pop.
+ * 
+ * @param obj Pointer to the queue object.
+ * @param buf Pointer to size * item_size bytes of item storage.
+ * @param seq Pointer to size sequence numbers.
+ * @param size Number of slots, must be a power of two.
+ * @param item_size Size of each item.
+ * @return True if the queue was initialized.
+ */
+bool mpsc_queue_init(mpsc_queue_t *obj, void *buf, atomic_size_t *seq, size_t size, size_t item_size);
+
+/**
+ * @brief Copies an item into the queue. Safe to call from any thread.
+ * 
+ * @param obj Pointer to the queue object.
+ * @param item Pointer to the item to be pushed.
+ * @return True if the item was pushed, false if the queue was full.
+ */
+bool mpsc_queue_push(mpsc_queue_t *obj, const void *item);
+
+/**
+ * @brief Copies the oldest item out of the queue. Only one thread may pop.
+ * 
+ * @param obj Pointer to the queue object.
+ * @param item Pointer to store the popped item.
+ * @return True if an item was popped, false if the queue was empty.
+ */
+bool mpsc_queue_pop(mpsc_queue_t *obj, void *item);
+
+/**
+ * @brief Returns the number of items in the queue, including pushes still in progress. Call from the consumer.
+ * 
+ * @param obj Pointer to the queue object.
+ * @return Number of items.
+ */
+size_t mpsc_queue_count(mpsc_queue_t *obj);
+
+/**
+ * @brief Returns the number of pushes that failed because the queue was full.
+ * 
+ * @param obj Pointer to the queue object.
+ * @return Number of dropped items.
+ */
+uint64_t mpsc_queue_dropped(mpsc_queue_t *obj);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* MPSC_QUEUE_H_ */
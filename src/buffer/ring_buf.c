@@ -139,4 +139,111 @@ bool ring_buf_pop(ring_buf_t *obj, void *item)
     obj->tail = (obj->tail + 1) % obj->size;
 
     return true;
-}
\ No newline at end of file
+}
+
+size_t ring_buf_count(ring_buf_t *obj)
+{
+    // Return 0 if obj is NULL
+    if (obj == NULL) {
+        return 0;
+    }
+
+    return (obj->head + obj->size - obj->tail) % obj->size;
+}
+
+size_t ring_buf_space(ring_buf_t *obj)
+{
+    // Return 0 if obj is NULL
+    if (obj == NULL) {
+        return 0;
+    }
+
+    // One slot is always left open to tell full from empty
+    return obj->size - 1 - ring_buf_count(obj);
+}
+
+size_t ring_buf_push_n(ring_buf_t *obj, const void *items, size_t count)
+{
+    // Return 0 if obj or items is NULL
+    if (obj == NULL || items == NULL) {
+        return 0;
+    }
+
+    size_t space = ring_buf_space(obj);
+    if (count > space) {
+        count = space;
+    }
+
+    // Copy up to the end of the buffer, then wrap to the start
+    size_t first = obj->size - obj->head;
+    if (first > count) {
+        first = count;
+    }
+
+    memcpy((uint8_t *)obj->buf + obj->head * obj->item_size, items, first * obj->item_size);
+    memcpy(obj->buf, (const uint8_t *)items + first * obj->item_size, (count - first) * obj->item_size);
+
+    obj->head = (obj->head + count) % obj->size;
+
+    return count;
+}
+
+size_t ring_buf_pop_n(ring_buf_t *obj, void *items, size_t count)
+{
+    // Return 0 if obj or items is NULL
+    if (obj == NULL || items == NULL) {
+        return 0;
+    }
+
+    size_t available = ring_buf_count(obj);
+    if (count > available) {
+        count = available;
+    }
+
+    // Copy up to the end of the buffer, then wrap to the start
+    size_t first = obj->size - obj->tail;
+    if (first > count) {
+        first = count;
+    }
+
+    memcpy(items, (uint8_t *)obj->buf + obj->tail * obj->item_size, first * obj->item_size);
+    memcpy((uint8_t *)items + first * obj->item_size, obj->buf, (count - first) * obj->item_size);
+
+    obj->tail = (obj->tail + count) % obj->size;
+
+    return count;
+}
+
+size_t ring_buf_peek_contig(ring_buf_t *obj, void **items)
+{
+    // Return 0 if obj or items is NULL
+    if (obj == NULL || items == NULL) {
+        return 0;
+    }
+
+    *items = (uint8_t *)obj->buf + obj->tail * obj->item_size;
+
+    // Readable items run to the head, or to the end of the buffer if the data wraps
+    if (obj->head >= obj->tail) {
+        return obj->head - obj->tail;
+    }
+
+    return obj->size - obj->tail;
+}
+
+size_t ring_buf_skip(ring_buf_t *obj, size_t count)
+{
+    // Return 0 if obj is NULL
+    if (obj == NULL) {
+        return 0;
+    }
+
+    size_t available = ring_buf_count(obj);
+    if (count > available) {
+        count = available;
+    }
+
+    obj->tail = (obj->tail + count) % obj->size;
+
+    return count;
+}
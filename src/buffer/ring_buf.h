@@ -106,6 +106,63 @@ bool ring_buf_is_empty(ring_buf_t *obj);
  */
 bool ring_buf_is_full(ring_buf_t *obj);
 
+/**
+ * @brief Returns the number of items currently in the ring buffer.
+ * 
+ * @param obj Pointer to the ring buffer object.
+ * @return Number of items that can be popped.
+ */
+size_t ring_buf_count(ring_buf_t *obj);
+
+/**
+ * @brief Returns the number of items that can still be pushed.
+ * 
+ * @param obj Pointer to the ring buffer object.
+ * @return Number of free slots.
+ */
+size_t ring_buf_space(ring_buf_t *obj);
+
+/**
+ * @brief Pushes up to count items with at most two memcpy calls.
+ * 
+ * @param obj Pointer to the ring buffer object.
+ * @param items Pointer to the first item to be pushed.
+ * @param count Number of items available at items.
+ * @return Number of items actually pushed (limited by the free space).
+ */
+size_t ring_buf_push_n(ring_buf_t *obj, const void *items, size_t count);
+
+/**
+ * @brief Pops up to count items with at most two memcpy calls.
+ * 
+ * @param obj Pointer to the ring buffer object.
+ * @param items Pointer to storage for at least count items.
+ * @param count Maximum number of items to pop.
+ * @return Number of items actually popped.
+ */
+size_t ring_buf_pop_n(ring_buf_t *obj, void *items, size_t count);
+
+/**
+ * @brief Gets the longest run of items that can be read in place without wrapping.
+ * 
+ * Use with ring_buf_skip() to consume data without copying it out first,
+ * e.g. handing the span straight to write().
+ * 
+ * @param obj Pointer to the ring buffer object.
+ * @param items Set to the first readable item.
+ * @return Number of contiguous items at *items (0 if empty).
+ */
+size_t ring_buf_peek_contig(ring_buf_t *obj, void **items);
+
+/**
+ * @brief Discards up to count items from the tail of the ring buffer.
+ * 
+ * @param obj Pointer to the ring buffer object.
+ * @param count Number of items to discard.
+ * @return Number of items actually discarded.
+ */
+size_t ring_buf_skip(ring_buf_t *obj, size_t count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -35,8 +35,6 @@
 #include <stdint.h>
 #include <string.h>
 
-rx_data_t rx_data;
-
 const char cli_unrecog[] = "CLI Error: Command not recognized\r\n";
 
 /*!
@@ -44,18 +42,41 @@ const char cli_unrecog[] = "CLI Error: Command not recognized\r\n";
  */
 static void cli_print(cli_t *cli, const char *msg);
 
+/*!
+ * @brief This internal API returns the value of a hex digit, -1 if it isn't one.
+ */
+static int cli_hex_digit(char c);
+
+/*!
+ * @brief This internal API hashes a command name (FNV-1a).
+ */
+static uint32_t cli_hash(const char *name);
+
+/*!
+ * @brief This internal API finds the first registered command not less than the prefix.
+ */
+static size_t cli_lower_bound(const cli_t *cli, const char *prefix);
+
 /*!
  * @brief This API initialises the command-line interface.
  */
 cli_status_t cli_init(cli_t *cli, uint8_t *rx_buf_ptr, uint16_t rx_buf_size)
 {
-    (void)cli;
-    /* Reset buffer */
-    //memset(rx_data.buf_ptr, 0, rx_data.buf_size);
-    rx_data.current_buf_length = 0;
-    rx_data.is_ready = false;
-    rx_data.buf_ptr = rx_buf_ptr;
-    rx_data.buf_size = rx_buf_size;
+    if(cli == NULL)
+    {
+        return CLI_E_NULL_PTR;
+    }
+
+    /* The line is terminated in place, so nothing needs clearing */
+    cli->rx.current_buf_length = 0;
+    cli->rx.is_ready = false;
+    cli->rx.buf_ptr = rx_buf_ptr;
+    cli->rx.buf_size = rx_buf_size;
+
+    if(cli->cmd_tbl != NULL)
+    {
+        return cli_register_table(cli, cli->cmd_tbl, cli->cmd_cnt);
+    }
     return CLI_OK;
 }
 
@@ -74,42 +95,222 @@ cli_status_t cli_deinit(cli_t *cli)
  */
 cli_status_t cli_process(cli_t *cli)
 {
-    uint8_t argc = 0;
-    char *argv[MAX_ARGS];
+    if(cli == NULL)
+    {
+        return CLI_E_NULL_PTR;
+    }
 
-    if(rx_data.is_ready == false)
+    if(cli->rx.is_ready == false)
     {
         return CLI_E_CMD_NOT_READY;
     }
 
-    rx_data.is_ready = false;
+    cli->rx.is_ready = false;
 
-    /* Get the first token (cmd name) */
-    argv[argc] = strtok((char *)rx_data.buf_ptr, " ");
+    return cli_exec(cli, (char *)cli->rx.buf_ptr);
+}
+
+/*!
+ * @brief This API tokenises and executes one command line.
+ */
+cli_status_t cli_exec(cli_t *cli, char *line)
+{
+    int argc = 0;
+    char *argv[MAX_ARGS + 1];
+
+    if((cli == NULL) || (line == NULL))
+    {
+        return CLI_E_NULL_PTR;
+    }
+
+    cli_status_t rslt = cli_tokenize(line, &argc, argv, MAX_ARGS);
+    if(rslt == CLI_E_BUF_FULL)
+    {
+        cli->println("CLI Error: more than %d arguments\r\n", MAX_ARGS - 1);
+        return CLI_E_INVALID_ARGS;
+    }
+    if(rslt != CLI_OK)
+    {
+        cli->println("CLI Error: unterminated quote or bad escape\r\n");
+        return rslt;
+    }
+    argv[argc] = NULL;
+
+    /* Empty line */
+    if(argc == 0)
+    {
+        return CLI_OK;
+    }
+
+    const cmd_t *cmd = cli_resolve(cli, argv[0]);
+    if(cmd == NULL)
+    {
+        return CLI_E_CMD_NOT_FOUND;
+    }
+
+    return cli_call(cli, cmd, argc, argv);
+}
+
+/*!
+ * @brief This API looks a command up by name or unambiguous prefix.
+ */
+const cmd_t *cli_resolve(cli_t *cli, const char *name)
+{
+    if((cli == NULL) || (name == NULL))
+    {
+        return NULL;
+    }
+
+    const cmd_t *cmd = cli_find(cli, name);
+    if(cmd != NULL)
+    {
+        return cmd;
+    }
+
+    /* A prefix is only completed, never run: "e" or "st" would otherwise quit */
+    if(cli_complete(cli, name, NULL, 0) > 0)
+    {
+        cli->println("CLI Error: \"%s\" is not a command, did you mean:", name);
+        for(size_t i = cli_lower_bound(cli, name); i < cli->reg_cnt; i++)
+        {
+            if(strncmp(cli->cmds[i]->cmd, name, strlen(name)) != 0)
+            {
+                break;
+            }
+            cli->println(" %s", cli->cmds[i]->cmd);
+        }
+        cli->println("\r\n");
+    }
+    else
+    {
+        cli_print(cli, cli_unrecog);
+    }
+    return NULL;
+}
 
-    /* Walk through the other tokens (parameters) */
-    while((argv[argc] != NULL) && (argc < MAX_ARGS))
+/*!
+ * @brief This API checks the arguments against the command and runs it.
+ */
+cli_status_t cli_call(cli_t *cli, const cmd_t *cmd, int argc, char **argv)
+{
+    if((cli == NULL) || (cmd == NULL) || (argv == NULL) || (argc < 1))
     {
-        argv[++argc] = strtok(NULL, " ");
+        return CLI_E_NULL_PTR;
     }
-    
-    /* Search the command table for a matching command, using argv[0]
-     * which is the command name. */
-    for(size_t i = 0 ; i < cli->cmd_cnt ; i++)
+
+    /* Check the argument count before running it */
+    int nargs = argc - 1;
+    bool unchecked = (cmd->min_args == 0) && (cmd->max_args == 0);
+    if(!unchecked && ((nargs < cmd->min_args) ||
+       ((cmd->max_args != CLI_ARGS_ANY) && (nargs > cmd->max_args))))
     {
-        if(strcmp(argv[0], cli->cmd_tbl[i].cmd) == 0)
+        if(cmd->help_text != NULL)
         {
-            /* Found a match, execute the associated function. */
-            return cli->cmd_tbl[i].func(argc, argv);
+            cli->println("usage: %s\r\n", cmd->help_text);
         }
+        return CLI_E_INVALID_ARGS;
     }
 
-    /* Command not found */
-    rx_data.current_buf_length = 0;
-    rx_data.is_ready = false;
-    memset(rx_data.buf_ptr, 0, rx_data.buf_size);
-    cli_print(cli, cli_unrecog);
-    return CLI_E_CMD_NOT_FOUND;
+    return cmd->func(argc, argv);
+}
+
+/*!
+ * @brief This API splits a line into arguments in place.
+ */
+cli_status_t cli_tokenize(char *line, int *argc, char **argv, int max_args)
+{
+    char *src = line;
+    char *dst = line;
+
+    if((line == NULL) || (argc == NULL) || (argv == NULL))
+    {
+        return CLI_E_NULL_PTR;
+    }
+
+    *argc = 0;
+
+    /* Unquoting and escapes only ever shrink a token, so dst never passes src */
+    for(;;)
+    {
+        while((*src == ' ') || (*src == '\t') || (*src == '\r'))
+        {
+            src++;
+        }
+        if(*src == '\0')
+        {
+            break;
+        }
+        if(*argc >= max_args)
+        {
+            return CLI_E_BUF_FULL;
+        }
+        argv[(*argc)++] = dst;
+
+        char quote = '\0';
+        while(*src != '\0')
+        {
+            char c = *src;
+            if((quote == '\0') && ((c == ' ') || (c == '\t') || (c == '\r')))
+            {
+                break;
+            }
+            src++;
+
+            if(c == quote)
+            {
+                quote = '\0';
+                continue;
+            }
+            if((quote == '\0') && ((c == '"') || (c == '\'')))
+            {
+                quote = c;
+                continue;
+            }
+            if((c == '\\') && (quote != '\''))
+            {
+                switch(*src)
+                {
+                    case 'n': c = '\n'; src++; break;
+                    case 'r': c = '\r'; src++; break;
+                    case 't': c = '\t'; src++; break;
+                    case 'x':
+                    {
+                        /* \xHH, a NUL byte would cut the argument short */
+                        int hi = cli_hex_digit(src[1]);
+                        int lo = (hi < 0) ? -1 : cli_hex_digit(src[2]);
+                        if((lo < 0) || ((hi | lo) == 0))
+                        {
+                            return CLI_E_INVALID_ARGS;
+                        }
+                        c = (char)((hi << 4) | lo);
+                        src += 3;
+                        break;
+                    }
+                    case '\0':
+                        return CLI_E_INVALID_ARGS;
+                    default:
+                        c = *src++;
+                        break;
+                }
+            }
+            *dst++ = c;
+        }
+
+        if(quote != '\0')
+        {
+            return CLI_E_INVALID_ARGS;
+        }
+
+        bool last = (*src == '\0');
+        *dst++ = '\0';
+        if(last)
+        {
+            break;
+        }
+        src++;
+    }
+
+    return CLI_OK;
 }
 
 /*!
@@ -118,39 +319,37 @@ cli_status_t cli_process(cli_t *cli)
  */
 cli_status_t cli_put(cli_t *cli, char c)
 {
-    (void)cli;
-    
+    if((cli == NULL) || (cli->rx.buf_ptr == NULL))
+    {
+        return CLI_E_NULL_PTR;
+    }
+
+    rx_data_t *rx = &cli->rx;
+
     switch(c)
     {
         case CMD_TERMINATOR:
         {
-            /* Terminate the msg and reset the msg ptr by subtracting the length. This should put us back at the beginning of the array  */
-            *rx_data.buf_ptr = '\0';
-            rx_data.buf_ptr -= rx_data.current_buf_length;
-            rx_data.is_ready = true;
-            rx_data.current_buf_length = 0;
+            /* Terminate the line in place, the buffer is reused from the start */
+            rx->buf_ptr[rx->current_buf_length] = '\0';
+            rx->is_ready = true;
+            rx->current_buf_length = 0;
             break;
         }
         default:
         {
-            /* If we have never received anything, let's clear the buffer to have a fresh start */
-            if(rx_data.current_buf_length == 0)
+            /* If backspace or delete remove character if we aren't at the beginning of the buffer */
+            if(c == 127 || c == 8)
             {
-                memset(rx_data.buf_ptr, 0, rx_data.buf_size);
+                if(rx->current_buf_length > 0)
+                {
+                    rx->current_buf_length--;
+                }
             }
-            /* Normal character received, add to buffer. */
-            if(rx_data.current_buf_length < rx_data.buf_size)
+            /* Normal character received, add to buffer. Keep room for the terminator. */
+            else if(rx->current_buf_length + 1 < rx->buf_size)
             {
-            	/* If backspace or delete remove character if we aren't at the beginning of the buffer */
-            	if(c == 127 || c == 8){
-            		if(rx_data.current_buf_length > 0){
-						*rx_data.buf_ptr-- = '\0';
-						rx_data.current_buf_length--;
-            		}
-            	}else{
-                *rx_data.buf_ptr++ = c;
-                rx_data.current_buf_length++;
-            	}
+                rx->buf_ptr[rx->current_buf_length++] = c;
             }
             else
             {
@@ -162,6 +361,183 @@ cli_status_t cli_put(cli_t *cli, char c)
     return CLI_OK;
 }
 
+/*!
+ * @brief This API adds a command.
+ */
+cli_status_t cli_register(cli_t *cli, const cmd_t *cmd)
+{
+    if((cli == NULL) || (cmd == NULL) || (cmd->cmd == NULL) || (cmd->func == NULL))
+    {
+        return CLI_E_NULL_PTR;
+    }
+
+    if(cli->reg_cnt >= CLI_MAX_CMDS)
+    {
+        return CLI_E_BUF_FULL;
+    }
+
+    /* Hash slot, linear probing. The table is never more than half full. */
+    uint32_t slot = cli_hash(cmd->cmd) & (CLI_HASH_SLOTS - 1);
+    while(cli->hash[slot] != NULL)
+    {
+        if(strcmp(cli->hash[slot]->cmd, cmd->cmd) == 0)
+        {
+            return CLI_E_INVALID_ARGS;
+        }
+        slot = (slot + 1) & (CLI_HASH_SLOTS - 1);
+    }
+    cli->hash[slot] = cmd;
+
+    /* Keep the list sorted for help and completion */
+    size_t pos = cli_lower_bound(cli, cmd->cmd);
+    memmove(&cli->cmds[pos + 1], &cli->cmds[pos], (cli->reg_cnt - pos) * sizeof(cli->cmds[0]));
+    cli->cmds[pos] = cmd;
+    cli->reg_cnt++;
+
+    return CLI_OK;
+}
+
+/*!
+ * @brief This API adds a table of commands.
+ */
+cli_status_t cli_register_table(cli_t *cli, const cmd_t *tbl, size_t cnt)
+{
+    cli_status_t first = CLI_OK;
+
+    if(tbl == NULL)
+    {
+        return CLI_E_NULL_PTR;
+    }
+
+    for(size_t i = 0; i < cnt; i++)
+    {
+        cli_status_t rslt = cli_register(cli, &tbl[i]);
+        if((rslt != CLI_OK) && (first == CLI_OK))
+        {
+            first = rslt;
+        }
+    }
+    return first;
+}
+
+/*!
+ * @brief This API looks up a command by its full name.
+ */
+const cmd_t *cli_find(const cli_t *cli, const char *name)
+{
+    if((cli == NULL) || (name == NULL))
+    {
+        return NULL;
+    }
+
+    uint32_t slot = cli_hash(name) & (CLI_HASH_SLOTS - 1);
+    while(cli->hash[slot] != NULL)
+    {
+        if(strcmp(cli->hash[slot]->cmd, name) == 0)
+        {
+            return cli->hash[slot];
+        }
+        slot = (slot + 1) & (CLI_HASH_SLOTS - 1);
+    }
+    return NULL;
+}
+
+/*!
+ * @brief This API finds the commands starting with a prefix.
+ */
+size_t cli_complete(const cli_t *cli, const char *prefix, const cmd_t **matches, size_t max)
+{
+    size_t found = 0;
+
+    if((cli == NULL) || (prefix == NULL))
+    {
+        return 0;
+    }
+
+    size_t len = strlen(prefix);
+    for(size_t i = cli_lower_bound(cli, prefix); i < cli->reg_cnt; i++)
+    {
+        if(strncmp(cli->cmds[i]->cmd, prefix, len) != 0)
+        {
+            break;
+        }
+        if((matches != NULL) && (found < max))
+        {
+            matches[found] = cli->cmds[i];
+        }
+        found++;
+    }
+    return found;
+}
+
+/*!
+ * @brief This API returns a registered command, in name order.
+ */
+const cmd_t *cli_get_cmd(const cli_t *cli, size_t index)
+{
+    if((cli == NULL) || (index >= cli->reg_cnt))
+    {
+        return NULL;
+    }
+    return cli->cmds[index];
+}
+
+/*!
+ * @brief Value of a hex digit.
+ */
+static int cli_hex_digit(char c)
+{
+    if((c >= '0') && (c <= '9'))
+    {
+        return c - '0';
+    }
+    if((c >= 'a') && (c <= 'f'))
+    {
+        return c - 'a' + 10;
+    }
+    if((c >= 'A') && (c <= 'F'))
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/*!
+ * @brief Hash a command name (FNV-1a).
+ */
+static uint32_t cli_hash(const char *name)
+{
+    uint32_t h = 2166136261u;
+    while(*name != '\0')
+    {
+        h ^= (uint8_t)*name++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/*!
+ * @brief Binary search for the first registered command not less than the prefix.
+ */
+static size_t cli_lower_bound(const cli_t *cli, const char *prefix)
+{
+    size_t lo = 0;
+    size_t hi = cli->reg_cnt;
+    while(lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if(strcmp(cli->cmds[mid]->cmd, prefix) < 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
 /*!
  * @brief Print a message on the command-line interface.
  */
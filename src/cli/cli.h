@@ -47,6 +47,9 @@ extern "C" {
 /*!
  * @brief This API initialises the command-line interface.
  * 
+ * The commands in cli->cmd_tbl (if any) are registered. Commands registered
+ * before this call are kept, so the handle must start zeroed (static, or memset).
+ * 
  * @param[in] cli : Pointer to cli handle struct.
  * 
  * @return cli_status_t
@@ -72,6 +75,61 @@ cli_status_t cli_deinit(cli_t *cli);
  */
 cli_status_t cli_process(cli_t *cli);
 
+/*!
+ * @brief This API tokenises and executes one command line, e.g. from a script
+ *        file or a socket rather than cli_put.
+ * 
+ * The line is split in place (see cli_tokenize) and argv points into it.
+ * 
+ * @param[in]     cli  : Pointer to cli handle struct.
+ * @param[in,out] line : NUL terminated command line, modified.
+ * 
+ * @return cli_status_t
+ */
+cli_status_t cli_exec(cli_t *cli, char *line);
+
+/*!
+ * @brief This API looks a command up by its full name. Unknown names are
+ *        reported on the CLI, with the commands they are a prefix of.
+ * 
+ * @param[in] cli  : Pointer to cli handle struct.
+ * @param[in] name : Command name or prefix.
+ * 
+ * @return const cmd_t* the command, NULL if there is no single match.
+ */
+const cmd_t *cli_resolve(cli_t *cli, const char *name);
+
+/*!
+ * @brief This API checks the argument count against the command and runs it.
+ *        With cli_resolve, lets a caller look a command up once and run it often.
+ * 
+ * @param[in] cli  : Pointer to cli handle struct.
+ * @param[in] cmd  : The command.
+ * @param[in] argc : Number of arguments, including the command name.
+ * @param[in] argv : The arguments.
+ * 
+ * @return cli_status_t CLI_E_INVALID_ARGS on a bad argument count, otherwise the command's result.
+ */
+cli_status_t cli_call(cli_t *cli, const cmd_t *cmd, int argc, char **argv);
+
+/*!
+ * @brief This API splits a line into arguments in place. Re-entrant, no copies.
+ * 
+ * Arguments are separated by spaces or tabs. Single quotes keep everything up
+ * to the closing quote; double quotes group words but still allow the escapes
+ * \n, \r, \t, \xHH (non-zero byte) and \<char>, which also work unquoted.
+ * Each argv entry points into line, which is NUL terminated per argument.
+ * 
+ * @param[in,out] line     : NUL terminated command line, modified.
+ * @param[out]    argc     : Number of arguments found.
+ * @param[out]    argv     : Filled with pointers into line.
+ * @param[in]     max_args : Size of argv.
+ * 
+ * @return cli_status_t CLI_E_BUF_FULL for too many arguments, CLI_E_INVALID_ARGS
+ *         for an unterminated quote or bad escape.
+ */
+cli_status_t cli_tokenize(char *line, int *argc, char **argv, int max_args);
+
 /*!
  * @brief This API should be called from the devices interrupt handler whenever a
  *        character is received over the input stream.
@@ -83,6 +141,59 @@ cli_status_t cli_process(cli_t *cli);
  */
 cli_status_t cli_put(cli_t *cli, char c);
 
+/*!
+ * @brief This API adds a command. The command struct must stay valid (usually static const).
+ * 
+ * @param[in] cli : Pointer to cli handle struct.
+ * @param[in] cmd : The command.
+ * 
+ * @return cli_status_t CLI_E_INVALID_ARGS if the name is taken, CLI_E_BUF_FULL if the table is full.
+ */
+cli_status_t cli_register(cli_t *cli, const cmd_t *cmd);
+
+/*!
+ * @brief This API adds a table of commands.
+ * 
+ * @param[in] cli : Pointer to cli handle struct.
+ * @param[in] tbl : The commands.
+ * @param[in] cnt : Number of commands in tbl.
+ * 
+ * @return cli_status_t the first error, CLI_OK if all were added.
+ */
+cli_status_t cli_register_table(cli_t *cli, const cmd_t *tbl, size_t cnt);
+
+/*!
+ * @brief This API looks up a command by its full name.
+ * 
+ * @param[in] cli  : Pointer to cli handle struct.
+ * @param[in] name : Command name.
+ * 
+ * @return const cmd_t* the command, NULL if there is none.
+ */
+const cmd_t *cli_find(const cli_t *cli, const char *name);
+
+/*!
+ * @brief This API finds the commands starting with a prefix, in name order.
+ * 
+ * @param[in]  cli     : Pointer to cli handle struct.
+ * @param[in]  prefix  : Start of a command name.
+ * @param[out] matches : Filled with up to max matching commands, may be NULL.
+ * @param[in]  max     : Size of matches.
+ * 
+ * @return size_t number of matching commands (can be more than max).
+ */
+size_t cli_complete(const cli_t *cli, const char *prefix, const cmd_t **matches, size_t max);
+
+/*!
+ * @brief This API returns a registered command, in name order, for listing them.
+ * 
+ * @param[in] cli   : Pointer to cli handle struct.
+ * @param[in] index : 0 to the number of commands - 1.
+ * 
+ * @return const cmd_t* the command, NULL past the end.
+ */
+const cmd_t *cli_get_cmd(const cli_t *cli, size_t index);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,100 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        cli_args.c
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file cli_args.c
+ * @brief Argument parsing helpers for command functions.
+ */
+#include "cli_args.h"
+#include <ctype.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/*!
+ * @brief Parse an unsigned number with an optional k or M multiplier.
+ */
+bool cli_parse_u64(const char *str, uint64_t *value)
+{
+    char *end;
+
+    if ((NULL == str) || (NULL == value) || (str[0] == '-'))
+        return false;
+
+    *value = strtoull(str, &end, 0);
+    if (end == str)
+        return false;
+
+    if (*end == 'k' || *end == 'K') {
+        *value *= 1000ULL;
+        end++;
+    }
+    else if (*end == 'M') {
+        *value *= 1000000ULL;
+        end++;
+    }
+
+    return (*end == '\0');
+}
+
+static uint8_t hex_nibble(char c)
+{
+    return (uint8_t)(isdigit((unsigned char)c) ? (c - '0') : (tolower((unsigned char)c) - 'a' + 10));
+}
+
+/*!
+ * @brief Append the bytes of a hex string to out.
+ */
+bool cli_parse_hex(const char *str, uint8_t *out, size_t max, size_t *len)
+{
+    size_t digits;
+
+    if ((NULL == str) || (NULL == out) || (NULL == len))
+        return false;
+
+    if ((str[0] == '0') && (str[1] == 'x' || str[1] == 'X')) {
+        str += 2;
+    }
+
+    digits = strlen(str);
+    if ((digits == 0) || (digits % 2 != 0) || ((*len + digits / 2) > max))
+        return false;
+
+    /* Check every digit first so a bad string leaves out and len untouched */
+    for (size_t i = 0; i < digits; i++) {
+        if (!isxdigit((unsigned char)str[i]))
+            return false;
+    }
+
+    for (size_t i = 0; i < digits; i += 2) {
+        out[*len + i / 2] = (uint8_t)((hex_nibble(str[i]) << 4) | hex_nibble(str[i + 1]));
+    }
+    *len += digits / 2;
+
+    return true;
+}
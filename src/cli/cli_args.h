@@ -0,0 +1,70 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2019 Sean Farrelly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        cli_args.h
+ * Created by  Sean Farrelly
+ * Version     1.0
+ * 
+ */
+
+/*! @file cli_args.h
+ * @brief Argument parsing helpers for command functions.
+ */
+#ifndef _CLI_ARGS_H_
+#define _CLI_ARGS_H_
+
+/*! CPP guard */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ * @brief Parse an unsigned decimal (or 0x hex) number with an optional k or M multiplier.
+ * 
+ * @param[in]  str   : The argument.
+ * @param[out] value : The number.
+ * 
+ * @return true if the whole argument was a number.
+ */
+bool cli_parse_u64(const char *str, uint64_t *value);
+
+/*!
+ * @brief Append the bytes of a hex string (optionally 0x prefixed) to out.
+ * 
+ * @param[in]     str : The argument, an even number of hex digits.
+ * @param[out]    out : Byte buffer.
+ * @param[in]     max : Size of out.
+ * @param[in,out] len : Bytes already in out, updated.
+ * 
+ * @return true if the string was valid and fitted.
+ */
+bool cli_parse_hex(const char *str, uint8_t *out, size_t max, size_t *len);
+
+#ifdef __cplusplus
+}
+#endif /* End of CPP guard */
+#endif /* _CLI_ARGS_H_ */
@@ -5,9 +5,13 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-#define MAX_ARGS            30
+#define MAX_ARGS            30      /* Most tokens in a line, command name included */
 #define CMD_TERMINATOR      '\n'    /* Delimitor denoting end of cmd */
 
+#define CLI_MAX_CMDS        64      /* Commands that can be registered */
+#define CLI_HASH_SLOTS      128     /* Lookup table size, power of 2 and at least 2x CLI_MAX_CMDS */
+#define CLI_ARGS_ANY        0xFF    /* max_args value for no upper limit */
+
 typedef enum
 {
     CLI_OK,                 /* API execution successful.                */
@@ -30,11 +34,24 @@ typedef void (*println_func_ptr_t)(const char * format, ...);
  */
 typedef struct
 {
-    char *cmd;           /* Command name.                            */
-    cmd_func_ptr_t func; /* Function pointer to associated function. */
-    char *help_text;    /* Help text.                                */
+    const char *cmd;        /* Command name.                                        */
+    cmd_func_ptr_t func;    /* Function pointer to associated function.             */
+    const char *help_text;  /* Help text, printed as is by help and on bad args.    */
+    uint8_t min_args;       /* Fewest arguments after the name.                     */
+    uint8_t max_args;       /* Most arguments after the name, 0 with min 0 = any.   */
 } cmd_t;
 
+/*!
+ * @brief Struct for holding received data
+ */
+typedef struct
+{
+    uint8_t *buf_ptr;               /* Start of the Rx byte-buffer */
+    uint16_t buf_size;              /* Size of buffer */
+    uint16_t current_buf_length;    /* Current length of buffer */
+    bool is_ready;                  /* Is a command fully received and ready to be processed */
+} rx_data_t;
+
 /*!
  * @brief Command-line interface handle structure.
  */
@@ -43,17 +60,13 @@ typedef struct
     println_func_ptr_t println; /* Function pointer to user defined println function.      */
     cmd_t *cmd_tbl;             /* Pointer to series of commands which are to be accepted. */
     size_t cmd_cnt;             /* Number of commands in cmd_tbl.                          */
+    rx_data_t rx;               /* Line being received, set up by cli_init.                */
+
+    /* Registered commands. cli_init registers cmd_tbl here, modules add their own. */
+    const cmd_t *cmds[CLI_MAX_CMDS];        /* Sorted by name, for help and completion.     */
+    size_t reg_cnt;                         /* Number of registered commands.               */
+    const cmd_t *hash[CLI_HASH_SLOTS];      /* Open addressed name lookup.                  */
 } cli_t;
 
-/*!
- * @brief Struct for holding received data
- */
-typedef struct
-{
-    uint8_t *buf_ptr;               /* Pointer to Rx byte-buffer */
-    uint16_t buf_size;              /* Size of buffer */
-    uint16_t current_buf_length;    /* Current length of buffer */
-    bool is_ready;                  /* Is a command fully received and ready to be processed */
-} rx_data_t;
 
 #endif
\ No newline at end of file
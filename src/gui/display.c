@@ -0,0 +1,270 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        display.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#include "display.h"
+#include "../lv_drv_conf.h"
+#include "../lvgl/lvgl.h"
+#include "../log/log.h"
+#include "../stats/profiler.h"
+#include "../time_funcs/time_funcs.h"
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+#if LV_COLOR_DEPTH == 32
+#define DISPLAY_PIXEL_FORMAT SDL_PIXELFORMAT_ARGB8888
+#elif LV_COLOR_DEPTH == 16
+#define DISPLAY_PIXEL_FORMAT SDL_PIXELFORMAT_RGB565
+#else
+#error "display: LV_COLOR_DEPTH must be 16 or 32"
+#endif
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+static SDL_Window *window = NULL;
+static SDL_Renderer *renderer = NULL;
+
+/* Holds the whole screen between frames, only dirty areas are updated */
+static SDL_Texture *texture = NULL;
+
+static lv_color_t *draw_bufs[2] = { NULL, NULL };
+static lv_disp_draw_buf_t disp_draw_buf;
+static lv_disp_drv_t disp_drv;
+static lv_indev_drv_t indev_drv;
+
+static lv_coord_t mouse_x = 0;
+static lv_coord_t mouse_y = 0;
+static bool mouse_pressed = false;
+
+static display_stats_t stats;
+
+/* Bytes uploaded so far in the frame being flushed */
+static uint64_t pending_bytes = 0;
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief LVGL flush callback: upload one rendered area into the texture.
+ */
+static void flush_area(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p);
+
+/**
+ * @brief Draw the texture to the window.
+ */
+static void present(void);
+
+/**
+ * @brief LVGL input callback for the mouse.
+ */
+static void mouse_read(lv_indev_drv_t *drv, lv_indev_data_t *data);
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+bool display_init(uint32_t buf_lines, uint32_t buf_count)
+{
+    const size_t buf_px = (size_t)SDL_HOR_RES * buf_lines;
+
+    if ((0 == buf_lines) || (buf_lines > SDL_VER_RES) || (0 == buf_count) || (buf_count > 2)) {
+        log_error("display: invalid draw buffers (%u lines x %u)\n", buf_lines, buf_count);
+        return false;
+    }
+
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        log_error("display: SDL_Init failed: %s\n", SDL_GetError());
+        return false;
+    }
+
+    window = SDL_CreateWindow("serial_tool", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                              SDL_HOR_RES * SDL_ZOOM, SDL_VER_RES * SDL_ZOOM, SDL_WINDOW_SHOWN);
+    renderer = (NULL != window) ? SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED) : NULL;
+    texture = (NULL != renderer) ? SDL_CreateTexture(renderer, DISPLAY_PIXEL_FORMAT, SDL_TEXTUREACCESS_STREAMING,
+                                                     SDL_HOR_RES, SDL_VER_RES) : NULL;
+    if (NULL == texture) {
+        log_error("display: can't create the window: %s\n", SDL_GetError());
+        display_deinit();
+        return false;
+    }
+
+    /* Scales the texture and the mouse coordinates by SDL_ZOOM */
+    SDL_RenderSetLogicalSize(renderer, SDL_HOR_RES, SDL_VER_RES);
+
+    for (uint32_t i = 0; i < buf_count; i++) {
+        draw_bufs[i] = malloc(buf_px * sizeof(lv_color_t));
+        if (NULL == draw_bufs[i]) {
+            log_error("display: can't allocate a %u line draw buffer\n", buf_lines);
+            display_deinit();
+            return false;
+        }
+    }
+
+    lv_disp_draw_buf_init(&disp_draw_buf, draw_bufs[0], draw_bufs[1], (uint32_t)buf_px);
+
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.draw_buf = &disp_draw_buf;
+    disp_drv.flush_cb = flush_area;
+    disp_drv.hor_res = SDL_HOR_RES;
+    disp_drv.ver_res = SDL_VER_RES;
+    lv_disp_drv_register(&disp_drv);
+
+    lv_indev_drv_init(&indev_drv);
+    indev_drv.type = LV_INDEV_TYPE_POINTER;
+    indev_drv.read_cb = mouse_read;
+    lv_indev_drv_register(&indev_drv);
+
+    stats = (display_stats_t){0};
+    pending_bytes = 0;
+
+    return true;
+}
+
+void display_deinit(void)
+{
+    if (NULL != texture) {
+        SDL_DestroyTexture(texture);
+        texture = NULL;
+    }
+    if (NULL != renderer) {
+        SDL_DestroyRenderer(renderer);
+        renderer = NULL;
+    }
+    if (NULL != window) {
+        SDL_DestroyWindow(window);
+        window = NULL;
+    }
+    SDL_Quit();
+
+    for (uint32_t i = 0; i < 2; i++) {
+        free(draw_bufs[i]);
+        draw_bufs[i] = NULL;
+    }
+}
+
+void display_poll_events(void)
+{
+    SDL_Event event;
+
+    while (SDL_PollEvent(&event)) {
+        switch (event.type)
+        {
+        case SDL_MOUSEMOTION:
+            mouse_x = (lv_coord_t)event.motion.x;
+            mouse_y = (lv_coord_t)event.motion.y;
+            break;
+
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            if (SDL_BUTTON_LEFT == event.button.button) {
+                mouse_pressed = (SDL_MOUSEBUTTONDOWN == event.type);
+                mouse_x = (lv_coord_t)event.button.x;
+                mouse_y = (lv_coord_t)event.button.y;
+            }
+            break;
+
+        case SDL_WINDOWEVENT:
+            /* The texture still holds the whole screen, no need to redraw it */
+            if ((SDL_WINDOWEVENT_EXPOSED == event.window.event) ||
+                (SDL_WINDOWEVENT_SIZE_CHANGED == event.window.event)) {
+                present();
+            }
+            break;
+
+        case SDL_QUIT:
+            /* Closing the window ends the program, as with the lv_drivers SDL driver */
+            exit(0);
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+void display_get_stats(display_stats_t *out)
+{
+    if (NULL != out) {
+        *out = stats;
+    }
+}
+
+static void flush_area(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    uint64_t start = now_cycles();
+    SDL_Rect rect = {
+        .x = area->x1,
+        .y = area->y1,
+        .w = lv_area_get_width(area),
+        .h = lv_area_get_height(area),
+    };
+    uint64_t bytes = (uint64_t)rect.w * (uint64_t)rect.h * sizeof(lv_color_t);
+
+    /* The draw buffer holds just this area, row after row */
+    SDL_UpdateTexture(texture, &rect, color_p, rect.w * (int)sizeof(lv_color_t));
+    pending_bytes += bytes;
+
+    /* Show the frame once its last dirty area is in */
+    if (lv_disp_flush_is_last(drv)) {
+        present();
+        stats.frames++;
+        stats.frame_bytes = pending_bytes;
+        pending_bytes = 0;
+    }
+
+    /* Synchronous, LVGL renders the next band only after this returns */
+    lv_disp_flush_ready(drv);
+
+    uint64_t elapsed = now_cycles() - start;
+    stats.flushes++;
+    stats.bytes += bytes;
+    stats.cycles += elapsed;
+    profiler_record(PROF_STAGE_FLUSH, elapsed, bytes);
+}
+
+static void present(void)
+{
+    SDL_RenderCopy(renderer, texture, NULL, NULL);
+    SDL_RenderPresent(renderer);
+}
+
+static void mouse_read(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    (void)drv;
+
+    data->point.x = mouse_x;
+    data->point.y = mouse_y;
+    data->state = mouse_pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+}
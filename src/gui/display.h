@@ -0,0 +1,110 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        display.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#ifndef DISPLAY_H_
+#define DISPLAY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Rows in each partial draw buffer. LVGL renders the dirty areas in bands
+ * of at most this many rows, so smaller buffers mean more, smaller flushes. */
+#ifndef DISPLAY_BUF_LINES
+#define DISPLAY_BUF_LINES   96U
+#endif
+
+/* Number of draw buffers. The flush uploads to the texture and calls
+ * lv_disp_flush_ready() before returning, so LVGL never has a flush pending
+ * to render past and a second buffer would only cost memory. 2 is only worth
+ * it with a flush that completes later, e.g. from a DMA or upload thread. */
+#ifndef DISPLAY_BUF_COUNT
+#define DISPLAY_BUF_COUNT   1U
+#endif
+
+/*****************************************************************************
+ * Structs, Unions, Enums, & Typedefs
+ *****************************************************************************/
+
+/**
+ * @brief Flush counters since display_init(). Totals only grow.
+ */
+typedef struct display_stats_t {
+    uint64_t frames;        /**< Frames presented (frames with nothing to redraw don't count) */
+    uint64_t flushes;       /**< Dirty areas uploaded */
+    uint64_t bytes;         /**< Pixel bytes uploaded */
+    uint64_t cycles;        /**< Time spent flushing, in now_cycles() units */
+    uint64_t frame_bytes;   /**< Pixel bytes uploaded by the last presented frame */
+} display_stats_t;
+
+/*****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Open the window and register it with LVGL as the display and a mouse.
+ *
+ * Only the areas LVGL redraws are uploaded to the window texture, straight
+ * from the draw buffer; the full screen is never copied. Must be called on
+ * the thread that runs LVGL, after lv_init().
+ *
+ * @param buf_lines rows in each draw buffer (DISPLAY_BUF_LINES)
+ * @param buf_count 1 or 2 draw buffers (DISPLAY_BUF_COUNT), 2 only helps an asynchronous flush
+ * @return true if the window and buffers were created
+ */
+bool display_init(uint32_t buf_lines, uint32_t buf_count);
+
+/**
+ * @brief Close the window and free the draw buffers.
+ */
+void display_deinit(void);
+
+/**
+ * @brief Handle window and mouse events. Call once per frame, before lv_timer_handler().
+ */
+void display_poll_events(void);
+
+/**
+ * @brief Get the flush counters.
+ *
+ * @param stats filled in with the current totals
+ */
+void display_get_stats(display_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* DISPLAY_H_ */
@@ -28,12 +28,28 @@
  */
 
 #include "gui.h"
+#include "led.h"
+#include "display.h"
+#include "hex_view.h"
+#include "plot.h"
 #include "../time_funcs/time_funcs.h"
+#include "../time_funcs/timer_wheel.h"
+#include "../log/log.h"
+#include "../trace/trace.h"
+#include "../stats/profiler.h"
+#include "../stats/metrics.h"
 #include "../lvgl/lvgl.h"
-#include "../lv_drivers/sdl/sdl.h"
 #include "../ui/ui.h"
 #include <stdio.h>
-#include "../buffer/ring_buf.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <errno.h>
+#include "../buffer/mpsc_queue.h"
+#include "../buffer/history.h"
+#include "../buffer/chunk_pool.h"
 
 
 /****************************************************************************
@@ -42,52 +58,552 @@
 
 #define PLOT_DATA_ELEMENTS 100U
 
+/* LV_CHART_UPDATE_MODE_SHIFT scrolls like a strip chart, drawing plot_data as a
+ * ring from the series' start point. LV_CHART_UPDATE_MODE_CIRCULAR sweeps over the
+ * old data like an oscilloscope, drawing plot_data from index 0 with the start
+ * point only marking the write position. */
+#ifndef GUI_CHART_UPDATE_MODE
+#define GUI_CHART_UPDATE_MODE LV_CHART_UPDATE_MODE_SHIFT
+#endif
+
+/* 1 draws the received bytes with the min/max column plot in place of
+ * ui_Chart1, 0 keeps lv_chart. The chart is also the fallback if the plot
+ * can't be created. */
+#ifndef GUI_USE_PLOT
+#define GUI_USE_PLOT 1
+#endif
+
+/* Bytes converted to plot samples and pushed in one go */
+#define GUI_PLOT_BATCH 64U
+
+/* Bytes per plot column at the slider's widest zoom (LV_IMG_ZOOM_NONE).
+ * Zooming in to GUI_PLOT_MAX_SPP x gets down to one byte per column. */
+#define GUI_PLOT_MAX_SPP 10U
+
+/* Messages waiting for the GUI thread, must be a power of two */
+#define GUI_QUEUE_SIZE 1024U
+
+/* RX chunks the GUI thread may hold at once, a quarter of the serial RX
+ * pool. Past this the chart misses the chunk (the history still has it),
+ * so a stalled GUI can never take the chunks the serial reader needs. */
+#define GUI_MAX_CHUNKS 64U
+
+/* Bytes of the text area fallback appended in one go */
+#define GUI_TEXT_BYTES 64U
+
+/* Share of each frame period the GUI thread may be busy. A frame that
+ * takes longer pushes the next one back, so rendering never takes more of
+ * a core than this however much data arrives. */
+#define GUI_CPU_BUDGET_PCT 50U
+
+/* Received bytes kept for scrolling back, in chunks. The oldest chunk is
+ * dropped once the cap is reached. */
+#ifndef GUI_HISTORY_MAX_BYTES
+#define GUI_HISTORY_MAX_BYTES (16U * 1024U * 1024U)
+#endif
+#define GUI_HISTORY_CHUNK_SIZE (64U * 1024U)
+
+/* Messages applied between two looks at the clock while draining */
+#define GUI_DRAIN_CHECK_EVERY 32U
+
+/**
+ * @brief What a message asks the GUI thread to do.
+ */
+typedef enum gui_msg_type_t {
+    GUI_MSG_CHUNK,      /**< Append every rx.step-th byte of rx.chunk to the chart (and the text area if there's no hex view) */
+    GUI_MSG_INFO_TEXT,  /**< Show (or hide if NULL) the info label, text is freed by the GUI thread */
+    GUI_MSG_PERF_TEXT,  /**< Show (or hide if NULL) the perf label, text is freed by the GUI thread */
+    GUI_MSG_STATUS_TEXT,/**< Show (or hide if NULL) the status label, text is freed by the GUI thread */
+    GUI_MSG_LED,        /**< Change the mode of an LED */
+    GUI_MSG_FREEZE,     /**< Freeze the hex view if len is non-zero, else follow the data again */
+} gui_msg_type_t;
+
+/**
+ * @brief An update posted to the GUI thread.
+ */
+typedef struct gui_msg_t {
+    uint8_t type;
+    uint8_t len;
+    union {
+        char *text;
+        struct {
+            chunk_t *chunk;
+            uint32_t step;
+        } rx;
+        struct {
+            uint32_t index;
+            uint32_t mode;
+            uint32_t period;
+            float duty;
+        } led;
+    };
+} gui_msg_t;
+
 /****************************************************************************
  * Variables
  *****************************************************************************/
 
-static uint32_t task_period;
-static uint64_t next_task_tick;
+/* Frames per second aimed for while the GUI keeps up */
+static atomic_uint target_fps = GUI_DEFAULT_FPS;
 
-static lv_chart_series_t *chart_series;
+/* Frame scheduler counters, written by the GUI thread */
+static atomic_uint_fast64_t frames_drawn = 0;
+static atomic_uint_fast64_t frames_skipped = 0;
+static atomic_uint_fast64_t frames_merged = 0;
+static atomic_uint_fast64_t frames_stretched = 0;
+
+/* Nothing may post before gui_init(), e.g. when running headless */
+static bool gui_ready = false;
+
+/* Every byte posted, written by the gui_post_chunk() caller and read by the GUI thread */
+static history_t history;
 
-static ring_buf_t plot_buffer;
+/* Set by the GUI thread when it has frozen the hex view */
+static atomic_bool view_frozen = false;
+
+/* Chunk references held by queued messages, and chunks dropped at the cap */
+static atomic_uint chunks_held = 0;
+static atomic_uint_fast64_t chunks_dropped = 0;
+
+static pthread_t gui_thread;
+static atomic_bool gui_running = false;
+
+/* The GUI thread reports whether LVGL and the display came up */
+static pthread_mutex_t start_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t start_cond = PTHREAD_COND_INITIALIZER;
+static int start_result = 0;
+
+static mpsc_queue_t queue;
+static gui_msg_t queue_msgs[GUI_QUEUE_SIZE];
+static atomic_size_t queue_seq[GUI_QUEUE_SIZE];
+
+/* Everything below belongs to the GUI thread */
+
+/* LED flashing and breathing steps */
+static timer_wheel_t wheel;
+
+/* The chart draws straight from plot_data, chart_series->start_point is the write index */
+static lv_chart_series_t *chart_series;
 static lv_coord_t plot_data[PLOT_DATA_ELEMENTS];
-static uint32_t plot_data_index = 0;
+
+/* Takes the place of ui_Chart1, NULL if it couldn't be created */
+static plot_t *plot = NULL;
+
+/* Takes the place of ui_TextArea1, NULL if it couldn't be created */
+static hex_view_t *hex_view = NULL;
+
+/* A screenful of history while scrubbing, bytes_per_row * rows of the hex view */
+static uint8_t *view_bytes = NULL;
+
+/* What ui_Slider1 was set to before it became the scrub bar */
+static int32_t live_slider_min;
+static int32_t live_slider_max;
+static int32_t live_slider_value;
+
+static lv_obj_t *info_label = NULL;
+static lv_obj_t *perf_label = NULL;
+static lv_obj_t *status_label = NULL;
+
+/* Display totals at the end of the last frame */
+static display_stats_t last_display;
+
+static metric_t *frame_time_metric;
+static metric_t *flush_bytes_metric;
+static metric_t *frame_flush_bytes_metric;
 
 /****************************************************************************
  * Prototypes
  *****************************************************************************/
 
+/**
+ * @brief GUI thread: bring up LVGL, then drain the queue and run a frame until stopped.
+ */
+static void *gui_thread_main(void *arg);
+
+/**
+ * @brief Create the display, the UI and the chart series. Runs on the GUI thread.
+ */
 static bool initialize_gui(void);
 
-static void hal_init(void);
+/**
+ * @brief Apply the messages posted since the last frame, until the deadline.
+ * 
+ * @param deadline_ns get_nanos() time to stop at
+ * @return true if the queue was drained, false if messages were left for the next frame
+ */
+static bool drain_messages(uint64_t deadline_ns);
+
+/**
+ * @brief Run the LVGL timers (input, animations, redraw).
+ */
+static void run_frame(void);
+
+/**
+ * @brief Make LVGL redraw on every frame the scheduler runs, rather than on its own LV_DISP_DEF_REFR_PERIOD.
+ */
+static void follow_frame_rate(void);
+
+static void sleep_until(uint64_t when_ns);
+
+/**
+ * @brief Put a hex view where ui_TextArea1 is and hide the text area.
+ */
+static void create_hex_view(void);
+
+/**
+ * @brief Put the plot in ui_Chart1's place if GUI_USE_PLOT is set.
+ */
+static void create_plot(void);
+
+/**
+ * @brief Freeze the hex view (slider scrubs the history) or follow the data again.
+ */
+static void set_view_frozen(bool frozen);
+
+/**
+ * @brief Show a screenful of history in the hex view.
+ * 
+ * @param pos 0 for the oldest bytes held up to GUI_SCRUB_STEPS for the newest
+ */
+static void show_history(int32_t pos);
+
+/**
+ * @brief Append whatever the history holds past the end of the hex view.
+ */
+static void follow_history(void);
+
+static void show_bytes(const uint8_t *data, size_t len, uint32_t step);
+
+/**
+ * @brief Give back a chunk reference taken by gui_post_chunk().
+ */
+static void release_chunk(chunk_t *chunk);
+
+static void set_overlay_text(lv_obj_t **label, lv_align_t align, lv_coord_t x_ofs, lv_coord_t y_ofs, const char *text);
+
+static void post_text(gui_msg_type_t type, const char *text);
 
 static void _ui_textarea_append_text(lv_obj_t *textarea, const char *text);
 
+static lv_obj_t *create_overlay_label(lv_align_t align, lv_coord_t x_ofs, lv_coord_t y_ofs);
+
+static uint64_t read_dropped(void);
+static uint64_t read_frames(void);
+static uint64_t read_skipped(void);
+static uint64_t read_merged(void);
+
 /****************************************************************************
  * Functions
  *****************************************************************************/
 
-bool gui_init(uint32_t process_period)
+bool gui_init(uint32_t fps)
+{
+    gui_set_target_fps(fps);
+
+    if (!mpsc_queue_init(&queue, queue_msgs, queue_seq, GUI_QUEUE_SIZE, sizeof(gui_msg_t))) {
+        return false;
+    }
+
+    if (!history_init(&history, GUI_HISTORY_CHUNK_SIZE, GUI_HISTORY_MAX_BYTES)) {
+        log_error("gui: can't create the history\n");
+        return false;
+    }
+
+    /* The registry isn't thread safe, register before the thread starts */
+    frame_time_metric = metrics_histogram("gui_frame_seconds", "Time spent in one GUI frame (messages and lv_timer_handler)");
+    flush_bytes_metric = metrics_counter("gui_flush_bytes_total", "Pixel bytes uploaded to the window");
+    frame_flush_bytes_metric = metrics_gauge("gui_frame_flush_bytes", "Pixel bytes uploaded by the last drawn frame");
+    metrics_register_fn("gui_dropped_messages_total", "GUI updates dropped because the GUI thread fell behind",
+                        METRIC_COUNTER, read_dropped);
+    metrics_register_fn("gui_frames_total", "GUI frames run", METRIC_COUNTER, read_frames);
+    metrics_register_fn("gui_frames_skipped_total", "GUI frames skipped because the previous one overran",
+                        METRIC_COUNTER, read_skipped);
+    metrics_register_fn("gui_frames_merged_total", "GUI frames that left updates for the next frame",
+                        METRIC_COUNTER, read_merged);
+
+    start_result = 0;
+    atomic_store(&gui_running, true);
+    if (pthread_create(&gui_thread, NULL, gui_thread_main, NULL) != 0) {
+        log_error("gui: can't create the GUI thread\n");
+        atomic_store(&gui_running, false);
+        return false;
+    }
+
+    /* Wait for the display so a failure can still stop the app */
+    pthread_mutex_lock(&start_lock);
+    while (0 == start_result) {
+        pthread_cond_wait(&start_cond, &start_lock);
+    }
+    pthread_mutex_unlock(&start_lock);
+
+    if (start_result < 0) {
+        pthread_join(gui_thread, NULL);
+        atomic_store(&gui_running, false);
+        history_deinit(&history);
+        return false;
+    }
+
+    gui_ready = true;
+    return true;
+}
+
+void gui_deinit(void)
+{
+    if (!gui_ready)
+        return;
+
+    gui_ready = false;
+    atomic_store(&gui_running, false);
+    pthread_join(gui_thread, NULL);
+    history_deinit(&history);
+}
+
+void gui_set_target_fps(uint32_t fps)
+{
+    if (fps < GUI_MIN_FPS) {
+        fps = GUI_MIN_FPS;
+    }
+    else if (fps > GUI_MAX_FPS) {
+        fps = GUI_MAX_FPS;
+    }
+    atomic_store_explicit(&target_fps, fps, memory_order_relaxed);
+}
+
+uint32_t gui_get_target_fps(void)
+{
+    return atomic_load_explicit(&target_fps, memory_order_relaxed);
+}
+
+void gui_get_frame_stats(gui_frame_stats_t *stats)
+{
+    if (NULL == stats)
+        return;
+
+    stats->frames = atomic_load_explicit(&frames_drawn, memory_order_relaxed);
+    stats->skipped = atomic_load_explicit(&frames_skipped, memory_order_relaxed);
+    stats->merged = atomic_load_explicit(&frames_merged, memory_order_relaxed);
+    stats->stretched = atomic_load_explicit(&frames_stretched, memory_order_relaxed);
+}
+
+bool gui_post_chunk(chunk_t *chunk, uint32_t step)
+{
+    gui_msg_t msg;
+
+    if (!gui_ready || (NULL == chunk))
+        return true;
+
+    history_append(&history, chunk->data, chunk->len);
+
+    if (atomic_load_explicit(&chunks_held, memory_order_relaxed) >= GUI_MAX_CHUNKS) {
+        atomic_fetch_add_explicit(&chunks_dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    /* The GUI thread releases its reference once the chart has the bytes */
+    chunk_ref(chunk);
+    atomic_fetch_add_explicit(&chunks_held, 1, memory_order_relaxed);
+    msg.type = GUI_MSG_CHUNK;
+    msg.len = 0;
+    msg.rx.chunk = chunk;
+    msg.rx.step = (step == 0) ? 1 : step;
+
+    /* A full queue drops the chunk, the queue counts it */
+    if (!mpsc_queue_push(&queue, &msg)) {
+        release_chunk(chunk);
+        return false;
+    }
+
+    return true;
+}
+
+void gui_set_frozen(bool frozen)
+{
+    gui_msg_t msg;
+
+    if (!gui_ready)
+        return;
+
+    msg.type = GUI_MSG_FREEZE;
+    msg.len = frozen ? 1U : 0U;
+    mpsc_queue_push(&queue, &msg);
+}
+
+bool gui_is_frozen(void)
+{
+    return atomic_load_explicit(&view_frozen, memory_order_relaxed);
+}
+
+void gui_scrub(int32_t pos)
+{
+    if (gui_is_frozen()) {
+        show_history(pos);
+    }
+}
+
+void gui_zoom_x(int32_t zoom)
+{
+    if (NULL == plot) {
+        lv_chart_set_zoom_x(ui_Chart1, (uint16_t)zoom);
+        return;
+    }
+
+    /* Zooming in puts fewer bytes in each column */
+    uint32_t spp = (GUI_PLOT_MAX_SPP * LV_IMG_ZOOM_NONE) / (uint32_t)((zoom > 0) ? zoom : 1);
+    plot_set_decimation(plot, (spp > 0) ? spp : 1);
+}
+
+void gui_zoom_y(int32_t zoom)
+{
+    if (NULL == plot) {
+        lv_chart_set_zoom_y(ui_Chart1, (uint16_t)zoom);
+        return;
+    }
+
+    /* Zooming in shows the bottom of the byte range, as the chart does */
+    int32_t top = (255 * LV_IMG_ZOOM_NONE) / ((zoom > 0) ? zoom : 1);
+    plot_set_range(plot, 0, (top > 0) ? top : 1);
+}
+
+void gui_set_info_text(const char *text)
+{
+    post_text(GUI_MSG_INFO_TEXT, text);
+}
+
+void gui_set_perf_text(const char *text)
+{
+    post_text(GUI_MSG_PERF_TEXT, text);
+}
+
+void gui_set_status_text(const char *text)
+{
+    post_text(GUI_MSG_STATUS_TEXT, text);
+}
+
+void gui_set_led(uint32_t index, uint32_t mode, uint32_t period, float duty)
+{
+    gui_msg_t msg;
+
+    if (!gui_ready)
+        return;
+
+    msg.type = GUI_MSG_LED;
+    msg.len = 0;
+    msg.led.index = index;
+    msg.led.mode = mode;
+    msg.led.period = period;
+    msg.led.duty = duty;
+    mpsc_queue_push(&queue, &msg);
+}
+
+static void *gui_thread_main(void *arg)
+{
+    (void)arg;
+
+    TRACE_THREAD_NAME("gui");
+
+    timer_wheel_init(&wheel, NSEC_PER_MSEC, get_nanos());
+    led_init(&wheel);
+
+    bool ok = initialize_gui();
+
+    pthread_mutex_lock(&start_lock);
+    start_result = ok ? 1 : -1;
+    pthread_cond_signal(&start_cond);
+    pthread_mutex_unlock(&start_lock);
+
+    if (!ok) {
+        return NULL;
+    }
+
+    uint64_t next_frame = get_nanos();
+
+    while (atomic_load_explicit(&gui_running, memory_order_relaxed)) {
+        sleep_until(next_frame);
+
+        uint64_t period_ns = NSEC_PER_SEC / atomic_load_explicit(&target_fps, memory_order_relaxed);
+        const uint64_t budget_ns = (period_ns * GUI_CPU_BUDGET_PCT) / 100U;
+
+        uint64_t start = get_nanos();
+
+        TRACE_BEGIN("gui_frame");
+        display_poll_events();
+
+        /* Half the budget for updates. Whatever doesn't fit is merged into
+         * the next frame instead of delaying this one. */
+        if (!drain_messages(start + budget_ns / 2U)) {
+            atomic_fetch_add_explicit(&frames_merged, 1, memory_order_relaxed);
+        }
+
+        timer_wheel_advance(&wheel, get_nanos());
+        run_frame();
+        TRACE_END("gui_frame");
+
+        uint64_t now = get_nanos();
+        uint64_t cost = now - start;
+        metrics_observe(frame_time_metric, cost);
+        atomic_fetch_add_explicit(&frames_drawn, 1, memory_order_relaxed);
+
+        /* Frames that are already late are dropped, not drawn back to back */
+        next_frame += period_ns;
+        if (next_frame <= now) {
+            uint64_t missed = (now - next_frame) / period_ns + 1U;
+            next_frame += missed * period_ns;
+            atomic_fetch_add_explicit(&frames_skipped, missed, memory_order_relaxed);
+        }
+
+        /* Over budget: stay away long enough to keep to GUI_CPU_BUDGET_PCT,
+         * the frame rate recovers by itself once frames get cheap again */
+        if (cost > budget_ns) {
+            uint64_t earliest = now + (cost * (100U - GUI_CPU_BUDGET_PCT)) / GUI_CPU_BUDGET_PCT;
+            if (next_frame < earliest) {
+                next_frame = earliest;
+                atomic_fetch_add_explicit(&frames_stretched, 1, memory_order_relaxed);
+            }
+        }
+    }
+
+    /* Free the text and release the chunks of anything still queued */
+    gui_msg_t msg;
+    while (mpsc_queue_pop(&queue, &msg)) {
+        if ((GUI_MSG_INFO_TEXT == msg.type) || (GUI_MSG_PERF_TEXT == msg.type) || (GUI_MSG_STATUS_TEXT == msg.type)) {
+            free(msg.text);
+        }
+        else if (GUI_MSG_CHUNK == msg.type) {
+            release_chunk(msg.rx.chunk);
+        }
+    }
+
+    hex_view_delete(hex_view);
+    hex_view = NULL;
+    free(view_bytes);
+    view_bytes = NULL;
+    plot_delete(plot);
+    plot = NULL;
+
+    display_deinit();
+
+    return NULL;
+}
+
+static bool initialize_gui(void)
 {
-    bool status = true;
+    lv_init();
 
-    task_period = process_period;
-    next_task_tick = get_millis() + task_period;
+    /* The window, the draw buffers and the mouse. The tick comes from SDL_GetTicks (lv_conf.h). */
+    if (!display_init(DISPLAY_BUF_LINES, DISPLAY_BUF_COUNT)) {
+        return false;
+    }
+    follow_frame_rate();
 
-    status = initialize_gui();
+    ui_init();
 
     // create_tab_view();
 
     if (NULL == ui_Chart1){
-        printf("ui_Chart1 doesn't exist\n");
+        log_error("ui_Chart1 doesn't exist\n");
         return false;
     }
 
-    // Initialize the plot buffer
-    ring_buf_init(&plot_buffer, plot_data, PLOT_DATA_ELEMENTS, sizeof(lv_coord_t));
-
     // grab a pointer to the data series in the chart
     chart_series = lv_chart_get_series_next(ui_Chart1, NULL);
 
@@ -97,120 +613,375 @@ bool gui_init(uint32_t process_period)
     }
     
     lv_chart_set_point_count(ui_Chart1, PLOT_DATA_ELEMENTS);
-    lv_chart_series_t *new_series = lv_chart_add_series(ui_Chart1, lv_color_hex(0x00FF00), LV_CHART_AXIS_PRIMARY_Y);
-    lv_chart_set_ext_y_array(ui_Chart1, new_series, plot_data);
+    lv_chart_set_update_mode(ui_Chart1, GUI_CHART_UPDATE_MODE);
+    chart_series = lv_chart_add_series(ui_Chart1, lv_color_hex(0x00FF00), LV_CHART_AXIS_PRIMARY_Y);
+    lv_chart_set_ext_y_array(ui_Chart1, chart_series, plot_data);
 
     lv_chart_refresh(ui_Chart1);
 
-    // // clear the data from the series. Check for null before doing so.
-    // if (chart_series != NULL){
-    //     lv_chart_set_point_count(ui_Chart1, 0);
-    //     lv_chart_set_point_count(ui_Chart1, 100);
-    //     lv_chart_set_update_mode(ui_Chart1, LV_CHART_UPDATE_MODE_CIRCULAR);
-    //     /* The following line causes the text area to disappear and not function... LOL!! */
-    //     // lv_chart_set_all_value(ui_Chart1, chart_series, 0);
-    // }
-    // else{
-    //     chart_series = lv_chart_add_series(ui_Chart1, lv_color_hex(0x00FF00), LV_CHART_AXIS_PRIMARY_Y);
-    //     if (NULL == chart_series){
-    //         printf("chart_series is NULL\n");
-    //         return false;
-    //     }
-    // }
-
-    return status;
-}
-
-void gui_task(void)
-{
-    uint64_t now = get_millis();
-    if (now < next_task_tick){
-        return;
+    create_plot();
+    create_hex_view();
+
+    return true;
+}
+
+static bool drain_messages(uint64_t deadline_ns)
+{
+    gui_msg_t msg;
+    bool chart_changed = false;
+    bool drained = true;
+    uint32_t applied = 0;
+
+    /* Only what is queued now, so a busy producer can't keep the frame from being drawn */
+    size_t count = mpsc_queue_count(&queue);
+
+    while ((count-- > 0) && mpsc_queue_pop(&queue, &msg)) {
+        if ((++applied % GUI_DRAIN_CHECK_EVERY == 0) && (get_nanos() >= deadline_ns)) {
+            drained = (count == 0);
+            count = 0;
+        }
+
+        switch (msg.type)
+        {
+        case GUI_MSG_CHUNK:
+            show_bytes(msg.rx.chunk->data, msg.rx.chunk->len, msg.rx.step);
+            release_chunk(msg.rx.chunk);
+            chart_changed = true;
+            break;
+
+        case GUI_MSG_INFO_TEXT:
+            set_overlay_text(&info_label, LV_ALIGN_TOP_RIGHT, -10, 10, msg.text);
+            free(msg.text);
+            break;
+
+        case GUI_MSG_PERF_TEXT:
+            set_overlay_text(&perf_label, LV_ALIGN_TOP_LEFT, 10, 10, msg.text);
+            free(msg.text);
+            break;
+
+        case GUI_MSG_STATUS_TEXT:
+            set_overlay_text(&status_label, LV_ALIGN_TOP_MID, 0, 10, msg.text);
+            free(msg.text);
+            break;
+
+        case GUI_MSG_LED:
+            led_set_mode(led_get(msg.led.index), (led_mode_t)msg.led.mode, msg.led.period, msg.led.duty);
+            break;
+
+        case GUI_MSG_FREEZE:
+            set_view_frozen(0 != msg.len);
+            break;
+
+        default:
+            break;
+        }
     }
 
-    next_task_tick = (now + task_period);
+    /* One invalidation of the chart for all the bytes of this frame, the
+     * plot only invalidates itself when a push completes a column */
+    if (chart_changed && (NULL == plot)) {
+        lv_chart_refresh(ui_Chart1);
+    }
+
+    /* Frozen, the bytes are only in the history until the view follows the data again */
+    if ((NULL != hex_view) && !gui_is_frozen()) {
+        follow_history();
+    }
+
+    return drained;
+}
 
+static void run_frame(void)
+{
+    display_stats_t display;
+
+    TRACE_BEGIN("lv_timer_handler");
+    uint64_t start = now_cycles();
     lv_timer_handler();
+    uint64_t elapsed = now_cycles() - start;
+    TRACE_END("lv_timer_handler");
 
-    // lv_tick_inc(task_period);
+    /* The flushes are reported on their own */
+    display_get_stats(&display);
+    uint64_t flush_cycles = display.cycles - last_display.cycles;
+    profiler_record(PROF_STAGE_LVGL, (elapsed > flush_cycles) ? (elapsed - flush_cycles) : 0, 0);
 
-    // led_process();
+    if (display.frames != last_display.frames) {
+        metrics_add(flush_bytes_metric, display.bytes - last_display.bytes);
+        metrics_set(frame_flush_bytes_metric, display.frame_bytes);
+    }
+    last_display = display;
 }
 
-void gui_process_byte(uint8_t byte)
+static void follow_frame_rate(void)
 {
-    // convert the byte to a string pointer that can be passed to the _ui_textarea_append_text function
-    char byte_str[4];
-    snprintf(byte_str, sizeof(byte_str), "%02X ", byte);
+    lv_disp_t *disp = lv_disp_get_default();
 
-    lv_coord_t data;
+    /* Due whenever lv_timer_handler() runs, which is once per frame */
+    if ((NULL != disp) && (NULL != disp->refr_timer)) {
+        lv_timer_set_period(disp->refr_timer, 1);
+    }
+}
 
-    // call the _ui_textarea_append_text function to add the byte to the text area
-    _ui_textarea_append_text(ui_TextArea1, byte_str);
+static void sleep_until(uint64_t when_ns)
+{
+    struct timespec ts = {
+        .tv_sec = (time_t)(when_ns / NSEC_PER_SEC),
+        .tv_nsec = (long)(when_ns % NSEC_PER_SEC),
+    };
 
-    // Add the byte to the plot buffer
-    data = (lv_coord_t)(0x000000FF & byte);
-    ring_buf_push(&plot_buffer, &data);
-    lv_chart_refresh(ui_Chart1);
+    /* get_nanos() is CLOCK_MONOTONIC. A time in the past returns at once. */
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+static void create_hex_view(void)
+{
+    if (NULL == ui_TextArea1)
+        return;
+
+    /* The text area's size comes from the flex layout, so let it settle first */
+    lv_obj_update_layout(ui_TextArea1);
+
+    hex_view = hex_view_create(lv_obj_get_parent(ui_TextArea1), &ui_font_Courier_New_16,
+                               lv_obj_get_width(ui_TextArea1), lv_obj_get_height(ui_TextArea1));
+    if (NULL == hex_view) {
+        log_error("Hex view not created, falling back to the text area\n");
+        return;
+    }
+
+    view_bytes = malloc(hex_view->bytes_per_row * hex_view->rows);
+    if (NULL == view_bytes) {
+        log_error("Hex view not created, falling back to the text area\n");
+        hex_view_delete(hex_view);
+        hex_view = NULL;
+        return;
+    }
+
+    /* Same slot in the panel's flex row, the text area no longer takes part */
+    lv_obj_move_to_index(hex_view_get_obj(hex_view), (int32_t)lv_obj_get_index(ui_TextArea1));
+    lv_obj_add_flag(ui_TextArea1, LV_OBJ_FLAG_HIDDEN);
+}
+
+static void create_plot(void)
+{
+    if (!GUI_USE_PLOT)
+        return;
+
+    lv_obj_update_layout(ui_Chart1);
+
+    plot = plot_create(lv_obj_get_parent(ui_Chart1), lv_obj_get_width(ui_Chart1), lv_obj_get_height(ui_Chart1), 1);
+    if (NULL == plot) {
+        log_error("Plot not created, falling back to the chart\n");
+        return;
+    }
 
-    plot_data_index++;
-    if (plot_data_index >= PLOT_DATA_ELEMENTS){
-        plot_data_index = 0;
-        ring_buf_clear(&plot_buffer);
+    plot_set_range(plot, 0, 255);
+    plot_set_decimation(plot, GUI_PLOT_MAX_SPP);
+    plot_set_channel_color(plot, 0, lv_color_hex(0x00FF00));
 
-        // set all data in the plot_data array to 0
-        for (uint32_t i = 0; i < PLOT_DATA_ELEMENTS; i++){
-            plot_data[i] = 0;
+    /* The chart is positioned absolutely in the panel, take its place */
+    lv_obj_align_to(plot_get_obj(plot), ui_Chart1, LV_ALIGN_CENTER, 0, 0);
+    lv_obj_add_flag(ui_Chart1, LV_OBJ_FLAG_HIDDEN);
+}
+
+static void set_view_frozen(bool frozen)
+{
+    if ((NULL == hex_view) || (frozen == gui_is_frozen()))
+        return;
+
+    if (frozen) {
+        live_slider_min = lv_slider_get_min_value(ui_Slider1);
+        live_slider_max = lv_slider_get_max_value(ui_Slider1);
+        live_slider_value = lv_slider_get_value(ui_Slider1);
+        lv_slider_set_range(ui_Slider1, 0, GUI_SCRUB_STEPS);
+        lv_slider_set_value(ui_Slider1, GUI_SCRUB_STEPS, LV_ANIM_OFF);
+    }
+    else {
+        /* Setting the value doesn't send an event, the chart zoom is untouched */
+        lv_slider_set_range(ui_Slider1, live_slider_min, live_slider_max);
+        lv_slider_set_value(ui_Slider1, live_slider_value, LV_ANIM_OFF);
+    }
+
+    atomic_store_explicit(&view_frozen, frozen, memory_order_relaxed);
+
+    /* Either way the view starts from the newest screenful */
+    show_history(GUI_SCRUB_STEPS);
+}
+
+static void show_history(int32_t pos)
+{
+    const uint64_t bpr = hex_view->bytes_per_row;
+    const uint64_t rows = hex_view->rows;
+
+    if (pos < 0) {
+        pos = 0;
+    }
+    else if (pos > GUI_SCRUB_STEPS) {
+        pos = GUI_SCRUB_STEPS;
+    }
+
+    /* The writer may evict the lines being read, then try again from the new oldest line */
+    for (uint32_t attempt = 0; attempt < 2U; attempt++) {
+        const uint64_t start = history_start(&history);
+        const uint64_t end = history_end(&history);
+
+        /* Whole lines: the first one held, and the first of the newest screenful */
+        uint64_t first_line = (start + bpr - 1U) / bpr;
+        uint64_t last_first_line = (end > 0) ? ((end - 1U) / bpr) : 0;
+        last_first_line = (last_first_line >= rows - 1U) ? (last_first_line - (rows - 1U)) : 0;
+
+        if (last_first_line > first_line) {
+            first_line += ((last_first_line - first_line) * (uint64_t)pos) / GUI_SCRUB_STEPS;
+        }
+
+        const uint64_t first = first_line * bpr;
+        size_t n = history_read(&history, first, view_bytes, (size_t)(bpr * rows));
+        if ((n > 0) || (first >= end)) {
+            hex_view_show(hex_view, first, view_bytes, n);
+            return;
         }
     }
+}
+
+static void follow_history(void)
+{
+    const size_t visible = hex_view->bytes_per_row * hex_view->rows;
+    const uint64_t end = history_end(&history);
+
+    /* More than a screenful behind (or evicted): redraw the newest screenful instead */
+    if (end - hex_view->count > visible) {
+        show_history(GUI_SCRUB_STEPS);
+        return;
+    }
 
+    while (hex_view->count < end) {
+        size_t n = history_read(&history, hex_view->count, view_bytes, (size_t)(end - hex_view->count));
+        if (0 == n) {
+            show_history(GUI_SCRUB_STEPS);
+            return;
+        }
+        hex_view_append(hex_view, view_bytes, n);
+    }
 }
 
-static bool initialize_gui(void)
+static void show_bytes(const uint8_t *data, size_t len, uint32_t step)
 {
-    bool status = true;
+    // "XX " per byte for the text area fallback, appended GUI_TEXT_BYTES at a time
+    char text[GUI_TEXT_BYTES * 3 + 1];
+    size_t used = 0;
+    int32_t samples[GUI_PLOT_BATCH];
+    uint32_t sample_count = 0;
+
+    for (size_t i = 0; i < len; i += step) {
+        if (NULL == hex_view) {
+            snprintf(&text[used], sizeof(text) - used, "%02X ", data[i]);
+            used += 3;
+            if (used + 3 >= sizeof(text)) {
+                _ui_textarea_append_text(ui_TextArea1, text);
+                used = 0;
+            }
+        }
 
-    lv_init();
+        if (NULL != plot) {
+            samples[sample_count++] = data[i];
+            if (GUI_PLOT_BATCH == sample_count) {
+                plot_push(plot, samples, sample_count);
+                sample_count = 0;
+            }
+            continue;
+        }
 
-    /*Initialize the HAL (display, input devices, tick) for LVGL*/
-    hal_init();
+        // Overwrite the oldest point and move the start past it, as
+        // lv_chart_set_next_value() does but without invalidating per point
+        plot_data[chart_series->start_point] = (lv_coord_t)data[i];
+        chart_series->start_point = (chart_series->start_point + 1U == PLOT_DATA_ELEMENTS)
+                                  ? 0 : (uint16_t)(chart_series->start_point + 1U);
+    }
 
-    ui_init();
+    if (sample_count > 0) {
+        plot_push(plot, samples, sample_count);
+    }
 
-    return (status);
+    /* The hex view follows the history instead, see follow_history() */
+    if ((NULL == hex_view) && (used > 0)) {
+        _ui_textarea_append_text(ui_TextArea1, text);
+    }
 }
 
-void _ui_textarea_append_text(lv_obj_t *textarea, const char *text)
+static void set_overlay_text(lv_obj_t **label, lv_align_t align, lv_coord_t x_ofs, lv_coord_t y_ofs, const char *text)
 {
-    lv_textarea_add_text(textarea, text);
+    if ((NULL == text) || (text[0] == '\0')) {
+        if (NULL != *label) {
+            lv_obj_add_flag(*label, LV_OBJ_FLAG_HIDDEN);
+        }
+        return;
+    }
+
+    /* Created on first use on the top layer so it stays above the screen */
+    if (NULL == *label) {
+        *label = create_overlay_label(align, x_ofs, y_ofs);
+    }
+
+    lv_label_set_text(*label, text);
+    lv_obj_clear_flag(*label, LV_OBJ_FLAG_HIDDEN);
 }
 
-/**
- * Initialize the Hardware Abstraction Layer (HAL) for LVGL
- */
-static void hal_init(void)
-{
-  /* Use the 'monitor' driver which creates window on PC's monitor to simulate a display*/
-  sdl_init();
-
-  /*Create a display buffer*/
-  static lv_color_t buf[SDL_HOR_RES * SDL_VER_RES];
-  static lv_disp_draw_buf_t disp_draw_buf;
-  lv_disp_draw_buf_init(&disp_draw_buf, buf, NULL, SDL_HOR_RES * SDL_VER_RES);
-
-  /*Create a display*/
-  static lv_disp_drv_t disp_drv;
-  lv_disp_drv_init(&disp_drv); /*Basic initialization*/
-  disp_drv.draw_buf = &disp_draw_buf;
-  disp_drv.flush_cb = sdl_display_flush;
-  disp_drv.hor_res = SDL_HOR_RES;
-  disp_drv.ver_res = SDL_VER_RES;
-  lv_disp_drv_register(&disp_drv);
-
-  /* Add a mouse as input device */
-  static lv_indev_drv_t indev_drv;
-  lv_indev_drv_init(&indev_drv); /*Basic initialization*/
-  indev_drv.type = LV_INDEV_TYPE_POINTER;
-  indev_drv.read_cb = sdl_mouse_read;
-  lv_indev_drv_register(&indev_drv);
+static void post_text(gui_msg_type_t type, const char *text)
+{
+    gui_msg_t msg;
+
+    if (!gui_ready)
+        return;
+
+    /* The GUI thread owns (and frees) the copy once the message is queued */
+    msg.type = (uint8_t)type;
+    msg.len = 0;
+    msg.text = ((NULL == text) || (text[0] == '\0')) ? NULL : strdup(text);
+
+    if (!mpsc_queue_push(&queue, &msg)) {
+        free(msg.text);
+    }
+}
+
+static lv_obj_t *create_overlay_label(lv_align_t align, lv_coord_t x_ofs, lv_coord_t y_ofs)
+{
+    lv_obj_t *label = lv_label_create(lv_layer_top());
+    lv_obj_align(label, align, x_ofs, y_ofs);
+    lv_obj_set_style_bg_color(label, lv_color_black(), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(label, 180, LV_PART_MAIN);
+    lv_obj_set_style_text_color(label, lv_color_hex(0x00FF00), LV_PART_MAIN);
+    lv_obj_set_style_pad_all(label, 4, LV_PART_MAIN);
+    return label;
+}
+
+static void release_chunk(chunk_t *chunk)
+{
+    atomic_fetch_sub_explicit(&chunks_held, 1, memory_order_relaxed);
+    chunk_release(chunk);
+}
+
+static uint64_t read_dropped(void)
+{
+    return mpsc_queue_dropped(&queue) + atomic_load_explicit(&chunks_dropped, memory_order_relaxed);
+}
+
+static uint64_t read_frames(void)
+{
+    return atomic_load_explicit(&frames_drawn, memory_order_relaxed);
+}
+
+static uint64_t read_skipped(void)
+{
+    return atomic_load_explicit(&frames_skipped, memory_order_relaxed);
+}
+
+static uint64_t read_merged(void)
+{
+    return atomic_load_explicit(&frames_merged, memory_order_relaxed);
+}
+
+void _ui_textarea_append_text(lv_obj_t *textarea, const char *text)
+{
+    lv_textarea_add_text(textarea, text);
 }
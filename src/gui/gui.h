@@ -36,29 +36,165 @@ extern "C" {
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "../buffer/chunk_pool.h"
 
 /****************************************************************************
  * Definitions
  *****************************************************************************/
 
+/* Frames per second the GUI aims for while it keeps up */
+#define GUI_DEFAULT_FPS 30U
+#define GUI_MIN_FPS     1U
+#define GUI_MAX_FPS     120U
+
+/* ui_Slider1 runs from 0 (oldest) to GUI_SCRUB_STEPS (newest) while the view is frozen */
+#define GUI_SCRUB_STEPS 1000
+
 /****************************************************************************
  * Structs, Unions, Enums, & Typedefs
  *****************************************************************************/
 
+/**
+ * @brief Frame scheduler counters since gui_init().
+ */
+typedef struct gui_frame_stats_t {
+    uint64_t frames;        /**< Frames run */
+    uint64_t skipped;       /**< Frame slots dropped because the previous frame overran */
+    uint64_t merged;        /**< Frames that ran out of budget and left updates for the next one */
+    uint64_t stretched;     /**< Frames delayed to keep the GUI thread within its CPU budget */
+} gui_frame_stats_t;
+
 /****************************************************************************
  * Function Prototypes
  *****************************************************************************/
 
 /**
- * @brief Initialize the GUI
+ * @brief Start the GUI thread. It owns LVGL, SDL and every UI object; the
+ * other functions only post messages to it and never wait for a frame.
+ * Until this is called they do nothing.
+ * 
+ * Frames are paced at the target rate. When a frame overruns, the missed
+ * slots are skipped; when updates or rendering take more than the CPU
+ * budget, updates carry over to the next frame and frames are spaced out
+ * until the load drops.
+ * 
+ * @param fps target frame rate (GUI_DEFAULT_FPS)
+ * @return bool true once the thread has the display up
+ */
+bool gui_init(uint32_t fps);
+
+/**
+ * @brief Change the target frame rate. Safe from any thread.
+ * 
+ * @param fps frames per second, clamped to GUI_MIN_FPS..GUI_MAX_FPS
+ */
+void gui_set_target_fps(uint32_t fps);
+
+/**
+ * @brief Get the target frame rate.
+ */
+uint32_t gui_get_target_fps(void);
+
+/**
+ * @brief Get the frame scheduler counters. Safe from any thread.
+ * 
+ * @param stats filled in with the current totals
+ */
+void gui_get_frame_stats(gui_frame_stats_t *stats);
+
+/**
+ * @brief Stop the GUI thread and wait for it to exit.
+ */
+void gui_deinit(void);
+
+/**
+ * @brief Append a received chunk to the hex view and the chart.
+ * 
+ * The bytes are stored in the history, and the GUI thread gets a reference
+ * to the chunk for the chart rather than a copy. If it has fallen behind and
+ * the queue is full the chunk is dropped (and counted) rather than holding
+ * up the caller; the history still has the bytes. Call from one thread only,
+ * it is the history's writer.
+ * 
+ * @param chunk received bytes, the caller keeps its own reference
+ * @param step 1 to chart every byte, n to chart one in n when the GUI can't keep up
+ * @return false if the chunk was dropped, the GUI is falling behind
+ */
+bool gui_post_chunk(chunk_t *chunk, uint32_t step);
+
+/**
+ * @brief Freeze the hex view to inspect it, or go back to following the data.
+ * 
+ * While frozen the data keeps going into the history and ui_Slider1 scrolls
+ * through it instead of zooming the chart.
+ * 
+ * @param frozen true to freeze, false to show the newest data again
+ */
+void gui_set_frozen(bool frozen);
+
+/**
+ * @brief Returns true while the hex view is frozen.
+ */
+bool gui_is_frozen(void);
+
+/**
+ * @brief Zoom the chart horizontally. GUI thread only (UI event callbacks).
+ * 
+ * With the plot this sets how many bytes share a pixel column.
+ * 
+ * @param zoom LV_IMG_ZOOM_NONE (256) for 1x, 512 for 2x, ...
+ */
+void gui_zoom_x(int32_t zoom);
+
+/**
+ * @brief Zoom the chart vertically. GUI thread only (UI event callbacks).
+ * 
+ * @param zoom LV_IMG_ZOOM_NONE (256) for 1x, 512 for 2x, ...
+ */
+void gui_zoom_y(int32_t zoom);
+
+/**
+ * @brief Show the part of the history at a slider position. GUI thread only
+ * (UI event callbacks), does nothing unless the view is frozen.
+ * 
+ * @param pos 0 for the oldest bytes held up to GUI_SCRUB_STEPS for the newest
+ */
+void gui_scrub(int32_t pos);
+
+/**
+ * @brief Set the mode of an LED.
  * 
- * @return bool 
+ * @param index LED number, in the order the LEDs were created
+ * @param mode one of led_mode_t
+ * @param period flashing period in ms
+ * @param duty flashing duty cycle (0.0 to 1.0)
  */
-bool gui_init(uint32_t process_period);
+void gui_set_led(uint32_t index, uint32_t mode, uint32_t period, float duty);
 
-void gui_task(void);
+/**
+ * @brief Show a line of status text (measurement results, warnings, ...) on
+ * top of the screen. An empty string or NULL hides it.
+ * 
+ * @param text 
+ */
+void gui_set_info_text(const char *text);
 
-void gui_process_byte(uint8_t byte);
+/**
+ * @brief Show the profiler table in the top left corner. An empty string
+ * or NULL hides it.
+ * 
+ * @param text 
+ */
+void gui_set_perf_text(const char *text);
+
+/**
+ * @brief Show a status line at the top of the screen (e.g. that the display
+ * is summarising the data). An empty string or NULL hides it.
+ * 
+ * @param text 
+ */
+void gui_set_status_text(const char *text);
 
 #ifdef __cplusplus
 }
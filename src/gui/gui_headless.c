@@ -0,0 +1,123 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        gui_headless.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+/*
+ * Stand-ins for gui.c in the serial_tool_headless target, which is built
+ * without LVGL, the UI or SDL2. Nothing is drawn and no thread is started.
+ */
+
+#include "gui.h"
+#include <stddef.h>
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+bool gui_init(uint32_t fps)
+{
+    (void)fps;
+    return true;
+}
+
+void gui_set_target_fps(uint32_t fps)
+{
+    (void)fps;
+}
+
+uint32_t gui_get_target_fps(void)
+{
+    return 0;
+}
+
+void gui_get_frame_stats(gui_frame_stats_t *stats)
+{
+    if (NULL != stats) {
+        *stats = (gui_frame_stats_t){0};
+    }
+}
+
+void gui_deinit(void)
+{
+}
+
+bool gui_post_chunk(chunk_t *chunk, uint32_t step)
+{
+    (void)chunk;
+    (void)step;
+    return true;
+}
+
+void gui_set_frozen(bool frozen)
+{
+    (void)frozen;
+}
+
+bool gui_is_frozen(void)
+{
+    return false;
+}
+
+void gui_scrub(int32_t pos)
+{
+    (void)pos;
+}
+
+void gui_zoom_x(int32_t zoom)
+{
+    (void)zoom;
+}
+
+void gui_zoom_y(int32_t zoom)
+{
+    (void)zoom;
+}
+
+void gui_set_led(uint32_t index, uint32_t mode, uint32_t period, float duty)
+{
+    (void)index;
+    (void)mode;
+    (void)period;
+    (void)duty;
+}
+
+void gui_set_info_text(const char *text)
+{
+    (void)text;
+}
+
+void gui_set_perf_text(const char *text)
+{
+    (void)text;
+}
+
+void gui_set_status_text(const char *text)
+{
+    (void)text;
+}
@@ -0,0 +1,378 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        hex_view.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#include "hex_view.h"
+#include "../log/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* A line needs at least this many bytes to be worth showing */
+#define HEX_VIEW_MIN_BYTES_PER_ROW  4U
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Rasterises every printable character into the atlas in the current colours.
+ */
+static void build_atlas(hex_view_t *hv);
+
+/**
+ * @brief Returns the alpha (0-255) of one pixel of a packed glyph bitmap.
+ */
+static inline uint8_t glyph_alpha(const uint8_t *bitmap, uint32_t index, uint8_t bpp);
+
+/**
+ * @brief Copies the atlas cell of a character into a cell of a line.
+ */
+static inline void put_char(hex_view_t *hv, uint32_t row, uint32_t col, uint8_t ch);
+
+/**
+ * @brief Fills a whole line with the background and writes its address.
+ */
+static void start_row(hex_view_t *hv, uint32_t row, uint64_t addr);
+
+/**
+ * @brief Invalidates the cells from first_col to last_col of a line, by its position on screen.
+ */
+static void invalidate_cells(const hex_view_t *hv, uint32_t line, uint32_t first_col, uint32_t last_col);
+
+/**
+ * @brief Column of the hex digits and of the ASCII character of byte i of a line.
+ */
+static inline uint32_t hex_col(uint32_t i);
+static inline uint32_t ascii_col(const hex_view_t *hv, uint32_t i);
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+hex_view_t *hex_view_create(lv_obj_t *parent, const lv_font_t *font, lv_coord_t width, lv_coord_t height)
+{
+    if ((NULL == parent) || (NULL == font) || (width <= 0) || (height <= 0)) {
+        return NULL;
+    }
+
+    /* Monospaced, so the advance of any digit is the advance of every character */
+    const lv_coord_t cell_w = (lv_coord_t)lv_font_get_glyph_width(font, '0', 0);
+    const lv_coord_t cell_h = lv_font_get_line_height(font);
+    if ((cell_w <= 0) || (cell_h <= 0)) {
+        return NULL;
+    }
+
+    /* "AAAAAAAA: " + "XX " per byte + " " + one ASCII character per byte */
+    const uint32_t cols = (uint32_t)(width / cell_w);
+    if (cols < HEX_VIEW_ADDR_CHARS + 1U + (4U * HEX_VIEW_MIN_BYTES_PER_ROW)) {
+        log_error("hex_view_create: %d pixels is too narrow\n", (int)width);
+        return NULL;
+    }
+    const uint32_t bytes_per_row = ((cols - HEX_VIEW_ADDR_CHARS - 1U) / 4U) & ~3U;
+    const uint32_t rows = (uint32_t)(height / cell_h);
+    if (rows == 0) {
+        return NULL;
+    }
+
+    hex_view_t *hv = malloc(sizeof(hex_view_t));
+    if (NULL == hv) {
+        log_error("hex_view_create: out of memory\n");
+        return NULL;
+    }
+
+    hv->font = font;
+    hv->cell_w = cell_w;
+    hv->cell_h = cell_h;
+    hv->bytes_per_row = bytes_per_row;
+    hv->rows = rows;
+    hv->width = (lv_coord_t)((HEX_VIEW_ADDR_CHARS + 1U + (4U * bytes_per_row)) * (uint32_t)cell_w);
+    hv->fg = lv_color_hex(0x00FF00);
+    hv->bg = lv_color_black();
+
+    const lv_coord_t tex_h = (lv_coord_t)(rows * (uint32_t)cell_h);
+    hv->buf = malloc(LV_CANVAS_BUF_SIZE_TRUE_COLOR(hv->width, tex_h));
+    hv->atlas = malloc(sizeof(lv_color_t) * HEX_VIEW_GLYPH_COUNT * (uint32_t)cell_w * (uint32_t)cell_h);
+    if ((NULL == hv->buf) || (NULL == hv->atlas)) {
+        log_error("hex_view_create: can't allocate %dx%d buffer\n", (int)hv->width, (int)tex_h);
+        free(hv->buf);
+        free(hv->atlas);
+        free(hv);
+        return NULL;
+    }
+
+    build_atlas(hv);
+
+    hv->canvas = lv_canvas_create(parent);
+    lv_canvas_set_buffer(hv->canvas, hv->buf, hv->width, tex_h, LV_IMG_CF_TRUE_COLOR);
+
+    hex_view_clear(hv);
+
+    return hv;
+}
+
+void hex_view_delete(hex_view_t *hv)
+{
+    if (NULL == hv)
+        return;
+
+    if (NULL != hv->canvas) {
+        lv_obj_del(hv->canvas);
+    }
+    free(hv->buf);
+    free(hv->atlas);
+    free(hv);
+}
+
+lv_obj_t *hex_view_get_obj(const hex_view_t *hv)
+{
+    return (NULL == hv) ? NULL : hv->canvas;
+}
+
+void hex_view_set_colors(hex_view_t *hv, lv_color_t fg, lv_color_t bg)
+{
+    if (NULL == hv)
+        return;
+
+    hv->fg = fg;
+    hv->bg = bg;
+    build_atlas(hv);
+    hex_view_clear(hv);
+}
+
+void hex_view_clear(hex_view_t *hv)
+{
+    if (NULL == hv)
+        return;
+
+    const uint32_t px_cnt = (uint32_t)hv->width * hv->rows * (uint32_t)hv->cell_h;
+    for (uint32_t i = 0; i < px_cnt; i++) {
+        hv->buf[i] = hv->bg;
+    }
+
+    hv->top = 0;
+    hv->rows_used = 0;
+    hv->count = 0;
+
+    lv_img_set_offset_y(hv->canvas, 0);
+    lv_obj_invalidate(hv->canvas);
+}
+
+void hex_view_show(hex_view_t *hv, uint64_t addr, const uint8_t *data, size_t len)
+{
+    if (NULL == hv)
+        return;
+
+    hex_view_clear(hv);
+    hv->count = addr;
+    hex_view_append(hv, data, len);
+}
+
+void hex_view_append(hex_view_t *hv, const uint8_t *data, size_t len)
+{
+    if ((NULL == hv) || (NULL == data) || (0 == len))
+        return;
+
+    const uint32_t bpr = hv->bytes_per_row;
+    bool scrolled = false;
+
+    /* Lines that would scroll straight off the top are never drawn, only counted */
+    const uint64_t visible = (uint64_t)bpr * hv->rows;
+    if (len > visible) {
+        const uint64_t end = hv->count + len;
+        const uint64_t first = ((end - 1U) / bpr - (hv->rows - 1U)) * bpr;
+        if (first > hv->count) {
+            /* Start on a line boundary; the lines drawn below replace every line on screen */
+            const size_t skip = (size_t)(first - hv->count);
+            data += skip;
+            len -= skip;
+            hv->count = first;
+        }
+    }
+
+    while (len > 0) {
+        uint32_t col = (uint32_t)(hv->count % bpr);
+
+        if ((0 == col) || (0 == hv->rows_used)) {
+            if (hv->rows_used < hv->rows) {
+                hv->rows_used++;
+            }
+            else {
+                hv->top = (hv->top + 1U == hv->rows) ? 0 : (hv->top + 1U);
+                scrolled = true;
+            }
+            start_row(hv, (hv->top + hv->rows_used - 1U) % hv->rows, hv->count - col);
+        }
+
+        const uint32_t row = (hv->top + hv->rows_used - 1U) % hv->rows;
+        const uint32_t n = ((size_t)(bpr - col) < len) ? (bpr - col) : (uint32_t)len;
+
+        for (uint32_t i = 0; i < n; i++) {
+            const uint8_t byte = data[i];
+            put_char(hv, row, hex_col(col + i), (uint8_t)hex_digits[byte >> 4]);
+            put_char(hv, row, hex_col(col + i) + 1U, (uint8_t)hex_digits[byte & 0x0FU]);
+            put_char(hv, row, ascii_col(hv, col + i), byte);
+        }
+
+        /* A scroll invalidates the whole canvas anyway */
+        if (!scrolled) {
+            invalidate_cells(hv, hv->rows_used - 1U, (0 == col) ? 0 : hex_col(col), ascii_col(hv, col + n - 1U));
+        }
+
+        hv->count += n;
+        data += n;
+        len -= n;
+    }
+
+    if (scrolled) {
+        /* Screen line s shows ring line (top + s) % rows, as the waterfall does with rows of pixels */
+        const lv_coord_t tex_h = (lv_coord_t)(hv->rows * (uint32_t)hv->cell_h);
+        lv_img_set_offset_y(hv->canvas, (lv_coord_t)((tex_h - (lv_coord_t)hv->top * hv->cell_h) % tex_h));
+    }
+}
+
+static void build_atlas(hex_view_t *hv)
+{
+    const uint32_t cell_px = (uint32_t)hv->cell_w * (uint32_t)hv->cell_h;
+    const lv_coord_t baseline = (lv_coord_t)(hv->cell_h - hv->font->base_line);
+
+    for (uint32_t g = 0; g < HEX_VIEW_GLYPH_COUNT; g++) {
+        lv_color_t *cell = &hv->atlas[g * cell_px];
+        lv_font_glyph_dsc_t dsc;
+
+        for (uint32_t i = 0; i < cell_px; i++) {
+            cell[i] = hv->bg;
+        }
+
+        const uint32_t letter = HEX_VIEW_FIRST_CHAR + g;
+        if (!lv_font_get_glyph_dsc(hv->font, &dsc, letter, 0) || (0 == dsc.bpp) || (dsc.bpp > 8)) {
+            continue;
+        }
+        const uint8_t *bitmap = lv_font_get_glyph_bitmap(hv->font, letter);
+        if (NULL == bitmap) {
+            continue;
+        }
+
+        /* Same placement lv_draw_letter uses, clipped to the cell */
+        const lv_coord_t x0 = dsc.ofs_x;
+        const lv_coord_t y0 = (lv_coord_t)(baseline - dsc.box_h - dsc.ofs_y);
+
+        for (lv_coord_t y = 0; y < (lv_coord_t)dsc.box_h; y++) {
+            const lv_coord_t cy = (lv_coord_t)(y0 + y);
+            if ((cy < 0) || (cy >= hv->cell_h))
+                continue;
+
+            for (lv_coord_t x = 0; x < (lv_coord_t)dsc.box_w; x++) {
+                const lv_coord_t cx = (lv_coord_t)(x0 + x);
+                if ((cx < 0) || (cx >= hv->cell_w))
+                    continue;
+
+                uint8_t alpha = glyph_alpha(bitmap, (uint32_t)y * dsc.box_w + (uint32_t)x, dsc.bpp);
+                if (alpha > 0) {
+                    cell[(uint32_t)cy * (uint32_t)hv->cell_w + (uint32_t)cx] = lv_color_mix(hv->fg, hv->bg, alpha);
+                }
+            }
+        }
+    }
+}
+
+static inline uint8_t glyph_alpha(const uint8_t *bitmap, uint32_t index, uint8_t bpp)
+{
+    /* Glyph bitmaps are packed MSB first with no padding between rows */
+    const uint32_t bit = index * bpp;
+    const uint8_t mask = (uint8_t)((1U << bpp) - 1U);
+    const uint8_t value = (uint8_t)((bitmap[bit >> 3] >> (8U - bpp - (bit & 7U))) & mask);
+
+    return (uint8_t)((value * 255U) / mask);
+}
+
+static inline void put_char(hex_view_t *hv, uint32_t row, uint32_t col, uint8_t ch)
+{
+    if ((ch < HEX_VIEW_FIRST_CHAR) || (ch > HEX_VIEW_LAST_CHAR)) {
+        ch = '.';
+    }
+
+    const uint32_t cell_w = (uint32_t)hv->cell_w;
+    const uint32_t cell_h = (uint32_t)hv->cell_h;
+    const uint32_t stride = (uint32_t)hv->width;
+    const lv_color_t *src = &hv->atlas[(uint32_t)(ch - HEX_VIEW_FIRST_CHAR) * cell_w * cell_h];
+    lv_color_t *dst = &hv->buf[(row * cell_h * stride) + (col * cell_w)];
+
+    for (uint32_t y = 0; y < cell_h; y++) {
+        memcpy(dst, src, cell_w * sizeof(lv_color_t));
+        dst += stride;
+        src += cell_w;
+    }
+}
+
+static void start_row(hex_view_t *hv, uint32_t row, uint64_t addr)
+{
+    const uint32_t px_cnt = (uint32_t)hv->width * (uint32_t)hv->cell_h;
+    lv_color_t *dst = &hv->buf[row * px_cnt];
+
+    for (uint32_t i = 0; i < px_cnt; i++) {
+        dst[i] = hv->bg;
+    }
+
+    for (uint32_t i = 0; i < 8U; i++) {
+        put_char(hv, row, i, (uint8_t)hex_digits[(addr >> (28U - (4U * i))) & 0x0FU]);
+    }
+    put_char(hv, row, 8U, ':');
+}
+
+static void invalidate_cells(const hex_view_t *hv, uint32_t line, uint32_t first_col, uint32_t last_col)
+{
+    lv_area_t area;
+    lv_obj_get_coords(hv->canvas, &area);
+
+    area.y1 = (lv_coord_t)(area.y1 + (lv_coord_t)line * hv->cell_h);
+    area.y2 = (lv_coord_t)(area.y1 + hv->cell_h - 1);
+    area.x2 = (lv_coord_t)(area.x1 + (lv_coord_t)((last_col + 1U) * (uint32_t)hv->cell_w) - 1);
+    area.x1 = (lv_coord_t)(area.x1 + (lv_coord_t)(first_col * (uint32_t)hv->cell_w));
+    lv_obj_invalidate_area(hv->canvas, &area);
+}
+
+static inline uint32_t hex_col(uint32_t i)
+{
+    return HEX_VIEW_ADDR_CHARS + (3U * i);
+}
+
+static inline uint32_t ascii_col(const hex_view_t *hv, uint32_t i)
+{
+    return HEX_VIEW_ADDR_CHARS + (3U * hv->bytes_per_row) + 1U + i;
+}
@@ -0,0 +1,159 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        hex_view.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#ifndef HEX_VIEW_H_
+#define HEX_VIEW_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../lvgl/lvgl.h"
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Characters with a glyph in the atlas (printable ASCII), others show as '.' */
+#define HEX_VIEW_FIRST_CHAR     0x20U
+#define HEX_VIEW_LAST_CHAR      0x7EU
+#define HEX_VIEW_GLYPH_COUNT    (HEX_VIEW_LAST_CHAR - HEX_VIEW_FIRST_CHAR + 1U)
+
+/* Characters before the first hex column: "00000000: " */
+#define HEX_VIEW_ADDR_CHARS     10U
+
+/*****************************************************************************
+ * Structs, Unions, Enums, & Typedefs
+ *****************************************************************************/
+
+/**
+ * @brief Hex dump widget state.
+ *
+ * Every character sits in a fixed cell, so a cell's position is simple
+ * arithmetic on the byte index and no text layout is involved. Glyphs are
+ * rasterised once into an atlas of ready-coloured cells; drawing a
+ * character copies cell_h rows of cell_w pixels. Like the waterfall, the
+ * canvas is a ring of text rows scrolled with the image offset, so a new
+ * line never moves the lines already drawn.
+ */
+typedef struct hex_view_t {
+    lv_obj_t *canvas;           /**< Canvas object that owns the pixel buffer */
+    lv_color_t *buf;            /**< Ring-addressed pixel buffer, rows * cell_h lines */
+    lv_color_t *atlas;          /**< HEX_VIEW_GLYPH_COUNT cells of cell_w * cell_h pixels */
+    const lv_font_t *font;      /**< Font the atlas was built from */
+    lv_color_t fg;              /**< Text colour */
+    lv_color_t bg;              /**< Background colour */
+    lv_coord_t cell_w;          /**< Advance of one character in pixels */
+    lv_coord_t cell_h;          /**< Line height in pixels */
+    lv_coord_t width;           /**< Canvas width in pixels */
+    uint32_t bytes_per_row;     /**< Bytes shown on one line */
+    uint32_t rows;              /**< Lines of history (canvas height / cell_h) */
+    uint32_t top;               /**< Ring index of the oldest line on screen */
+    uint32_t rows_used;         /**< Lines written so far, up to rows */
+    uint64_t count;             /**< Bytes appended since creation or clear (the address) */
+} hex_view_t;
+
+/*****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Creates a hex view that fits in the given size.
+ *
+ * Each line is "AAAAAAAA: " followed by a hex and an ASCII column.
+ *
+ * @param parent The parent object the canvas is created in.
+ * @param font Monospaced font, e.g. ui_font_Courier_New_16.
+ * @param width Width available in pixels, decides the bytes per line (a multiple of 4).
+ * @param height Height available in pixels, decides the number of lines.
+ *
+ * @return Pointer to the hex view, or NULL if it doesn't fit or can't be allocated.
+ */
+hex_view_t *hex_view_create(lv_obj_t *parent, const lv_font_t *font, lv_coord_t width, lv_coord_t height);
+
+/**
+ * @brief Deletes the canvas and frees the buffers.
+ *
+ * @param hv Pointer to the hex view.
+ */
+void hex_view_delete(hex_view_t *hv);
+
+/**
+ * @brief Returns the underlying canvas so it can be aligned/sized like any other object.
+ *
+ * @param hv Pointer to the hex view.
+ * @return lv_obj_t* The canvas object.
+ */
+lv_obj_t *hex_view_get_obj(const hex_view_t *hv);
+
+/**
+ * @brief Sets the text and background colours. Rebuilds the atlas and clears the view.
+ *
+ * @param hv Pointer to the hex view.
+ * @param fg Text colour.
+ * @param bg Background colour.
+ */
+void hex_view_set_colors(hex_view_t *hv, lv_color_t fg, lv_color_t bg);
+
+/**
+ * @brief Appends bytes. Only the cells they occupy are drawn and invalidated,
+ *        plus one scroll per new line.
+ *
+ * @param hv Pointer to the hex view.
+ * @param data Bytes to show.
+ * @param len Number of bytes.
+ */
+void hex_view_append(hex_view_t *hv, const uint8_t *data, size_t len);
+
+/**
+ * @brief Replaces everything shown with len bytes starting at address addr.
+ *
+ * Used to show a window of a longer history, costs only the bytes shown.
+ *
+ * @param hv Pointer to the hex view.
+ * @param addr Address of the first byte, a multiple of bytes_per_row keeps the lines aligned.
+ * @param data Bytes to show, at most bytes_per_row * rows are visible.
+ * @param len Number of bytes.
+ */
+void hex_view_show(hex_view_t *hv, uint64_t addr, const uint8_t *data, size_t len);
+
+/**
+ * @brief Clears the view and restarts the address at 0.
+ *
+ * @param hv Pointer to the hex view.
+ */
+void hex_view_clear(hex_view_t *hv);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* HEX_VIEW_H_ */
@@ -7,6 +7,8 @@
 #include <pthread.h>
 #include "led.h"
 #include "../time_funcs/time_funcs.h"
+#include "../log/log.h"
+#include "../trace/trace.h"
 #include <unistd.h>
 #include <string.h>
 #include <stdio.h>
@@ -26,6 +28,8 @@
 #define LED_BREATHING_GAMMA             0.25f //0.14f
 /* shifts the gaussian to be symmetric */
 #define LED_BREATHING_BETA              0.5f
+/* time between breathing steps, a full breath is LED_BREATHING_SMOOTHNESS_PTS steps */
+#define LED_BREATHING_STEP_MS           8u
 
 /*****************************************************************************
  * Variables
@@ -37,12 +41,24 @@ static led_t leds[LED_MAX_COUNT];
 
 static pthread_mutex_t lock;
 
+static timer_wheel_t *timers = NULL;
+
 /*****************************************************************************
  * Prototypes
  *****************************************************************************/
 
 void my_keyboard_cb(lv_event_t * e);
 
+/**
+ * @brief Timer callback for a flashing LED: switch it and schedule the next edge.
+ */
+static void flash_edge(tw_timer_t *timer, void *ctx);
+
+/**
+ * @brief Timer callback for a breathing LED: move one step along the curve.
+ */
+static void breath_step(tw_timer_t *timer, void *ctx);
+
 
 
 
@@ -53,7 +69,7 @@ void my_keyboard_cb(lv_event_t * e);
 led_t *led_create(const lv_obj_t *parent, lv_align_t align, int32_t x_ofs, int32_t y_ofs, lv_palette_t color)
 {
     if (led_count >= LED_MAX_COUNT) {
-        printf("led_create: led_count >= LED_MAX_COUNT\n");
+        log_error("led_create: led_count >= LED_MAX_COUNT\n");
         return NULL;
     }
 
@@ -82,6 +98,11 @@ led_t *led_create(const lv_obj_t *parent, lv_align_t align, int32_t x_ofs, int32
     return &leds[led_count-1];
 }
 
+led_t *led_get(uint32_t index)
+{
+    return (index < led_count) ? &leds[index] : NULL;
+}
+
 void led_set_mode(led_t *led, led_mode_t mode, uint32_t period, float duty)
 {
     if (NULL == led)
@@ -94,6 +115,9 @@ void led_set_mode(led_t *led, led_mode_t mode, uint32_t period, float duty)
     else
         led->mode = mode;
 
+    /* Whatever the old mode had scheduled no longer applies */
+    timer_wheel_cancel(timers, &led->timer);
+
     switch(mode)
     {
     case LED_MODE_ON:
@@ -112,8 +136,8 @@ void led_set_mode(led_t *led, led_mode_t mode, uint32_t period, float duty)
 
         lv_led_set_brightness(led->led, led->on_bright);
         led->is_on = true;
-        led->on_timestamp = get_millis();
-        led->off_timestamp = get_millis() + (uint64_t)((float)led->period * led->duty);
+        timer_wheel_schedule(timers, &led->timer,
+            (uint64_t)((float)led->period * led->duty) * NSEC_PER_MSEC, flash_edge, led);
 
         break;
 
@@ -121,6 +145,7 @@ void led_set_mode(led_t *led, led_mode_t mode, uint32_t period, float duty)
         led->breath_bright = 0;
         led->breath_index = 0;
         lv_led_set_brightness(led->led, led->breath_bright);
+        timer_wheel_schedule(timers, &led->timer, LED_BREATHING_STEP_MS * NSEC_PER_MSEC, breath_step, led);
         break;
 
     case LED_MODE_OFF:
@@ -185,7 +210,7 @@ bool led_move_x(led_t *led, int32_t offset)
     int32_t current_y = lv_obj_get_y(led->led);
 
     if (led->align != LV_ALIGN_DEFAULT) {
-        printf("led's alignment will be changed to LV_ALIGN_DEFAULT\n");
+        log_warn("led's alignment will be changed to LV_ALIGN_DEFAULT\n");
         led->align = LV_ALIGN_DEFAULT;
         led->x_ofs = current_x;
         led->y_ofs = current_y;
@@ -221,7 +246,7 @@ bool led_move_y(led_t *led, int32_t offset)
     int32_t current_y = lv_obj_get_y(led->led);
 
     if (led->align != LV_ALIGN_DEFAULT) {
-        printf("led's alignment will be changed to LV_ALIGN_DEFAULT\n");
+        log_warn("led's alignment will be changed to LV_ALIGN_DEFAULT\n");
         led->align = LV_ALIGN_DEFAULT;
         led->x_ofs = current_x;
         led->y_ofs = current_y;
@@ -264,8 +289,9 @@ void led_rotate(led_t *led)
     pthread_mutex_unlock(&lock);
 }
 
-void led_init(void)
+void led_init(timer_wheel_t *wheel)
 {
+    timers = wheel;
     led_count = 0;
     for (uint32_t i=0; i<LED_MAX_COUNT; i++) {
         leds[i].led = NULL;
@@ -282,53 +308,54 @@ void led_init(void)
         leds[i].x_ofs = 0;
         leds[i].y_ofs = 0;
         leds[i].is_on = false;
+        timer_wheel_timer_init(&leds[i].timer);
     }
 
     /* create a mutex to protect leds data */
     if (pthread_mutex_init(&lock, NULL) != 0) {
-        printf("\n mutex init has failed\n");
+        log_error("\n mutex init has failed\n");
         return;
     }
 }
 
 
-void led_process(void)
+static void flash_edge(tw_timer_t *timer, void *ctx)
 {
-    uint64_t now;
+    led_t *led = ctx;
+    uint32_t on_ms = (uint32_t)((float)led->period * led->duty);
 
+    TRACE_BEGIN("led_flash_edge");
     pthread_mutex_lock(&lock);
-    for (int i=0; i<LED_MAX_COUNT; i++) {
-        if (leds[i].led != NULL) {
-            if (leds[i].mode == LED_MODE_FLASHING) {
-                now = get_millis();
-
-                if(leds[i].is_on && (now >= leds[i].off_timestamp)) {
-                    /* turn off the led */
-                    lv_led_set_brightness(leds[i].led, leds[i].off_bright);
-                    leds[i].is_on = false;
-                }
-                else if(!leds[i].is_on && ((now - leds[i].on_timestamp) >= leds[i].period)) {
-                    /* turn on the led */
-                    lv_led_set_brightness(leds[i].led, leds[i].on_bright);
-                    leds[i].is_on = true;
-                    /* calculate the off timestamp and capture the on_timestamp */
-                    leds[i].on_timestamp = now;
-                    leds[i].off_timestamp = now + (uint64_t)((float)leds[i].period * leds[i].duty);
-                }
-            }
-            else if (leds[i].mode == LED_MODE_BREATHING) {
-                leds[i].breath_bright = (uint8_t)(255.0*(exp(-(pow((((float)leds[i].breath_index++/LED_BREATHING_SMOOTHNESS_PTS)-LED_BREATHING_BETA)/LED_BREATHING_GAMMA,2.0))/2.0)));
-                if (leds[i].breath_index >= LED_BREATHING_SMOOTHNESS_PTS) {
-                    leds[i].breath_index = 0;
-                }
-                lv_led_set_brightness(leds[i].led, leds[i].breath_bright);
-            }
-            else {
-                // Do nothing
-            }
-        }
+    if (led->is_on) {
+        /* turn off the led until the next period starts */
+        lv_led_set_brightness(led->led, led->off_bright);
+        led->is_on = false;
+        timer_wheel_schedule(timers, timer, (uint64_t)(led->period - on_ms) * NSEC_PER_MSEC, flash_edge, led);
+    }
+    else {
+        /* turn on the led for the on part of the period */
+        lv_led_set_brightness(led->led, led->on_bright);
+        led->is_on = true;
+        timer_wheel_schedule(timers, timer, (uint64_t)on_ms * NSEC_PER_MSEC, flash_edge, led);
+    }
+    pthread_mutex_unlock(&lock);
+    TRACE_END("led_flash_edge");
+}
+
+static void breath_step(tw_timer_t *timer, void *ctx)
+{
+    led_t *led = ctx;
+
+    TRACE_BEGIN("led_breath_step");
+    pthread_mutex_lock(&lock);
+    led->breath_bright = (uint8_t)(255.0*(exp(-(pow((((float)led->breath_index++/LED_BREATHING_SMOOTHNESS_PTS)-LED_BREATHING_BETA)/LED_BREATHING_GAMMA,2.0))/2.0)));
+    if (led->breath_index >= LED_BREATHING_SMOOTHNESS_PTS) {
+        led->breath_index = 0;
     }
+    lv_led_set_brightness(led->led, led->breath_bright);
+    timer_wheel_schedule(timers, timer, LED_BREATHING_STEP_MS * NSEC_PER_MSEC, breath_step, led);
     pthread_mutex_unlock(&lock);
+    TRACE_END("led_breath_step");
 }
 
 void my_keyboard_cb(lv_event_t * e)
@@ -353,19 +380,19 @@ void my_keyboard_cb(lv_event_t * e)
         uint32_t key = lv_indev_get_key(lv_indev_get_act());
         switch(key) {
             case LV_KEY_UP:
-                printf("LV_KEY_UP\n");
+                log_debug("LV_KEY_UP\n");
                 led_move_y(led, -1);
                  break;
             case LV_KEY_DOWN:
-                printf("LV_KEY_DOWN\n");
+                log_debug("LV_KEY_DOWN\n");
                 led_move_y(led, 1);
                 break;
             case LV_KEY_LEFT:
-                printf("LV_KEY_LEFT\n");
+                log_debug("LV_KEY_LEFT\n");
                 led_move_x(led, -1);
                 break;
             case LV_KEY_RIGHT:
-                printf("LV_KEY_RIGHT\n");
+                log_debug("LV_KEY_RIGHT\n");
                 led_move_x(led, 1);
                 break;
                 /* Add a case to capture when the 'R' or 'r' key is pressed */
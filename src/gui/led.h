@@ -12,6 +12,7 @@ extern "C" {
 #endif
 
 #include "../lvgl/lvgl.h"
+#include "../time_funcs/timer_wheel.h"
 
 /*****************************************************************************
  * Definitions
@@ -52,8 +53,7 @@ typedef struct led_t {
     uint8_t off_bright;         /**< Brightness when the LED is off */
     uint8_t breath_bright;      /**< Brightness when in breathing mode */
     uint16_t breath_index;      /**< Index of the Gaussian curve */
-    uint64_t on_timestamp;      /**< Used for flashing mode */
-    uint64_t off_timestamp;     /**< Used for flashing mode */
+    tw_timer_t timer;           /**< Next flash edge or breathing step */
     bool is_on;                 /**< Indicates if the LED is currently ON */
 } led_t;
 
@@ -81,6 +81,14 @@ led_t *led_create(
     int32_t y_ofs,
     lv_palette_t color);
 
+/**
+ * @brief Gets an LED by the order it was created in.
+ *
+ * @param index 0 for the first LED created.
+ * @return Pointer to the LED, NULL if there is no such LED.
+ */
+led_t *led_get(uint32_t index);
+
 /**
  * @brief Sets the mode, period, and duty cycle of an LED.
  *
@@ -129,19 +137,11 @@ void led_set_size(led_t *led, int32_t w, int32_t h);
  * @brief Initializes the LED module.
  *
  * This function initializes the LED module and should be called before using any other LED functions.
- */
-void led_init(void);
-
-
-/**
- * @brief Processes the LED functionality.
- *
- * This function is responsible for handling the LED functionality, such as turning on/off the LED,
- * changing LED colors, and controlling LED blinking patterns.
+ * Flashing and breathing LEDs are driven by timers on the given wheel, so nothing has to poll them.
  *
- * @note This function should be called periodically to ensure proper LED operation.
+ * @param wheel Timer wheel advanced by the GUI thread; all LED functions must run on that thread.
  */
-void led_process(void);
+void led_init(timer_wheel_t *wheel);
 
 /**
  * @brief Gets the position of an LED.
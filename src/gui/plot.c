@@ -0,0 +1,345 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        plot.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#include "plot.h"
+#include "../log/log.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__) && (LV_COLOR_DEPTH == 32)
+#include <emmintrin.h>
+#endif
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+/* Channel colours until plot_set_channel_color(), the first matches the chart series */
+static const uint32_t default_colors[PLOT_MAX_CHANNELS] = {
+    0x00FF00, 0xFFFF00, 0x00FFFF, 0xFF00FF, 0xFF8000, 0x4080FF, 0xFF4040, 0xFFFFFF,
+};
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Fills n pixels of a row, four at a time with SSE2 when available.
+ */
+static inline void fill_span(lv_color_t *dst, lv_color_t color, uint32_t n);
+
+/**
+ * @brief Clears the n newest columns to the background, one or two spans per row.
+ */
+static void clear_columns(plot_t *plot, uint32_t n);
+
+/**
+ * @brief Draws the n newest columns of every channel.
+ */
+static void draw_columns(const plot_t *plot, uint32_t n);
+
+/**
+ * @brief Clears the canvas and draws all the columns still in the ring.
+ */
+static void redraw(plot_t *plot);
+
+/**
+ * @brief Scrolls the canvas so the head column is on the right edge.
+ */
+static void update_view(const plot_t *plot);
+
+/**
+ * @brief Maps a value to a row, clamped to the canvas.
+ */
+static inline lv_coord_t value_to_row(const plot_t *plot, int32_t value);
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+plot_t *plot_create(lv_obj_t *parent, lv_coord_t width, lv_coord_t height, uint32_t channel_count)
+{
+    if ((NULL == parent) || (width <= 0) || (height <= 1) ||
+        (0 == channel_count) || (channel_count > PLOT_MAX_CHANNELS)) {
+        return NULL;
+    }
+
+    plot_t *plot = malloc(sizeof(plot_t));
+    if (NULL == plot) {
+        log_error("plot_create: out of memory\n");
+        return NULL;
+    }
+
+    plot->buf = malloc(LV_CANVAS_BUF_SIZE_TRUE_COLOR(width, height));
+    plot->cols = malloc((size_t)width * channel_count * sizeof(plot_col_t));
+    if ((NULL == plot->buf) || (NULL == plot->cols)) {
+        log_error("plot_create: can't allocate %dx%d buffers\n", (int)width, (int)height);
+        free(plot->buf);
+        free(plot->cols);
+        free(plot);
+        return NULL;
+    }
+
+    plot->width = width;
+    plot->height = height;
+    plot->channel_count = channel_count;
+    plot->y_min = 0;
+    plot->y_max = 255;
+    plot->samples_per_px = 1;
+    plot->bg = lv_color_hex(0x000000);
+    for (uint32_t i = 0; i < PLOT_MAX_CHANNELS; i++) {
+        plot->colors[i] = lv_color_hex(default_colors[i]);
+    }
+
+    plot->canvas = lv_canvas_create(parent);
+    lv_canvas_set_buffer(plot->canvas, plot->buf, width, height, LV_IMG_CF_TRUE_COLOR);
+
+    plot_clear(plot);
+
+    return plot;
+}
+
+void plot_delete(plot_t *plot)
+{
+    if (NULL == plot)
+        return;
+
+    if (NULL != plot->canvas) {
+        lv_obj_del(plot->canvas);
+    }
+    free(plot->cols);
+    free(plot->buf);
+    free(plot);
+}
+
+lv_obj_t *plot_get_obj(const plot_t *plot)
+{
+    return (NULL == plot) ? NULL : plot->canvas;
+}
+
+void plot_set_range(plot_t *plot, int32_t min, int32_t max)
+{
+    if ((NULL == plot) || (max <= min))
+        return;
+
+    plot->y_min = min;
+    plot->y_max = max;
+    redraw(plot);
+}
+
+void plot_set_decimation(plot_t *plot, uint32_t samples_per_px)
+{
+    if (NULL == plot)
+        return;
+
+    plot->samples_per_px = (samples_per_px > 0) ? samples_per_px : 1;
+    plot_clear(plot);
+}
+
+void plot_set_channel_color(plot_t *plot, uint32_t channel, lv_color_t color)
+{
+    if ((NULL == plot) || (channel >= plot->channel_count))
+        return;
+
+    plot->colors[channel] = color;
+    redraw(plot);
+}
+
+void plot_push(plot_t *plot, const int32_t *samples, uint32_t frame_count)
+{
+    if ((NULL == plot) || (NULL == samples) || (0 == frame_count))
+        return;
+
+    const uint32_t ch_cnt = plot->channel_count;
+    uint32_t new_cols = 0;
+
+    for (uint32_t f = 0; f < frame_count; f++) {
+        const int32_t *frame = &samples[f * ch_cnt];
+
+        for (uint32_t ch = 0; ch < ch_cnt; ch++) {
+            plot_col_t *acc = &plot->acc[ch];
+            if (0 == plot->acc_count) {
+                acc->min = acc->max = frame[ch];
+            }
+            else if (frame[ch] < acc->min) {
+                acc->min = frame[ch];
+            }
+            else if (frame[ch] > acc->max) {
+                acc->max = frame[ch];
+            }
+            acc->last = frame[ch];
+        }
+
+        /* A full column goes into the ring, it is drawn below */
+        if (++plot->acc_count >= plot->samples_per_px) {
+            plot->head = (plot->head + 1 >= plot->width) ? 0 : (plot->head + 1);
+            memcpy(&plot->cols[(uint32_t)plot->head * ch_cnt], plot->acc, ch_cnt * sizeof(plot_col_t));
+            plot->cols_pushed++;
+            plot->acc_count = 0;
+            new_cols++;
+        }
+    }
+
+    if (0 == new_cols)
+        return;
+
+    /* More columns than fit just means the whole plot is new */
+    if (new_cols > (uint32_t)plot->width) {
+        new_cols = (uint32_t)plot->width;
+    }
+
+    clear_columns(plot, new_cols);
+    draw_columns(plot, new_cols);
+    update_view(plot);
+}
+
+void plot_clear(plot_t *plot)
+{
+    if (NULL == plot)
+        return;
+
+    fill_span(plot->buf, plot->bg, (uint32_t)plot->width * (uint32_t)plot->height);
+
+    /* The first column lands on column 0 */
+    plot->head = plot->width - 1;
+    plot->cols_pushed = 0;
+    plot->acc_count = 0;
+
+    update_view(plot);
+}
+
+static inline void fill_span(lv_color_t *dst, lv_color_t color, uint32_t n)
+{
+#if defined(__SSE2__) && (LV_COLOR_DEPTH == 32)
+    const __m128i px4 = _mm_set1_epi32((int)color.full);
+    for (; n >= 4; n -= 4, dst += 4) {
+        _mm_storeu_si128((__m128i *)dst, px4);
+    }
+#endif
+    for (; n > 0; n--) {
+        *dst++ = color;
+    }
+}
+
+static void clear_columns(plot_t *plot, uint32_t n)
+{
+    const uint32_t width = (uint32_t)plot->width;
+    const uint32_t first = ((uint32_t)plot->head + width + 1 - n) % width;
+
+    /* The new columns may wrap around the end of the ring */
+    const uint32_t len1 = (first + n <= width) ? n : (width - first);
+    const uint32_t len2 = n - len1;
+
+    for (lv_coord_t y = 0; y < plot->height; y++) {
+        lv_color_t *row = plot->buf + (uint32_t)y * width;
+        fill_span(row + first, plot->bg, len1);
+        if (len2 > 0) {
+            fill_span(row, plot->bg, len2);
+        }
+    }
+}
+
+static void draw_columns(const plot_t *plot, uint32_t n)
+{
+    const uint32_t width = (uint32_t)plot->width;
+    const uint32_t ch_cnt = plot->channel_count;
+
+    /* Columns still in the ring; the one before the oldest was overwritten */
+    const uint32_t kept = (plot->cols_pushed < width) ? plot->cols_pushed : width;
+
+    for (uint32_t age = n; age-- > 0;) {
+        const uint32_t x = ((uint32_t)plot->head + width - age) % width;
+        const uint32_t prev_x = (x == 0) ? (width - 1) : (x - 1);
+        const bool connect = (age + 1 < kept);
+
+        for (uint32_t ch = 0; ch < ch_cnt; ch++) {
+            const plot_col_t *col = &plot->cols[x * ch_cnt + ch];
+            int32_t lo = col->min;
+            int32_t hi = col->max;
+
+            /* Extend the run to the previous column's last sample so the
+             * trace stays connected, this is the column's share of the
+             * line between the two points */
+            if (connect) {
+                int32_t last = plot->cols[prev_x * ch_cnt + ch].last;
+                if (last < lo) {
+                    lo = last;
+                }
+                else if (last > hi) {
+                    hi = last;
+                }
+            }
+
+            /* Higher values are further up */
+            lv_coord_t top = value_to_row(plot, hi);
+            lv_coord_t bottom = value_to_row(plot, lo);
+            lv_color_t *px = plot->buf + (uint32_t)top * width + x;
+            const lv_color_t color = plot->colors[ch];
+
+            for (lv_coord_t y = top; y <= bottom; y++) {
+                *px = color;
+                px += width;
+            }
+        }
+    }
+}
+
+static void redraw(plot_t *plot)
+{
+    const uint32_t width = (uint32_t)plot->width;
+
+    fill_span(plot->buf, plot->bg, width * (uint32_t)plot->height);
+    draw_columns(plot, (plot->cols_pushed < width) ? plot->cols_pushed : width);
+    update_view(plot);
+}
+
+static void update_view(const plot_t *plot)
+{
+    /* Screen column c shows buffer column (c - offset) mod width, so this
+     * puts the head on the right edge and older columns to its left.
+     * LVGL wraps the buffer while drawing. */
+    lv_img_set_offset_x(plot->canvas, plot->width - 1 - plot->head);
+    lv_obj_invalidate(plot->canvas);
+}
+
+static inline lv_coord_t value_to_row(const plot_t *plot, int32_t value)
+{
+    const lv_coord_t bottom = plot->height - 1;
+
+    if (value <= plot->y_min)
+        return bottom;
+    if (value >= plot->y_max)
+        return 0;
+
+    return bottom - (lv_coord_t)(((int64_t)(value - plot->y_min) * bottom) /
+                                 ((int64_t)plot->y_max - plot->y_min));
+}
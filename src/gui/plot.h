@@ -0,0 +1,168 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        plot.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#ifndef PLOT_H_
+#define PLOT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../lvgl/lvgl.h"
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Most channels one plot can show */
+#define PLOT_MAX_CHANNELS   8U
+
+/*****************************************************************************
+ * Structs, Unions, Enums, & Typedefs
+ *****************************************************************************/
+
+/**
+ * @brief Range of the samples that fell into one pixel column of one channel.
+ */
+typedef struct plot_col_t {
+    int32_t min;    /**< Lowest sample */
+    int32_t max;    /**< Highest sample */
+    int32_t last;   /**< Newest sample, the next column connects to it */
+} plot_col_t;
+
+/**
+ * @brief Strip chart (oscilloscope roll mode) widget state.
+ *
+ * Samples are reduced to a min/max range per pixel column as they arrive,
+ * and each column is drawn as one vertical run per channel straight into
+ * the canvas buffer, so the cost of a frame depends on the number of new
+ * columns rather than on the number of samples. Like the waterfall, the
+ * buffer is a ring of columns: new columns are written at the head and the
+ * canvas image offset scrolls the plot, nothing already drawn is moved.
+ */
+typedef struct plot_t {
+    lv_obj_t *canvas;                       /**< Canvas object that owns the pixel buffer */
+    lv_color_t *buf;                        /**< Ring-addressed pixel buffer (width * height) */
+    plot_col_t *cols;                       /**< Ring of column ranges, width * channel_count */
+    lv_color_t colors[PLOT_MAX_CHANNELS];   /**< Line colour of each channel */
+    lv_color_t bg;                          /**< Background colour */
+    lv_coord_t width;                       /**< Width in pixels, one column per samples_per_px samples */
+    lv_coord_t height;                      /**< Height in pixels */
+    lv_coord_t head;                        /**< Column index of the newest complete column */
+    uint32_t channel_count;                 /**< Channels per sample frame */
+    int32_t y_min;                          /**< Value drawn on the bottom row */
+    int32_t y_max;                          /**< Value drawn on the top row */
+    uint32_t samples_per_px;                /**< Sample frames reduced into one column */
+    uint32_t acc_count;                     /**< Sample frames in the column being built */
+    plot_col_t acc[PLOT_MAX_CHANNELS];      /**< Column being built */
+    uint32_t cols_pushed;                   /**< Complete columns since creation or clear */
+} plot_t;
+
+/*****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Creates a plot widget.
+ *
+ * @param parent The parent object the canvas is created in.
+ * @param width Width in pixels.
+ * @param height Height in pixels.
+ * @param channel_count Number of channels (1 to PLOT_MAX_CHANNELS).
+ *
+ * @return Pointer to the plot, or NULL if the buffers could not be allocated.
+ */
+plot_t *plot_create(lv_obj_t *parent, lv_coord_t width, lv_coord_t height, uint32_t channel_count);
+
+/**
+ * @brief Deletes the canvas and frees the buffers.
+ *
+ * @param plot Pointer to the plot.
+ */
+void plot_delete(plot_t *plot);
+
+/**
+ * @brief Returns the underlying canvas so it can be aligned/sized like any other object.
+ *
+ * @param plot Pointer to the plot.
+ * @return lv_obj_t* The canvas object.
+ */
+lv_obj_t *plot_get_obj(const plot_t *plot);
+
+/**
+ * @brief Sets the values drawn on the bottom and top rows. Redraws the history.
+ *
+ * @param plot Pointer to the plot.
+ * @param min Value on the bottom row.
+ * @param max Value on the top row, must be greater than min.
+ */
+void plot_set_range(plot_t *plot, int32_t min, int32_t max);
+
+/**
+ * @brief Sets how many sample frames are reduced into one pixel column. Clears the history.
+ *
+ * @param plot Pointer to the plot.
+ * @param samples_per_px Sample frames per column, at least 1.
+ */
+void plot_set_decimation(plot_t *plot, uint32_t samples_per_px);
+
+/**
+ * @brief Sets the line colour of a channel. Redraws the history.
+ *
+ * @param plot Pointer to the plot.
+ * @param channel Channel index.
+ * @param color Line colour.
+ */
+void plot_set_channel_color(plot_t *plot, uint32_t channel, lv_color_t color);
+
+/**
+ * @brief Adds sample frames to the plot.
+ *
+ * Only the columns completed by these samples are drawn, however many
+ * samples that took.
+ *
+ * @param plot Pointer to the plot.
+ * @param samples frame_count frames of channel_count interleaved samples.
+ * @param frame_count Number of frames.
+ */
+void plot_push(plot_t *plot, const int32_t *samples, uint32_t frame_count);
+
+/**
+ * @brief Clears the history to the background colour.
+ *
+ * @param plot Pointer to the plot.
+ */
+void plot_clear(plot_t *plot);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* PLOT_H_ */
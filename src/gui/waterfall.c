@@ -0,0 +1,280 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        waterfall.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#include "waterfall.h"
+#include "../log/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/**
+ * @brief A colour map control point. Levels between points are interpolated.
+ */
+typedef struct cmap_point_t {
+    uint8_t level;
+    uint32_t hex;
+} cmap_point_t;
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+static const cmap_point_t cmap_gray[] = {
+    {0, 0x000000}, {255, 0xFFFFFF},
+};
+
+static const cmap_point_t cmap_heat[] = {
+    {0, 0x000000}, {48, 0x00007F}, {96, 0x0000FF}, {144, 0x00FFFF},
+    {192, 0xFFFF00}, {224, 0xFF0000}, {255, 0xFFFFFF},
+};
+
+static const cmap_point_t cmap_green[] = {
+    {0, 0x000000}, {192, 0x00C000}, {255, 0xB0FFB0},
+};
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Builds the lookup table by linearly interpolating between control points.
+ */
+static void build_lut(lv_color_t *lut, const cmap_point_t *pts, uint32_t pt_cnt);
+
+/**
+ * @brief Returns a pointer to the first pixel of a row in the ring.
+ */
+static inline lv_color_t *row_ptr(const waterfall_t *wf, lv_coord_t row);
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+waterfall_t *waterfall_create(lv_obj_t *parent, lv_coord_t width, lv_coord_t height, waterfall_cmap_t cmap)
+{
+    if ((NULL == parent) || (width <= 0) || (height <= 0)) {
+        return NULL;
+    }
+
+    waterfall_t *wf = malloc(sizeof(waterfall_t));
+    if (NULL == wf) {
+        log_error("waterfall_create: out of memory\n");
+        return NULL;
+    }
+
+    wf->buf = malloc(LV_CANVAS_BUF_SIZE_TRUE_COLOR(width, height));
+    if (NULL == wf->buf) {
+        log_error("waterfall_create: can't allocate %dx%d buffer\n", (int)width, (int)height);
+        free(wf);
+        return NULL;
+    }
+
+    wf->width = width;
+    wf->height = height;
+    wf->mode = WATERFALL_MODE_SCROLL;
+
+    waterfall_set_colormap(wf, cmap);
+
+    wf->canvas = lv_canvas_create(parent);
+    lv_canvas_set_buffer(wf->canvas, wf->buf, width, height, LV_IMG_CF_TRUE_COLOR);
+
+    waterfall_clear(wf);
+
+    return wf;
+}
+
+void waterfall_delete(waterfall_t *wf)
+{
+    if (NULL == wf)
+        return;
+
+    if (NULL != wf->canvas) {
+        lv_obj_del(wf->canvas);
+    }
+    free(wf->buf);
+    free(wf);
+}
+
+lv_obj_t *waterfall_get_obj(const waterfall_t *wf)
+{
+    return (NULL == wf) ? NULL : wf->canvas;
+}
+
+void waterfall_set_colormap(waterfall_t *wf, waterfall_cmap_t cmap)
+{
+    if (NULL == wf)
+        return;
+
+    switch (cmap)
+    {
+    case WATERFALL_CMAP_GRAY:
+        build_lut(wf->lut, cmap_gray, sizeof(cmap_gray) / sizeof(cmap_gray[0]));
+        break;
+
+    case WATERFALL_CMAP_GREEN:
+        build_lut(wf->lut, cmap_green, sizeof(cmap_green) / sizeof(cmap_green[0]));
+        break;
+
+    case WATERFALL_CMAP_HEAT:
+    default:
+        build_lut(wf->lut, cmap_heat, sizeof(cmap_heat) / sizeof(cmap_heat[0]));
+        break;
+    }
+}
+
+void waterfall_set_colormap_lut(waterfall_t *wf, const lv_color_t *lut)
+{
+    if ((NULL == wf) || (NULL == lut))
+        return;
+
+    memcpy(wf->lut, lut, sizeof(wf->lut));
+}
+
+void waterfall_set_mode(waterfall_t *wf, waterfall_mode_t mode)
+{
+    if (NULL == wf)
+        return;
+
+    wf->mode = (mode < WATERFALL_MODE_MAX) ? mode : WATERFALL_MODE_SCROLL;
+    waterfall_clear(wf);
+}
+
+void waterfall_clear(waterfall_t *wf)
+{
+    if (NULL == wf)
+        return;
+
+    const lv_color_t bg = wf->lut[0];
+    const uint32_t px_cnt = (uint32_t)wf->width * (uint32_t)wf->height;
+    for (uint32_t i = 0; i < px_cnt; i++) {
+        wf->buf[i] = bg;
+    }
+
+    /* Scroll mode walks the head backwards so the newest row lands on top,
+     * sweep mode walks it forwards from the top of the texture. */
+    wf->head = (WATERFALL_MODE_SCROLL == wf->mode) ? 0 : (wf->height - 1);
+    wf->rows_pushed = 0;
+
+    lv_img_set_offset_y(wf->canvas, 0);
+    lv_obj_invalidate(wf->canvas);
+}
+
+void waterfall_push_row(waterfall_t *wf, const uint8_t *levels, uint32_t level_cnt)
+{
+    if ((NULL == wf) || (NULL == levels) || (0 == level_cnt))
+        return;
+
+    /* Advance the ring. Nothing already in the buffer moves. */
+    if (WATERFALL_MODE_SCROLL == wf->mode) {
+        wf->head = (wf->head == 0) ? (wf->height - 1) : (wf->head - 1);
+    }
+    else {
+        wf->head = (wf->head + 1 >= wf->height) ? 0 : (wf->head + 1);
+    }
+
+    lv_color_t *dst = row_ptr(wf, wf->head);
+    const uint32_t width = (uint32_t)wf->width;
+
+    if (level_cnt == width) {
+        for (uint32_t x = 0; x < width; x++) {
+            dst[x] = wf->lut[levels[x]];
+        }
+    }
+    else if (level_cnt > width) {
+        /* Decimate: each column shows the peak of the levels it covers */
+        uint32_t start = 0;
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t end = (uint32_t)(((uint64_t)(x + 1) * level_cnt) / width);
+            uint8_t peak = levels[start];
+            for (uint32_t i = start + 1; i < end; i++) {
+                if (levels[i] > peak)
+                    peak = levels[i];
+            }
+            dst[x] = wf->lut[peak];
+            start = end;
+        }
+    }
+    else {
+        /* Stretch: 16.16 fixed point step through the levels */
+        uint32_t step = (level_cnt << 16) / width;
+        uint32_t pos = 0;
+        for (uint32_t x = 0; x < width; x++) {
+            dst[x] = wf->lut[levels[pos >> 16]];
+            pos += step;
+        }
+    }
+
+    wf->rows_pushed++;
+
+    if (WATERFALL_MODE_SCROLL == wf->mode) {
+        /* Screen row r shows texture row (r + head) % height, so the head row
+         * is drawn on top and older rows follow below it. LVGL wraps the
+         * texture while drawing; changing the offset just invalidates the area. */
+        lv_img_set_offset_y(wf->canvas, (wf->height - wf->head) % wf->height);
+    }
+    else {
+        /* Only the freshly written row changed on screen */
+        lv_area_t area;
+        lv_obj_get_coords(wf->canvas, &area);
+        area.y1 += wf->head;
+        area.y2 = area.y1;
+        lv_obj_invalidate_area(wf->canvas, &area);
+    }
+}
+
+static void build_lut(lv_color_t *lut, const cmap_point_t *pts, uint32_t pt_cnt)
+{
+    uint32_t seg = 0;
+
+    for (uint32_t level = 0; level < WATERFALL_LUT_SIZE; level++) {
+        while ((seg + 2 < pt_cnt) && (level > pts[seg + 1].level)) {
+            seg++;
+        }
+
+        const cmap_point_t *lo = &pts[seg];
+        const cmap_point_t *hi = &pts[seg + 1];
+        uint32_t span = (uint32_t)(hi->level - lo->level);
+        uint32_t ofs = (level > lo->level) ? (level - lo->level) : 0;
+        if (ofs > span)
+            ofs = span;
+
+        /* lv_color_mix weights its first argument by mix/255 */
+        uint8_t mix = (span == 0) ? 255 : (uint8_t)((ofs * 255U) / span);
+        lut[level] = lv_color_mix(lv_color_hex(hi->hex), lv_color_hex(lo->hex), mix);
+    }
+}
+
+static inline lv_color_t *row_ptr(const waterfall_t *wf, lv_coord_t row)
+{
+    return wf->buf + ((uint32_t)row * (uint32_t)wf->width);
+}
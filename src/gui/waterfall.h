@@ -0,0 +1,169 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        waterfall.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#ifndef WATERFALL_H_
+#define WATERFALL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../lvgl/lvgl.h"
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Number of entries in the colour map lookup table (one per 8-bit level) */
+#define WATERFALL_LUT_SIZE  256U
+
+/*****************************************************************************
+ * Structs, Unions, Enums, & Typedefs
+ *****************************************************************************/
+
+/**
+ * @brief How new rows are presented.
+ */
+typedef enum waterfall_mode_t {
+    WATERFALL_MODE_SCROLL,  /**< Newest row on top, history scrolls down (ring offset, no memmove) */
+    WATERFALL_MODE_SWEEP,   /**< Rows are written top to bottom in place, only the new row is redrawn */
+    WATERFALL_MODE_MAX
+} waterfall_mode_t;
+
+/**
+ * @brief Built-in colour maps.
+ */
+typedef enum waterfall_cmap_t {
+    WATERFALL_CMAP_GRAY,    /**< Black to white */
+    WATERFALL_CMAP_HEAT,    /**< Black, blue, cyan, yellow, red, white */
+    WATERFALL_CMAP_GREEN,   /**< Black to phosphor green, matches the chart series */
+    WATERFALL_CMAP_MAX
+} waterfall_cmap_t;
+
+/**
+ * @brief Waterfall (spectrogram) widget state.
+ *
+ * The pixel buffer is a ring of rows. Instead of shifting the whole texture
+ * by one row for every new block, the write position (head) moves and the
+ * canvas image offset is adjusted so LVGL wraps the texture while drawing.
+ */
+typedef struct waterfall_t {
+    lv_obj_t *canvas;                       /**< Canvas object that owns the pixel buffer */
+    lv_color_t *buf;                        /**< Ring-addressed pixel buffer (width * height) */
+    lv_color_t lut[WATERFALL_LUT_SIZE];     /**< Level to colour lookup table */
+    lv_coord_t width;                       /**< Width of the texture in pixels (one column per bin) */
+    lv_coord_t height;                      /**< Number of rows of history */
+    lv_coord_t head;                        /**< Row index of the most recently written row */
+    waterfall_mode_t mode;                  /**< Scroll or sweep presentation */
+    uint32_t rows_pushed;                   /**< Total rows pushed since creation or clear */
+} waterfall_t;
+
+/*****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Creates a waterfall widget.
+ *
+ * @param parent The parent object the canvas is created in.
+ * @param width Width of the texture in pixels.
+ * @param height Number of rows of history kept (height in pixels).
+ * @param cmap Initial colour map.
+ *
+ * @return Pointer to the waterfall, or NULL if the buffer could not be allocated.
+ */
+waterfall_t *waterfall_create(lv_obj_t *parent, lv_coord_t width, lv_coord_t height, waterfall_cmap_t cmap);
+
+/**
+ * @brief Deletes the canvas and frees the pixel buffer.
+ *
+ * @param wf Pointer to the waterfall.
+ */
+void waterfall_delete(waterfall_t *wf);
+
+/**
+ * @brief Returns the underlying canvas so it can be aligned/sized like any other object.
+ *
+ * @param wf Pointer to the waterfall.
+ * @return lv_obj_t* The canvas object.
+ */
+lv_obj_t *waterfall_get_obj(const waterfall_t *wf);
+
+/**
+ * @brief Selects one of the built-in colour maps.
+ *
+ * Rows already drawn keep their colours; only new rows use the new map.
+ *
+ * @param wf Pointer to the waterfall.
+ * @param cmap The colour map.
+ */
+void waterfall_set_colormap(waterfall_t *wf, waterfall_cmap_t cmap);
+
+/**
+ * @brief Loads a custom colour map.
+ *
+ * @param wf Pointer to the waterfall.
+ * @param lut WATERFALL_LUT_SIZE colours indexed by level.
+ */
+void waterfall_set_colormap_lut(waterfall_t *wf, const lv_color_t *lut);
+
+/**
+ * @brief Sets the presentation mode. Clears the history.
+ *
+ * @param wf Pointer to the waterfall.
+ * @param mode Scroll or sweep.
+ */
+void waterfall_set_mode(waterfall_t *wf, waterfall_mode_t mode);
+
+/**
+ * @brief Adds one row (one FFT block) to the waterfall.
+ *
+ * The levels are resampled to the texture width. When there are more levels
+ * than columns, each column takes the peak of the levels it covers so narrow
+ * spikes are not lost.
+ *
+ * @param wf Pointer to the waterfall.
+ * @param levels Magnitudes scaled to 0-255.
+ * @param level_cnt Number of entries in levels.
+ */
+void waterfall_push_row(waterfall_t *wf, const uint8_t *levels, uint32_t level_cnt);
+
+/**
+ * @brief Clears the history to the level 0 colour.
+ *
+ * @param wf Pointer to the waterfall.
+ */
+void waterfall_clear(waterfall_t *wf);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* WATERFALL_H_ */
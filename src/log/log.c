@@ -0,0 +1,812 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2024 David Burke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        log.c
+ * Created by  David Burke
+ * Version     1.0
+ * 
+ */
+
+
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Formatted text is collected and written in chunks of up to this size */
+#define LOG_OUT_BYTES       (64U * 1024U)
+
+/* Room kept free in the output buffer for one formatted record */
+#define LOG_LINE_BYTES      4096U
+
+/* Longest the writer sleeps when nobody wakes it */
+#define LOG_IDLE_MS         100U
+
+/* Offset stored for a string that didn't fit in the record */
+#define LOG_NO_STRING       UINT64_MAX
+
+/* Separates the producer and consumer indices */
+#define LOG_CACHE_LINE      64U
+
+/**
+ * @brief One argument, as read from the va_list.
+ */
+typedef union log_arg_t {
+    int64_t i;
+    uint64_t u;
+    double d;
+    const void *p;
+} log_arg_t;
+
+/**
+ * @brief Start of every record. A size of 0 marks padding to the end of the ring.
+ */
+typedef struct log_hdr_t {
+    uint32_t size;          /**< Whole record in bytes, multiple of 8 */
+    uint8_t level;          /**< log_level_t */
+    uint8_t nargs;          /**< Arguments following the header */
+    uint16_t reserved;
+    uint64_t seq;           /**< Orders the records of all threads */
+    const char *fmt;        /**< Format, formatted by the writer */
+} log_hdr_t;
+
+/**
+ * @brief Single producer (the owning thread), single consumer (the writer) byte ring.
+ */
+typedef struct log_ring_t {
+    _Atomic size_t head;                                        /**< Written by the producer */
+    char pad0[LOG_CACHE_LINE - sizeof(size_t)];
+    _Atomic size_t tail;                                        /**< Written by the writer */
+    char pad1[LOG_CACHE_LINE - sizeof(size_t)];
+    _Atomic uint64_t dropped;                                   /**< Not reported yet */
+    _Alignas(8) uint8_t buf[LOG_RING_BYTES];
+} log_ring_t;
+
+typedef enum log_len_t {
+    LOG_LEN_NONE, LOG_LEN_HH, LOG_LEN_H, LOG_LEN_L, LOG_LEN_LL,
+    LOG_LEN_Z, LOG_LEN_J, LOG_LEN_T, LOG_LEN_BIG_L,
+} log_len_t;
+
+/**
+ * @brief A parsed conversion specification.
+ */
+typedef struct log_spec_t {
+    const char *flags;      /**< Flag characters */
+    uint8_t flags_len;
+    bool width_star;        /**< Width comes from an argument */
+    int width;              /**< -1 if none */
+    bool prec_star;         /**< Precision comes from an argument */
+    int prec;               /**< -1 if none */
+    uint8_t length;         /**< log_len_t */
+    char conv;              /**< Conversion character, '\0' if the format ended */
+} log_spec_t;
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+static log_ring_t rings[LOG_MAX_THREADS];
+static _Atomic uint32_t ring_count = 0;
+static _Atomic uint64_t no_ring_dropped = 0;
+static _Atomic uint64_t total_dropped = 0;
+static _Atomic uint64_t next_seq = 0;
+static _Atomic int max_level = LOG_LEVEL_INFO;
+
+static __thread log_ring_t *my_ring = NULL;
+static __thread bool my_ring_failed = false;
+
+/* Producers queue while enabled, otherwise they print directly */
+static atomic_bool enabled = false;
+static atomic_bool writer_run = false;
+static atomic_bool writer_sleeping = false;
+static bool exit_handler_added = false;
+
+static pthread_t writer_thread;
+static pthread_mutex_t wake_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake_cond = PTHREAD_COND_INITIALIZER;
+
+static char out_buf[LOG_OUT_BYTES];
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+static const char *parse_spec(const char *p, log_spec_t *spec);
+static log_ring_t *get_ring(void);
+static bool ring_push(log_ring_t *ring, const void *rec, size_t size);
+static const log_hdr_t *ring_peek(log_ring_t *ring);
+static size_t drain(void);
+static void write_all(const char *data, size_t len);
+static void *writer_main(void *arg);
+
+/**
+ * @brief Queue a message that has passed the level check.
+ */
+static void queue_message(log_level_t level, const char *fmt, va_list args);
+static void exit_handler(void);
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+bool log_init(void)
+{
+    if (atomic_load(&enabled)) {
+        return true;
+    }
+
+    atomic_store(&writer_run, true);
+    int error = pthread_create(&writer_thread, NULL, writer_main, NULL);
+    if (error != 0) {
+        printf("log: can't create the writer thread: %s\n", strerror(error));
+        atomic_store(&writer_run, false);
+        return false;
+    }
+
+    if (!exit_handler_added) {
+        atexit(exit_handler);
+        exit_handler_added = true;
+    }
+
+    atomic_store(&enabled, true);
+    return true;
+}
+
+void log_deinit(void)
+{
+    if (!atomic_load(&enabled)) {
+        return;
+    }
+
+    /* New messages go straight out, the writer empties the rings and exits */
+    atomic_store(&enabled, false);
+
+    pthread_mutex_lock(&wake_lock);
+    atomic_store(&writer_run, false);
+    pthread_cond_signal(&wake_cond);
+    pthread_mutex_unlock(&wake_lock);
+
+    pthread_join(writer_thread, NULL);
+}
+
+void log_write(log_level_t level, const char *fmt, ...)
+{
+    va_list args;
+
+    if ((int)level > atomic_load_explicit(&max_level, memory_order_relaxed)) {
+        return;
+    }
+
+    va_start(args, fmt);
+    log_vwrite(level, fmt, args);
+    va_end(args);
+}
+
+void log_vwrite(log_level_t level, const char *fmt, va_list args)
+{
+    if ((NULL == fmt) || ((int)level > atomic_load_explicit(&max_level, memory_order_relaxed))) {
+        return;
+    }
+
+    queue_message(level, fmt, args);
+}
+
+void log_print(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    log_vprint(fmt, args);
+    va_end(args);
+}
+
+void log_vprint(const char *fmt, va_list args)
+{
+    if (NULL == fmt) {
+        return;
+    }
+
+    queue_message(LOG_LEVEL_INFO, fmt, args);
+}
+
+static void queue_message(log_level_t level, const char *fmt, va_list args)
+{
+    _Alignas(8) uint8_t rec[LOG_MAX_RECORD];
+    log_ring_t *ring;
+
+    if (!atomic_load_explicit(&enabled, memory_order_acquire)) {
+        vprintf(fmt, args);
+        return;
+    }
+
+    ring = get_ring();
+    if (NULL == ring) {
+        atomic_fetch_add_explicit(&no_ring_dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    uint64_t seq = atomic_fetch_add_explicit(&next_seq, 1, memory_order_relaxed);
+    size_t size = log_encode_record(rec, level, seq, fmt, args);
+
+    if (!ring_push(ring, rec, size)) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    /* Only pay for a wakeup when the writer has gone to sleep. The fence
+     * pairs with the writer's: either it sees the record or we see the flag. */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&writer_sleeping) && atomic_exchange(&writer_sleeping, false)) {
+        pthread_mutex_lock(&wake_lock);
+        pthread_cond_signal(&wake_cond);
+        pthread_mutex_unlock(&wake_lock);
+    }
+}
+
+void log_set_level(log_level_t level)
+{
+    if (level < LOG_LEVEL_MAX) {
+        atomic_store(&max_level, (int)level);
+    }
+}
+
+log_level_t log_get_level(void)
+{
+    return (log_level_t)atomic_load(&max_level);
+}
+
+uint64_t log_get_dropped(void)
+{
+    uint64_t dropped = atomic_load(&total_dropped) + atomic_load(&no_ring_dropped);
+    uint32_t count = atomic_load(&ring_count);
+
+    /* Add what the writer hasn't reported yet */
+    for (uint32_t i = 0; (i < count) && (i < LOG_MAX_THREADS); i++) {
+        dropped += atomic_load(&rings[i].dropped);
+    }
+    return dropped;
+}
+
+size_t log_encode_record(void *rec, log_level_t level, uint64_t seq, const char *fmt, va_list args)
+{
+    log_hdr_t *hdr = rec;
+    log_arg_t *av = (log_arg_t *)(hdr + 1);
+    uint8_t *base = rec;
+    size_t nargs = 0;
+    size_t used;
+    log_spec_t spec;
+    const char *p;
+
+    /* Count the arguments first so the strings can go straight after them */
+    for (p = strchr(fmt, '%'); NULL != p; p = strchr(p, '%')) {
+        p = parse_spec(p + 1, &spec);
+        if ('\0' == spec.conv) {
+            break;
+        }
+        nargs += (spec.width_star ? 1 : 0) + (spec.prec_star ? 1 : 0) + (((spec.conv != '%') && (spec.conv != 'n')) ? 1 : 0);
+    }
+    if (nargs > LOG_MAX_ARGS) {
+        nargs = LOG_MAX_ARGS;
+    }
+
+    used = sizeof(log_hdr_t) + (nargs * sizeof(log_arg_t));
+    size_t ai = 0;
+
+    for (p = strchr(fmt, '%'); (NULL != p) && (ai < nargs); p = strchr(p, '%')) {
+        p = parse_spec(p + 1, &spec);
+        int prec = spec.prec;
+
+        if ('\0' == spec.conv) {
+            break;
+        }
+        if (spec.width_star && (ai < nargs)) {
+            av[ai++].i = va_arg(args, int);
+        }
+        if (spec.prec_star && (ai < nargs)) {
+            prec = va_arg(args, int);
+            av[ai++].i = prec;
+        }
+        if (ai >= nargs) {
+            break;
+        }
+
+        switch (spec.conv) {
+        case 'd':
+        case 'i':
+            switch (spec.length) {
+            case LOG_LEN_HH: av[ai++].i = (signed char)va_arg(args, int); break;
+            case LOG_LEN_H:  av[ai++].i = (short)va_arg(args, int); break;
+            case LOG_LEN_L:  av[ai++].i = va_arg(args, long); break;
+            case LOG_LEN_LL: av[ai++].i = va_arg(args, long long); break;
+            case LOG_LEN_Z:
+            case LOG_LEN_T:  av[ai++].i = va_arg(args, ptrdiff_t); break;
+            case LOG_LEN_J:  av[ai++].i = va_arg(args, intmax_t); break;
+            default:         av[ai++].i = va_arg(args, int); break;
+            }
+            break;
+
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            switch (spec.length) {
+            case LOG_LEN_HH: av[ai++].u = (unsigned char)va_arg(args, unsigned int); break;
+            case LOG_LEN_H:  av[ai++].u = (unsigned short)va_arg(args, unsigned int); break;
+            case LOG_LEN_L:  av[ai++].u = va_arg(args, unsigned long); break;
+            case LOG_LEN_LL: av[ai++].u = va_arg(args, unsigned long long); break;
+            case LOG_LEN_Z:  av[ai++].u = va_arg(args, size_t); break;
+            case LOG_LEN_T:  av[ai++].u = (uint64_t)va_arg(args, ptrdiff_t); break;
+            case LOG_LEN_J:  av[ai++].u = va_arg(args, uintmax_t); break;
+            default:         av[ai++].u = va_arg(args, unsigned int); break;
+            }
+            break;
+
+        case 'c':
+            av[ai++].i = va_arg(args, int);
+            break;
+
+        case 'f': case 'F': case 'e': case 'E':
+        case 'g': case 'G': case 'a': case 'A':
+            av[ai++].d = (LOG_LEN_BIG_L == spec.length) ? (double)va_arg(args, long double) : va_arg(args, double);
+            break;
+
+        case 's':
+        {
+            /* Copy the string, at most the precision (it may not be terminated) */
+            const char *s = va_arg(args, const char *);
+            size_t room = LOG_MAX_RECORD - used;
+            if (NULL == s) {
+                s = "(null)";
+            }
+            if (room == 0) {
+                av[ai++].u = LOG_NO_STRING;
+                break;
+            }
+            size_t len = strnlen(s, ((prec >= 0) && ((size_t)prec < room - 1)) ? (size_t)prec : room - 1);
+            memcpy(base + used, s, len);
+            base[used + len] = '\0';
+            av[ai++].u = used;
+            used += len + 1;
+            break;
+        }
+
+        case 'p':
+            av[ai++].p = va_arg(args, const void *);
+            break;
+
+        case 'n':
+            (void)va_arg(args, void *);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    hdr->size = (uint32_t)((used + 7U) & ~(size_t)7U);
+    hdr->level = (uint8_t)level;
+    hdr->nargs = (uint8_t)ai;
+    hdr->reserved = 0;
+    hdr->seq = seq;
+    hdr->fmt = fmt;
+
+    return hdr->size;
+}
+
+size_t log_format_record(const void *record, char *out, size_t len)
+{
+    const log_hdr_t *hdr = record;
+    const log_arg_t *av = (const log_arg_t *)(hdr + 1);
+    const uint8_t *base = record;
+    const char *p = hdr->fmt;
+    size_t pos = 0;
+    size_t ai = 0;
+    log_spec_t spec;
+    char sfmt[48];
+
+    if ((NULL == out) || (0 == len)) {
+        return 0;
+    }
+
+    while (('\0' != *p) && (pos + 1 < len)) {
+        if ('%' != *p) {
+            out[pos++] = *p++;
+            continue;
+        }
+
+        const char *next = parse_spec(p + 1, &spec);
+        if ('%' == spec.conv) {
+            out[pos++] = '%';
+            p = next;
+            continue;
+        }
+        if (('\0' == spec.conv) || ('n' == spec.conv)) {
+            p = next;
+            continue;
+        }
+
+        /* Rebuild the specification with the * values filled in and a
+         * length that matches how the argument was stored */
+        size_t n = 0;
+        int width = spec.width;
+        int prec = spec.prec;
+        sfmt[n++] = '%';
+        if (spec.width_star) {
+            if (ai >= hdr->nargs) break;
+            width = (int)av[ai++].i;
+            if (width < 0) {
+                sfmt[n++] = '-';
+                width = -width;
+            }
+        }
+        if (spec.prec_star) {
+            if (ai >= hdr->nargs) break;
+            prec = (int)av[ai++].i;
+        }
+        if (ai >= hdr->nargs) {
+            break;
+        }
+        memcpy(&sfmt[n], spec.flags, spec.flags_len);
+        n += spec.flags_len;
+        if (width >= 0) {
+            n += (size_t)snprintf(&sfmt[n], sizeof(sfmt) - n, "%d", width);
+        }
+        if (prec >= 0) {
+            n += (size_t)snprintf(&sfmt[n], sizeof(sfmt) - n, ".%d", prec);
+        }
+
+        int written;
+        switch (spec.conv) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            sfmt[n++] = 'l';
+            sfmt[n++] = 'l';
+            sfmt[n++] = spec.conv;
+            sfmt[n] = '\0';
+            if (('d' == spec.conv) || ('i' == spec.conv)) {
+                written = snprintf(&out[pos], len - pos, sfmt, (long long)av[ai++].i);
+            }
+            else {
+                written = snprintf(&out[pos], len - pos, sfmt, (unsigned long long)av[ai++].u);
+            }
+            break;
+
+        case 'c':
+            sfmt[n++] = 'c';
+            sfmt[n] = '\0';
+            written = snprintf(&out[pos], len - pos, sfmt, (int)av[ai++].i);
+            break;
+
+        case 'f': case 'F': case 'e': case 'E':
+        case 'g': case 'G': case 'a': case 'A':
+            sfmt[n++] = spec.conv;
+            sfmt[n] = '\0';
+            written = snprintf(&out[pos], len - pos, sfmt, av[ai++].d);
+            break;
+
+        case 's':
+        {
+            uint64_t ofs = av[ai++].u;
+            sfmt[n++] = 's';
+            sfmt[n] = '\0';
+            written = snprintf(&out[pos], len - pos, sfmt, (LOG_NO_STRING == ofs) ? "" : (const char *)(base + ofs));
+            break;
+        }
+
+        case 'p':
+            sfmt[n++] = 'p';
+            sfmt[n] = '\0';
+            written = snprintf(&out[pos], len - pos, sfmt, av[ai++].p);
+            break;
+
+        default:
+            /* Not a conversion we know, print it as it was written */
+            written = snprintf(&out[pos], len - pos, "%.*s", (int)(next - p), p);
+            break;
+        }
+
+        if (written > 0) {
+            pos += ((size_t)written < len - pos) ? (size_t)written : (len - pos - 1);
+        }
+        p = next;
+    }
+
+    out[pos] = '\0';
+    return pos;
+}
+
+/**
+ * @brief Parse a conversion specification. p points just after the '%'.
+ *
+ * @return the first character after the specification
+ */
+static const char *parse_spec(const char *p, log_spec_t *spec)
+{
+    spec->flags = p;
+    while (('-' == *p) || ('+' == *p) || (' ' == *p) || ('#' == *p) || ('0' == *p)) {
+        p++;
+    }
+    spec->flags_len = (uint8_t)(p - spec->flags);
+    if (spec->flags_len > 8) {
+        spec->flags_len = 8;
+    }
+
+    spec->width_star = false;
+    spec->width = -1;
+    if ('*' == *p) {
+        spec->width_star = true;
+        p++;
+    }
+    else if ((*p >= '0') && (*p <= '9')) {
+        spec->width = 0;
+        while ((*p >= '0') && (*p <= '9')) {
+            spec->width = (spec->width * 10) + (*p++ - '0');
+        }
+    }
+
+    spec->prec_star = false;
+    spec->prec = -1;
+    if ('.' == *p) {
+        p++;
+        spec->prec = 0;
+        if ('*' == *p) {
+            spec->prec_star = true;
+            p++;
+        }
+        else {
+            while ((*p >= '0') && (*p <= '9')) {
+                spec->prec = (spec->prec * 10) + (*p++ - '0');
+            }
+        }
+    }
+
+    spec->length = LOG_LEN_NONE;
+    switch (*p) {
+    case 'h':
+        p++;
+        spec->length = LOG_LEN_H;
+        if ('h' == *p) {
+            p++;
+            spec->length = LOG_LEN_HH;
+        }
+        break;
+    case 'l':
+        p++;
+        spec->length = LOG_LEN_L;
+        if ('l' == *p) {
+            p++;
+            spec->length = LOG_LEN_LL;
+        }
+        break;
+    case 'z': p++; spec->length = LOG_LEN_Z; break;
+    case 'j': p++; spec->length = LOG_LEN_J; break;
+    case 't': p++; spec->length = LOG_LEN_T; break;
+    case 'L': p++; spec->length = LOG_LEN_BIG_L; break;
+    default: break;
+    }
+
+    spec->conv = *p;
+    return ('\0' == *p) ? p : (p + 1);
+}
+
+/**
+ * @brief The calling thread's ring, claimed on first use.
+ */
+static log_ring_t *get_ring(void)
+{
+    if ((NULL == my_ring) && !my_ring_failed) {
+        uint32_t index = atomic_fetch_add(&ring_count, 1);
+        if (index < LOG_MAX_THREADS) {
+            my_ring = &rings[index];
+        }
+        else {
+            my_ring_failed = true;
+        }
+    }
+    return my_ring;
+}
+
+/**
+ * @brief Copy a record into the ring. Records never wrap: the end of the ring is padded instead.
+ */
+static bool ring_push(log_ring_t *ring, const void *rec, size_t size)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t space = LOG_RING_BYTES - (head - tail);
+    size_t ofs = head & (LOG_RING_BYTES - 1);
+    size_t to_end = LOG_RING_BYTES - ofs;
+    size_t pad = (to_end < size) ? to_end : 0;
+
+    if (size + pad > space) {
+        return false;
+    }
+
+    if (pad > 0) {
+        /* Every record is a multiple of 8 bytes, so there is room for the size field */
+        *(uint32_t *)&ring->buf[ofs] = 0;
+        ofs = 0;
+    }
+
+    memcpy(&ring->buf[ofs], rec, size);
+    atomic_store_explicit(&ring->head, head + pad + size, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief The oldest record in a ring, skipping padding. NULL if the ring is empty.
+ */
+static const log_hdr_t *ring_peek(log_ring_t *ring)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    while (tail != head) {
+        size_t ofs = tail & (LOG_RING_BYTES - 1);
+        const log_hdr_t *hdr = (const log_hdr_t *)&ring->buf[ofs];
+        if (0 != hdr->size) {
+            return hdr;
+        }
+        tail += LOG_RING_BYTES - ofs;
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Format and write everything queued, oldest first across all threads.
+ *
+ * @return number of records written
+ */
+static size_t drain(void)
+{
+    uint32_t count = atomic_load(&ring_count);
+    size_t pos = 0;
+    size_t records = 0;
+    uint64_t dropped;
+
+    if (count > LOG_MAX_THREADS) {
+        count = LOG_MAX_THREADS;
+    }
+
+    for (;;) {
+        log_ring_t *oldest = NULL;
+        const log_hdr_t *oldest_hdr = NULL;
+
+        for (uint32_t i = 0; i < count; i++) {
+            const log_hdr_t *hdr = ring_peek(&rings[i]);
+            if ((NULL != hdr) && ((NULL == oldest_hdr) || (hdr->seq < oldest_hdr->seq))) {
+                oldest = &rings[i];
+                oldest_hdr = hdr;
+            }
+        }
+        if (NULL == oldest) {
+            break;
+        }
+
+        if (LOG_OUT_BYTES - pos < LOG_LINE_BYTES) {
+            write_all(out_buf, pos);
+            pos = 0;
+        }
+        pos += log_format_record(oldest_hdr, &out_buf[pos], LOG_LINE_BYTES);
+        records++;
+
+        atomic_store_explicit(&oldest->tail, atomic_load_explicit(&oldest->tail, memory_order_relaxed) + oldest_hdr->size,
+            memory_order_release);
+    }
+
+    /* Say when messages were lost, once per batch */
+    dropped = atomic_exchange(&no_ring_dropped, 0);
+    for (uint32_t i = 0; i < count; i++) {
+        dropped += atomic_exchange(&rings[i].dropped, 0);
+    }
+    if (dropped > 0) {
+        atomic_fetch_add(&total_dropped, dropped);
+        if (LOG_OUT_BYTES - pos < LOG_LINE_BYTES) {
+            write_all(out_buf, pos);
+            pos = 0;
+        }
+        pos += (size_t)snprintf(&out_buf[pos], LOG_OUT_BYTES - pos, "[log] %llu messages dropped\n",
+            (unsigned long long)dropped);
+    }
+
+    write_all(out_buf, pos);
+    return records;
+}
+
+/**
+ * @brief write() until everything is out.
+ */
+static void write_all(const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(STDOUT_FILENO, data, len);
+        if (n < 0) {
+            if (EINTR == errno)
+                continue;
+            return;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+/**
+ * @brief Writer thread: drain, then sleep until a producer wakes it.
+ */
+static void *writer_main(void *arg)
+{
+    (void)arg;
+
+    /* Anything printed before log_init goes out first */
+    fflush(stdout);
+
+    while (atomic_load(&writer_run)) {
+        if (drain() > 0) {
+            continue;
+        }
+
+        pthread_mutex_lock(&wake_lock);
+        atomic_store(&writer_sleeping, true);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        /* Check again now that producers will wake us, so nothing is missed */
+        bool idle = atomic_load(&writer_run);
+        for (uint32_t i = 0; idle && (i < atomic_load(&ring_count)) && (i < LOG_MAX_THREADS); i++) {
+            idle = (NULL == ring_peek(&rings[i]));
+        }
+        if (idle) {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += (long)LOG_IDLE_MS * 1000000L;
+            if (ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&wake_cond, &wake_lock, &ts);
+        }
+
+        atomic_store(&writer_sleeping, false);
+        pthread_mutex_unlock(&wake_lock);
+    }
+
+    drain();
+    return NULL;
+}
+
+/**
+ * @brief Flush at exit, for returns from main that skip log_deinit.
+ */
+static void exit_handler(void)
+{
+    log_deinit();
+    fflush(stdout);
+}
@@ -0,0 +1,167 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        log.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+#ifndef LOG_H_
+#define LOG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Bytes in each thread's ring, power of 2 */
+#define LOG_RING_BYTES      (64U * 1024U)
+
+/* Threads that can log through their own ring */
+#define LOG_MAX_THREADS     8U
+
+/* Largest record: header, arguments and copied strings. Longer strings are cut. */
+#define LOG_MAX_RECORD      1024U
+
+/* Most arguments in one message */
+#define LOG_MAX_ARGS        12U
+
+/* Shorthands. The format must be a string literal (or otherwise outlive the
+ * message): only the pointer is stored and formatting happens later. */
+#define log_error(...)      log_write(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define log_warn(...)       log_write(LOG_LEVEL_WARN, __VA_ARGS__)
+#define log_info(...)       log_write(LOG_LEVEL_INFO, __VA_ARGS__)
+#define log_debug(...)      log_write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+/*****************************************************************************
+ * Structs, Unions, Enums, & Typedefs
+ *****************************************************************************/
+
+typedef enum log_level_t {
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_MAX
+} log_level_t;
+
+/*****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Start the writer thread. Until this is called, messages are printed directly.
+ *
+ * Anything still queued is written at exit, so early returns from main don't lose messages.
+ *
+ * @return true if successful
+ */
+bool log_init(void);
+
+/**
+ * @brief Write everything that is queued and stop the writer thread.
+ */
+void log_deinit(void);
+
+/**
+ * @brief Queue a message. Never blocks: the arguments are copied to the
+ *        calling thread's ring and formatted by the writer thread.
+ *
+ * Conversions are the printf ones (flags, width, precision, * and the
+ * hh/h/l/ll/z/j/t length modifiers) except %n and long double. Strings are
+ * copied, so %s can point at a temporary buffer.
+ *
+ * @param level message level, nothing is queued above the current level
+ * @param fmt printf style format, must outlive the message (a literal)
+ */
+void log_write(log_level_t level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief log_write with a va_list.
+ */
+void log_vwrite(log_level_t level, const char *fmt, va_list args);
+
+/**
+ * @brief Queue the output of a command. Like log_write() but never filtered
+ *        by the level, so commands still answer after "log level error".
+ *
+ * @param fmt printf style format, must outlive the message (a literal)
+ */
+void log_print(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief log_print with a va_list.
+ */
+void log_vprint(const char *fmt, va_list args);
+
+/**
+ * @brief Set the most detailed level that is logged. The default is LOG_LEVEL_INFO.
+ */
+void log_set_level(log_level_t level);
+
+/**
+ * @brief Get the current level.
+ */
+log_level_t log_get_level(void);
+
+/**
+ * @brief Number of messages dropped because a ring was full (or no ring was left).
+ */
+uint64_t log_get_dropped(void);
+
+/**
+ * @brief Format a queued record into a buffer. Used by the writer thread.
+ *
+ * @param record record as queued by log_write
+ * @param out output buffer
+ * @param len size of out
+ * @return length of the formatted text (cut to len - 1)
+ */
+size_t log_format_record(const void *record, char *out, size_t len);
+
+/**
+ * @brief Encode a message into a record as log_write would queue it.
+ *
+ * @param rec output buffer, at least LOG_MAX_RECORD bytes, 8 byte aligned
+ * @param level message level
+ * @param seq sequence number
+ * @param fmt printf style format
+ * @param args the arguments
+ * @return record size in bytes
+ */
+size_t log_encode_record(void *rec, log_level_t level, uint64_t seq, const char *fmt, va_list args);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* LOG_H_ */
@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <getopt.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
@@ -37,6 +38,11 @@
 
 #include "app/app.h"
 #include "app/app_cli.h"
+#include "app/app_script.h"
+#include "app/app_metrics.h"
+#include "app/app_bridge.h"
+#include "log/log.h"
+#include "trace/trace.h"
 
 
 /*****************************************************************************
@@ -84,9 +90,20 @@ int main(int argc, char *argv[])
     /* OPTION VARIABLES */
     int opt = 0;
     char *port_name = NULL;
+    char *script_name = NULL;
+    char *metrics_endpoint = NULL;
+    char *metrics_file = NULL;
+    char *bridge_endpoint = NULL;
+    bool headless = APP_HEADLESS;
+
+    static const struct option long_options[] = {
+        { "headless", no_argument, NULL, 'H' },
+        { "help",     no_argument, NULL, 'h' },
+        { NULL,       0,           NULL, 0 }
+    };
 
     /* PROCESS OPTIONS */
-    while ((opt = getopt(argc, argv, "s:h")) != -1) 
+    while ((opt = getopt_long(argc, argv, "s:x:m:M:b:Hh", long_options, NULL)) != -1) 
     {
         switch(opt) 
         {
@@ -94,6 +111,21 @@ int main(int argc, char *argv[])
             port_name = optarg;
             printf("\nport_name: %s\n", port_name);
             break;  
+        case 'x':
+            script_name = optarg;
+            break;
+        case 'm':
+            metrics_endpoint = optarg;
+            break;
+        case 'M':
+            metrics_file = optarg;
+            break;
+        case 'b':
+            bridge_endpoint = optarg;
+            break;
+        case 'H':
+            headless = true;
+            break;
         case 'h':
             show_help_message();
             
@@ -111,7 +143,17 @@ int main(int argc, char *argv[])
         return 0;
     }
 
-    if (!app_init(port_name)) {
+    /* Module output goes through the logger from here on. Without the
+     * writer thread it falls back to printing directly. */
+    if (!log_init()) {
+        printf("Logger failed initialization, printing directly\n");
+    }
+
+    /* Recording starts with the "trace start" command */
+    trace_init();
+    TRACE_THREAD_NAME("main");
+
+    if (!app_init(port_name, headless)) {
         printf("APP failed initialization\n");
         return 0;
     }
@@ -122,13 +164,33 @@ int main(int argc, char *argv[])
         return 0;
     }
 
+    /* Not fatal: the tool is still useful without its dashboards */
+    if((metrics_endpoint != NULL) && !app_metrics_listen(metrics_endpoint))
+    {
+        printf("Metrics endpoint %s failed to open\n", metrics_endpoint);
+    }
+
+    if((metrics_file != NULL) && !app_metrics_set_file(metrics_file, 0))
+    {
+        printf("Metrics file %s can't be written\n", metrics_file);
+    }
+
+    if((bridge_endpoint != NULL) && !app_bridge_listen(bridge_endpoint))
+    {
+        printf("Bridge %s failed to open\n", bridge_endpoint);
+    }
+
+    /* Every command is registered by now. The main loop runs the script. */
+    if((script_name != NULL) && !app_script_run(script_name))
+    {
+        printf("Script %s failed to load\n", script_name);
+    }
+
     do {
-        /* Call the app task handler */
+        /* Wait for and handle serial data, timers and CLI input. The CLI
+         * input thread wakes the loop, so app_cli_process() runs from there. */
         app_task_handler();
 
-        /* Periodically process the CLI */
-        app_cli_process();
-
     /* Cntrl-C to end process or change the while statement to end after a period of time... or some other condition */
     } while(keep_running);   //  CLI command to quit, exit, q, stop, will change this to false.
 
@@ -136,6 +198,8 @@ int main(int argc, char *argv[])
 
     app_deinit();
 
+    log_deinit();
+
     return 0;
 }
 
@@ -145,6 +209,11 @@ static void show_help_message()
     printf("serial_tool - C-based serial development tool\n");
     printf("-------------------------------------------------------------------\n");
     printf("-s <port_name> : select the attached USB-to-serial cable as enumerated in /dev (ie. /dev/ttyUSB0)\n");
+    printf("-x <script> : run the commands in a script file after start up (see the source command)\n");
+    printf("-m <port|path> : serve Prometheus metrics on 127.0.0.1:<port> or a Unix socket\n");
+    printf("-M <file> : rewrite a file with the metrics every 10 s\n");
+    printf("-b <port|path> : share the port with other tools on 127.0.0.1:<port> or a Unix socket\n");
+    printf("-H, --headless : run without the GUI (serial_tool_headless always does)\n");
     printf("-h : show help\n\n");
     printf("Usage: serial_tool -s <port_name>\n");
     printf("Example: \n");
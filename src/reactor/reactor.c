@@ -0,0 +1,398 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        reactor.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#include "../time_funcs/time_funcs.h"
+#include "../trace/trace.h"
+#include "../log/log.h"
+#include "reactor.h"
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Events handled per epoll_wait() call */
+#define REACTOR_MAX_EVENTS  16
+
+/**
+ * @brief What kind of descriptor a handler watches, decides who reads and closes it.
+ */
+typedef enum handler_kind_t {
+    HANDLER_FREE,
+    HANDLER_RETIRED,    /**< Removed during a batch, free once the batch is done */
+    HANDLER_FD,         /**< Caller's descriptor, left alone */
+    HANDLER_TIMER,      /**< timerfd owned by the reactor */
+    HANDLER_WAKEUP,     /**< eventfd owned by the reactor */
+} handler_kind_t;
+
+typedef struct handler_t {
+    handler_kind_t kind;
+    int fd;
+    uint32_t events;
+    reactor_cb_t cb;
+    void *ctx;
+} handler_t;
+
+typedef struct prepare_t {
+    reactor_prepare_cb_t cb;
+    void *ctx;
+} prepare_t;
+
+/*****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+static int epoll_fd = -1;
+
+static handler_t handlers[REACTOR_MAX_HANDLERS];
+
+static prepare_t prepares[REACTOR_MAX_PREPARE];
+static uint32_t prepare_count = 0;
+
+static uint64_t wake_ns = 0;
+
+/* Set while reactor_run_once() hands out a batch of events */
+static bool dispatching = false;
+static uint32_t retired_count = 0;
+
+/*****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+static handler_t *add_handler(handler_kind_t kind, int fd, uint32_t events, reactor_cb_t cb, void *ctx);
+static handler_t *find_handler(int fd);
+static void free_retired(void);
+static uint32_t to_epoll(uint32_t events);
+static uint32_t from_epoll(uint32_t events);
+
+/*****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+bool reactor_init(void)
+{
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        log_error("reactor: epoll_create1 failed: %s\n", strerror(errno));
+        return false;
+    }
+
+    memset(handlers, 0, sizeof(handlers));
+    prepare_count = 0;
+    dispatching = false;
+    retired_count = 0;
+
+    return true;
+}
+
+void reactor_deinit(void)
+{
+    for (uint32_t i = 0; i < REACTOR_MAX_HANDLERS; i++) {
+        if (HANDLER_FREE != handlers[i].kind) {
+            reactor_remove(handlers[i].fd);
+        }
+    }
+    free_retired();
+
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+        epoll_fd = -1;
+    }
+    prepare_count = 0;
+}
+
+bool reactor_add_fd(int fd, uint32_t events, reactor_cb_t cb, void *ctx)
+{
+    return (NULL != add_handler(HANDLER_FD, fd, events, cb, ctx));
+}
+
+bool reactor_set_events(int fd, uint32_t events)
+{
+    handler_t *h = find_handler(fd);
+    struct epoll_event ev;
+
+    if (NULL == h)
+        return false;
+
+    if (h->events == events)
+        return true;
+
+    ev.events = to_epoll(events);
+    ev.data.ptr = h;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) != 0) {
+        log_error("reactor: can't modify fd %d: %s\n", fd, strerror(errno));
+        return false;
+    }
+
+    h->events = events;
+    return true;
+}
+
+void reactor_remove(int fd)
+{
+    handler_t *h = find_handler(fd);
+
+    if (NULL == h)
+        return;
+
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+
+    if ((HANDLER_TIMER == h->kind) || (HANDLER_WAKEUP == h->kind)) {
+        close(fd);
+    }
+
+    /* Events already returned for this handler in the current batch are
+     * skipped. The slot stays retired until the batch is done, otherwise a
+     * handler added by a later callback could take it and get those events. */
+    if (dispatching) {
+        h->kind = HANDLER_RETIRED;
+        retired_count++;
+    } else {
+        h->kind = HANDLER_FREE;
+    }
+    h->fd = -1;
+    h->cb = NULL;
+}
+
+int reactor_add_timer(uint64_t delay_ns, uint64_t period_ns, reactor_cb_t cb, void *ctx)
+{
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        log_error("reactor: timerfd_create failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    if (NULL == add_handler(HANDLER_TIMER, fd, REACTOR_EV_READ, cb, ctx)) {
+        close(fd);
+        return -1;
+    }
+
+    reactor_arm_timer(fd, delay_ns, period_ns);
+    return fd;
+}
+
+bool reactor_arm_timer(int fd, uint64_t delay_ns, uint64_t period_ns)
+{
+    struct itimerspec its;
+
+    its.it_value.tv_sec = (time_t)(delay_ns / NSEC_PER_SEC);
+    its.it_value.tv_nsec = (long)(delay_ns % NSEC_PER_SEC);
+    its.it_interval.tv_sec = (time_t)(period_ns / NSEC_PER_SEC);
+    its.it_interval.tv_nsec = (long)(period_ns % NSEC_PER_SEC);
+
+    return (timerfd_settime(fd, 0, &its, NULL) == 0);
+}
+
+int reactor_add_wakeup(reactor_cb_t cb, void *ctx)
+{
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) {
+        log_error("reactor: eventfd failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    if (NULL == add_handler(HANDLER_WAKEUP, fd, REACTOR_EV_READ, cb, ctx)) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+void reactor_wakeup(int fd)
+{
+    uint64_t one = 1;
+
+    if (fd < 0)
+        return;
+
+    /* Only fails if the counter would overflow, and then a wakeup is already pending */
+    (void)!write(fd, &one, sizeof(one));
+}
+
+bool reactor_add_prepare(reactor_prepare_cb_t cb, void *ctx)
+{
+    if ((NULL == cb) || (prepare_count >= REACTOR_MAX_PREPARE))
+        return false;
+
+    prepares[prepare_count].cb = cb;
+    prepares[prepare_count].ctx = ctx;
+    prepare_count++;
+
+    return true;
+}
+
+int reactor_run_once(int timeout_ms)
+{
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    uint64_t counter;
+    int dispatched = 0;
+
+    if (epoll_fd < 0)
+        return -1;
+
+    /* The shortest limit from any prepare callback wins */
+    for (uint32_t i = 0; i < prepare_count; i++) {
+        int limit = prepares[i].cb(prepares[i].ctx);
+        if ((limit >= 0) && ((timeout_ms < 0) || (limit < timeout_ms))) {
+            timeout_ms = limit;
+        }
+    }
+
+    /* Shows the idle time between the busy slices */
+    TRACE_BEGIN("reactor_wait");
+    int n = epoll_wait(epoll_fd, events, REACTOR_MAX_EVENTS, timeout_ms);
+    TRACE_END("reactor_wait");
+    wake_ns = get_nanos();
+    if (n < 0) {
+        if (EINTR == errno)
+            return 0;
+        log_error("reactor: epoll_wait failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    dispatching = true;
+    for (int i = 0; i < n; i++) {
+        handler_t *h = events[i].data.ptr;
+
+        /* Removed by an earlier callback in this batch */
+        if (HANDLER_RETIRED == h->kind)
+            continue;
+
+        /* Timers and wakeups are counters: read them so they don't stay ready */
+        if ((HANDLER_TIMER == h->kind) || (HANDLER_WAKEUP == h->kind)) {
+            if (read(h->fd, &counter, sizeof(counter)) != (ssize_t)sizeof(counter))
+                continue;
+        }
+
+        h->cb(h->fd, from_epoll(events[i].events), h->ctx);
+        dispatched++;
+    }
+    dispatching = false;
+    free_retired();
+
+    return dispatched;
+}
+
+uint64_t reactor_get_wake_ns(void)
+{
+    return wake_ns;
+}
+
+static handler_t *add_handler(handler_kind_t kind, int fd, uint32_t events, reactor_cb_t cb, void *ctx)
+{
+    struct epoll_event ev;
+    handler_t *h = NULL;
+
+    if ((epoll_fd < 0) || (fd < 0) || (NULL == cb))
+        return NULL;
+
+    for (uint32_t i = 0; i < REACTOR_MAX_HANDLERS; i++) {
+        if (HANDLER_FREE == handlers[i].kind) {
+            h = &handlers[i];
+            break;
+        }
+    }
+
+    if (NULL == h) {
+        log_error("reactor: no free handler for fd %d\n", fd);
+        return NULL;
+    }
+
+    ev.events = to_epoll(events);
+    ev.data.ptr = h;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        log_error("reactor: can't add fd %d: %s\n", fd, strerror(errno));
+        return NULL;
+    }
+
+    h->kind = kind;
+    h->fd = fd;
+    h->events = events;
+    h->cb = cb;
+    h->ctx = ctx;
+
+    return h;
+}
+
+static handler_t *find_handler(int fd)
+{
+    if (fd < 0)
+        return NULL;
+
+    for (uint32_t i = 0; i < REACTOR_MAX_HANDLERS; i++) {
+        if ((HANDLER_FREE != handlers[i].kind) && (handlers[i].fd == fd)) {
+            return &handlers[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void free_retired(void)
+{
+    for (uint32_t i = 0; (i < REACTOR_MAX_HANDLERS) && (retired_count > 0); i++) {
+        if (HANDLER_RETIRED == handlers[i].kind) {
+            handlers[i].kind = HANDLER_FREE;
+            retired_count--;
+        }
+    }
+}
+
+static uint32_t to_epoll(uint32_t events)
+{
+    uint32_t ep = 0;
+
+    if (events & REACTOR_EV_READ)
+        ep |= EPOLLIN;
+    if (events & REACTOR_EV_WRITE)
+        ep |= EPOLLOUT;
+
+    return ep;
+}
+
+static uint32_t from_epoll(uint32_t ep)
+{
+    uint32_t events = 0;
+
+    if (ep & EPOLLIN)
+        events |= REACTOR_EV_READ;
+    if (ep & EPOLLOUT)
+        events |= REACTOR_EV_WRITE;
+    if (ep & (EPOLLERR | EPOLLHUP))
+        events |= REACTOR_EV_ERROR;
+
+    return events;
+}
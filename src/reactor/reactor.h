@@ -0,0 +1,202 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        reactor.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+#ifndef REACTOR_H_
+#define REACTOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Maximum number of file descriptors watched at once */
+#define REACTOR_MAX_HANDLERS    48U
+
+/* Maximum number of prepare callbacks */
+#define REACTOR_MAX_PREPARE     8U
+
+/* Event bits passed to and from the callbacks */
+#define REACTOR_EV_READ         0x01U
+#define REACTOR_EV_WRITE        0x02U
+#define REACTOR_EV_ERROR        0x04U   /**< Error or hang up, always reported */
+
+/*****************************************************************************
+ * Structs, Unions, Enums, & Typedefs
+ *****************************************************************************/
+
+/**
+ * @brief Called when a watched file descriptor is ready.
+ *
+ * For timers and wakeups the reactor has already consumed the counter,
+ * so the callback only has to do its work.
+ *
+ * @param fd the file descriptor that is ready
+ * @param events REACTOR_EV_* bits that are ready
+ * @param ctx context given at registration
+ */
+typedef void (*reactor_cb_t)(int fd, uint32_t events, void *ctx);
+
+/**
+ * @brief Called before the reactor blocks waiting for events.
+ *
+ * Used for work that isn't tied to a file descriptor (topping up a buffer,
+ * updating which events a descriptor is watched for) and to bound the wait.
+ *
+ * @param ctx context given at registration
+ * @return int longest time in ms the reactor may block, -1 for no limit
+ */
+typedef int (*reactor_prepare_cb_t)(void *ctx);
+
+/*****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Create the epoll instance.
+ *
+ * @return true if successful
+ */
+bool reactor_init(void);
+
+/**
+ * @brief Close the epoll instance and every timer/wakeup the reactor created.
+ */
+void reactor_deinit(void);
+
+/**
+ * @brief Watch a file descriptor. The descriptor stays owned by the caller.
+ *
+ * Watching is level triggered: the callback keeps being called while the
+ * descriptor is ready.
+ *
+ * @param fd file descriptor (should be non-blocking)
+ * @param events REACTOR_EV_READ and/or REACTOR_EV_WRITE
+ * @param cb called when ready
+ * @param ctx passed to the callback
+ * @return true if successful
+ */
+bool reactor_add_fd(int fd, uint32_t events, reactor_cb_t cb, void *ctx);
+
+/**
+ * @brief Change the events a watched descriptor is waiting for.
+ *
+ * Cheap to call every loop, nothing is done if the events didn't change.
+ *
+ * @param fd file descriptor already added
+ * @param events REACTOR_EV_READ and/or REACTOR_EV_WRITE
+ * @return true if successful
+ */
+bool reactor_set_events(int fd, uint32_t events);
+
+/**
+ * @brief Stop watching a descriptor. Timers and wakeups created by the reactor are closed.
+ *
+ * Safe to call from inside a callback.
+ *
+ * @param fd file descriptor
+ */
+void reactor_remove(int fd);
+
+/**
+ * @brief Create a timer (timerfd on CLOCK_MONOTONIC).
+ *
+ * @param delay_ns time to the first expiry, 0 leaves the timer disarmed
+ * @param period_ns time between expiries, 0 for a one shot timer
+ * @param cb called on expiry
+ * @param ctx passed to the callback
+ * @return int timer descriptor, -1 on failure
+ */
+int reactor_add_timer(uint64_t delay_ns, uint64_t period_ns, reactor_cb_t cb, void *ctx);
+
+/**
+ * @brief Re-arm (or disarm) a timer created with reactor_add_timer().
+ *
+ * @param fd timer descriptor
+ * @param delay_ns time to the next expiry, 0 to disarm
+ * @param period_ns time between expiries, 0 for one shot
+ * @return true if successful
+ */
+bool reactor_arm_timer(int fd, uint64_t delay_ns, uint64_t period_ns);
+
+/**
+ * @brief Create a wakeup (eventfd) that other threads can signal with reactor_wakeup().
+ *
+ * Several signals before the reactor gets to it result in one callback.
+ *
+ * @param cb called in the reactor thread after a wakeup
+ * @param ctx passed to the callback
+ * @return int wakeup descriptor, -1 on failure
+ */
+int reactor_add_wakeup(reactor_cb_t cb, void *ctx);
+
+/**
+ * @brief Signal a wakeup. Safe to call from any thread.
+ *
+ * @param fd wakeup descriptor
+ */
+void reactor_wakeup(int fd);
+
+/**
+ * @brief Register a callback that runs before every wait.
+ *
+ * @param cb prepare callback
+ * @param ctx passed to the callback
+ * @return true if successful
+ */
+bool reactor_add_prepare(reactor_prepare_cb_t cb, void *ctx);
+
+/**
+ * @brief Run the prepare callbacks, wait for events and dispatch them.
+ *
+ * @param timeout_ms longest time to block, -1 to wait until something happens
+ * @return int number of callbacks dispatched, -1 on error
+ */
+int reactor_run_once(int timeout_ms);
+
+/**
+ * @brief Time the last wait returned, 0 before the first one.
+ *
+ * Read from a prepare callback, now minus this is how long the previous
+ * iteration spent dispatching (the loop latency any new event would see).
+ *
+ * @return uint64_t get_nanos() timestamp
+ */
+uint64_t reactor_get_wake_ns(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* REACTOR_H_ */
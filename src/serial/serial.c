@@ -50,6 +50,11 @@
 #endif
 
 #include "../buffer/ring_buf.h"
+#include "../time_funcs/time_funcs.h"
+#include "../log/log.h"
+#include "../trace/trace.h"
+#include "../stats/profiler.h"
+#include "../stats/metrics.h"
 #include "serial.h"
 
 
@@ -66,9 +71,36 @@
 #define BAUD_RATE	B115200
 #endif
 
-#define SERIAL_RX_BUF_LENGTH 1024U * 10U
 #define SERIAL_TX_BUF_LENGTH 1024U * 10U
 
+/* Received data: each read() fills one chunk from the pool, which the
+ * consumers share. A consumer holding on to chunks (e.g. the GUI until its
+ * next frame) only stops reading once all of them are in use, the count
+ * must be a power of two. */
+#define SERIAL_RX_CHUNK_COUNT 256U
+#define SERIAL_RX_CHUNK_LENGTH 1024U
+
+/* Number of read()/write() timestamps remembered per direction */
+#define SERIAL_IO_STAMP_COUNT 256U
+
+/*****************************************************************************
+ * Structs, Unions, Enums, & Typedefs
+ *****************************************************************************/
+
+/**
+ * @brief Timestamps of the most recent read() or write() calls.
+ *
+ * Each entry covers the bytes up to (not including) stream index end, from
+ * the end of the previous entry. Byte indexes count every byte that passed
+ * through the buffer since the port was opened.
+ */
+typedef struct io_stamps_t {
+    uint64_t end[SERIAL_IO_STAMP_COUNT];    /**< Stream index one past the last byte of the call */
+    uint64_t ts[SERIAL_IO_STAMP_COUNT];     /**< CLOCK_MONOTONIC time of the call in ns */
+    uint32_t next;                          /**< Next entry to overwrite */
+    uint32_t used;                          /**< Number of valid entries */
+} io_stamps_t;
+
 /*****************************************************************************
  * Variables
  *****************************************************************************/
@@ -80,13 +112,32 @@ static int serial_port = -1;
 #endif
 
 static ring_buf_t rx_buf, tx_buf;
-static uint8_t rx_data[SERIAL_RX_BUF_LENGTH];
+static chunk_pool_t rx_pool;
+static chunk_t *rx_data[SERIAL_RX_CHUNK_COUNT + 1U];
 static uint8_t tx_data[SERIAL_TX_BUF_LENGTH];
 
+/* Running byte counts, used to match bytes with the I/O call that moved them */
+static uint64_t rx_in_count, rx_out_count;
+static uint64_t tx_in_count, tx_out_count;
+static io_stamps_t rx_stamps, tx_stamps;
+
+static metric_t *rx_bytes_metric, *tx_bytes_metric;
+static metric_t *rx_high_water_metric, *tx_high_water_metric;
+
 /*****************************************************************************
  * Prototypes
  *****************************************************************************/
 
+static void stamp_add(io_stamps_t *stamps, uint64_t end, uint64_t ts);
+static bool stamp_find(const io_stamps_t *stamps, uint64_t index, uint64_t *ts);
+
+/**
+ * @brief Queue a chunk read() just filled, for serial_rx_chunk_pop().
+ */
+static void rx_chunk_add(chunk_t *chunk, size_t len, uint64_t ts);
+
+static uint64_t read_rx_pool_exhausted(void);
+
 /*****************************************************************************
  * Functions
  *****************************************************************************/
@@ -99,7 +150,7 @@ bool serial_init(const char *path)
     serial_port = CreateFile(path, GENERIC_READ | GENERIC_WRITE, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
 
     if (serial_port == INVALID_HANDLE_VALUE) {
-        printf("Error opening serial port %s\n", path);
+        log_error("Error opening serial port %s\n", path);
         return false;
     }
 
@@ -107,7 +158,7 @@ bool serial_init(const char *path)
     dcbSerialParams.DCBlength = sizeof(dcbSerialParams);
 
     if (!GetCommState(serial_port, &dcbSerialParams)) {
-        printf("Error getting serial port state\n");
+        log_error("Error getting serial port state\n");
         return false;
     }
 
@@ -117,7 +168,7 @@ bool serial_init(const char *path)
     dcbSerialParams.Parity = NOPARITY;
 
     if (!SetCommState(serial_port, &dcbSerialParams)) {
-        printf("Error setting serial port state\n");
+        log_error("Error setting serial port state\n");
         return false;
     }
 
@@ -129,7 +180,7 @@ bool serial_init(const char *path)
     timeouts.WriteTotalTimeoutMultiplier = 10;
 
     if (!SetCommTimeouts(serial_port, &timeouts)) {
-        printf("Error setting serial port timeouts\n");
+        log_error("Error setting serial port timeouts\n");
         return false;
     }
 #else
@@ -160,7 +211,7 @@ bool serial_init(const char *path)
     */
     serial_port = open(path, O_RDWR | O_NONBLOCK); // O_NONBLOCK might override VMIN and VTIME, so read() may return immediately.
 
-    printf("path: %s returned %d\n", path, serial_port);
+    log_info("path: %s returned %d\n", path, serial_port);
 
     if(serial_port <= 0)
     {
@@ -182,10 +233,26 @@ bool serial_init(const char *path)
 
 #endif
 
-    /* Initialize rx and tx buffers */
-    ring_buf_init(&rx_buf, rx_data, SERIAL_RX_BUF_LENGTH, sizeof(uint8_t));
+    /* Initialize rx and tx buffers. The RX buffer queues chunk pointers and can hold every chunk. */
+    if (!chunk_pool_init(&rx_pool, SERIAL_RX_CHUNK_COUNT, SERIAL_RX_CHUNK_LENGTH)) {
+        log_error("can't allocate the RX chunks\n");
+        return false;
+    }
+    ring_buf_init(&rx_buf, rx_data, sizeof(rx_data) / sizeof(rx_data[0]), sizeof(chunk_t *));
     ring_buf_init(&tx_buf, tx_data, SERIAL_TX_BUF_LENGTH, sizeof(uint8_t));
 
+    rx_in_count = rx_out_count = 0;
+    tx_in_count = tx_out_count = 0;
+    memset(&rx_stamps, 0, sizeof(rx_stamps));
+    memset(&tx_stamps, 0, sizeof(tx_stamps));
+
+    rx_bytes_metric = metrics_counter("serial_rx_bytes_total", "Bytes read from the serial port");
+    tx_bytes_metric = metrics_counter("serial_tx_bytes_total", "Bytes written to the serial port");
+    rx_high_water_metric = metrics_gauge("serial_rx_buffer_high_water_bytes", "Most bytes waiting in the RX buffer");
+    tx_high_water_metric = metrics_gauge("serial_tx_buffer_high_water_bytes", "Most bytes waiting in the TX buffer");
+    metrics_register_fn("serial_rx_pool_exhausted_total", "Reads put off because every RX chunk was in use",
+                        METRIC_COUNTER, read_rx_pool_exhausted);
+
     return true;
 }
 
@@ -194,65 +261,119 @@ void serial_close()
 #ifdef _WIN32
     if (serial_port != INVALID_HANDLE_VALUE) {
         CloseHandle(serial_port);
-        printf("serial_port closed\n");
+        log_info("serial_port closed\n");
     } else {
-        printf("No port opened\n");
+        log_info("No port opened\n");
     }
     serial_port = INVALID_HANDLE_VALUE;
 #else
     if (serial_port > 0) {
         close(serial_port);
-        printf("serial_port: %d closed\n", serial_port);
+        log_info("serial_port: %d closed\n", serial_port);
     } else {
-        printf("No port opened\n");
+        log_info("No port opened\n");
     }
     serial_port = -1;
 #endif
+
+    /* Every consumer has let go of its chunks by now */
+    serial_rx_buf_clear();
+    chunk_pool_deinit(&rx_pool);
 }
 
 void serial_task()
 {
-    unsigned char c;
-
+    chunk_t *chunk;
+    void *span;
+    size_t span_len;
+    uint64_t start;
+    uint64_t io_bytes = 0;
 
 #ifdef _WIN32
     DWORD bytes_written;
     DWORD bytesRead;
     if (serial_port == INVALID_HANDLE_VALUE) return;
 
-    if (ReadFile(serial_port, &c, 1, &bytesRead, NULL) && bytesRead > 0) {
-        ring_buf_push(&rx_buf, &c);
+    TRACE_BEGIN("serial_task");
+    start = now_cycles();
+
+    chunk = chunk_pool_get(&rx_pool);
+    if (NULL != chunk) {
+        if (ReadFile(serial_port, chunk->data, (DWORD)rx_pool.chunk_size, &bytesRead, NULL) && bytesRead > 0) {
+            rx_chunk_add(chunk, bytesRead, get_nanos());
+            io_bytes += bytesRead;
+        }
+        else {
+            chunk_release(chunk);
+        }
     }
 
-    if (!ring_buf_is_empty(&tx_buf)) {
-        do {
-            if (ring_buf_pop(&tx_buf, &c)) {
-                if (!WriteFile(serial_port, &c, 1, &bytes_written, NULL) || bytes_written != 1) {
-                    fprintf(stderr, "write failed\n");
-                }
-            }
-        } while (!ring_buf_is_empty(&tx_buf));
+    while ((span_len = ring_buf_peek_contig(&tx_buf, &span)) > 0) {
+        if (!WriteFile(serial_port, span, (DWORD)span_len, &bytes_written, NULL) || bytes_written == 0) {
+            log_error("write failed\n");
+            break;
+        }
+        ring_buf_skip(&tx_buf, bytes_written);
+        tx_out_count += bytes_written;
+        io_bytes += bytes_written;
+        metrics_add(tx_bytes_metric, bytes_written);
+        stamp_add(&tx_stamps, tx_out_count, get_nanos());
     }
 #else
-    int bytes_written;
+    ssize_t bytes_read;
+    ssize_t bytes_written;
 
     if (serial_port <= 0) return;
 
-    if (read(serial_port, &c, 1) > 0) {
-        ring_buf_push(&rx_buf, &c);
+    TRACE_BEGIN("serial_task");
+    start = now_cycles();
+
+    /* Read straight into a free chunk. With none free the data waits in the kernel, nothing is dropped. */
+    chunk = chunk_pool_get(&rx_pool);
+    if (NULL != chunk) {
+        bytes_read = read(serial_port, chunk->data, rx_pool.chunk_size);
+        if (bytes_read > 0) {
+            /* Timestamp as close to the syscall as possible, not when the data is consumed */
+            rx_chunk_add(chunk, (size_t)bytes_read, get_nanos());
+            io_bytes += (uint64_t)bytes_read;
+            TRACE_COUNTER("serial_rx_bytes", bytes_read);
+        }
+        else {
+            chunk_release(chunk);
+        }
     }
 
-    if (!ring_buf_is_empty(&tx_buf)) {
-        do {
-            if (ring_buf_pop(&tx_buf, &c)) {
-                bytes_written = write(serial_port, &c, 1);
-                if (1 != bytes_written) {
-                    fprintf(stderr, "write failed\n");
-                }
+    /* Write straight out of the TX buffer until it is empty or the port would block */
+    while ((span_len = ring_buf_peek_contig(&tx_buf, &span)) > 0) {
+        bytes_written = write(serial_port, span, span_len);
+        if (bytes_written < 0) {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                log_error("write failed: %s\n", strerror(errno));
             }
-        } while (!ring_buf_is_empty(&tx_buf));
+            break;
+        }
+        stamp_add(&tx_stamps, tx_out_count + (uint64_t)bytes_written, get_nanos());
+        tx_out_count += (uint64_t)bytes_written;
+        io_bytes += (uint64_t)bytes_written;
+        metrics_add(tx_bytes_metric, (uint64_t)bytes_written);
+        ring_buf_skip(&tx_buf, (size_t)bytes_written);
+        if ((size_t)bytes_written < span_len) {
+            break;
+        }
     }
 #endif
+
+    profiler_record(PROF_STAGE_SERIAL_IO, now_cycles() - start, io_bytes);
+    TRACE_END("serial_task");
+}
+
+int serial_get_fd()
+{
+#ifdef _WIN32
+    return -1;
+#else
+    return (serial_port > 0) ? serial_port : -1;
+#endif
 }
 
 bool serial_rx_buf_is_empty()
@@ -262,17 +383,38 @@ bool serial_rx_buf_is_empty()
 
 bool serial_rx_buf_is_full()
 {
-    return ring_buf_is_full(&rx_buf);
+    return chunk_pool_available(&rx_pool) == 0;
 }
 
 void serial_rx_buf_clear()
 {
-    ring_buf_clear(&rx_buf);
+    chunk_t *chunk;
+
+    while (ring_buf_pop(&rx_buf, &chunk)) {
+        chunk_release(chunk);
+    }
+    rx_out_count = rx_in_count;
+}
+
+chunk_t *serial_rx_chunk_pop()
+{
+    chunk_t *chunk;
+
+    if (!ring_buf_pop(&rx_buf, &chunk)) {
+        return NULL;
+    }
+    rx_out_count += chunk->len;
+    return chunk;
+}
+
+uint64_t serial_rx_pop_count()
+{
+    return rx_out_count;
 }
 
-bool serial_rx_buf_pop(uint8_t *data)
+bool serial_rx_stamp(uint64_t index, uint64_t *ts_ns)
 {
-    return ring_buf_pop(&rx_buf, data);
+    return stamp_find(&rx_stamps, index, ts_ns);
 }
 
 
@@ -289,10 +431,103 @@ bool serial_tx_buf_is_full()
 void serial_tx_buf_clear()
 {
     ring_buf_clear(&tx_buf);
+    tx_in_count = tx_out_count;
 }
 
 bool serial_tx_buf_push(const uint8_t *data)
 {
-    return ring_buf_push(&tx_buf, (void*)data);
+    if (!ring_buf_push(&tx_buf, (void*)data)) {
+        return false;
+    }
+    tx_in_count++;
+    metrics_max(tx_high_water_metric, ring_buf_count(&tx_buf));
+    return true;
+}
+
+size_t serial_tx_buf_space()
+{
+    return ring_buf_space(&tx_buf);
+}
+
+size_t serial_tx_write(const uint8_t *data, size_t len)
+{
+    size_t pushed = ring_buf_push_n(&tx_buf, data, len);
+    tx_in_count += pushed;
+    metrics_max(tx_high_water_metric, ring_buf_count(&tx_buf));
+    return pushed;
+}
+
+uint64_t serial_tx_push_count()
+{
+    return tx_in_count;
 }
 
+bool serial_tx_stamp(uint64_t index, uint64_t *ts_ns)
+{
+    return stamp_find(&tx_stamps, index, ts_ns);
+}
+
+static void rx_chunk_add(chunk_t *chunk, size_t len, uint64_t ts)
+{
+    chunk->len = (uint32_t)len;
+    chunk->port = 0;
+    chunk->timestamp_ns = ts;
+    chunk->first_index = rx_in_count;
+
+    /* Can't fail, the buffer has room for every chunk in the pool */
+    ring_buf_push(&rx_buf, &chunk);
+
+    rx_in_count += (uint64_t)len;
+    stamp_add(&rx_stamps, rx_in_count, ts);
+    metrics_add(rx_bytes_metric, (uint64_t)len);
+    metrics_max(rx_high_water_metric, rx_in_count - rx_out_count);
+}
+
+static uint64_t read_rx_pool_exhausted(void)
+{
+    return chunk_pool_exhausted(&rx_pool);
+}
+
+static void stamp_add(io_stamps_t *stamps, uint64_t end, uint64_t ts)
+{
+    stamps->end[stamps->next] = end;
+    stamps->ts[stamps->next] = ts;
+    stamps->next = (stamps->next + 1) % SERIAL_IO_STAMP_COUNT;
+    if (stamps->used < SERIAL_IO_STAMP_COUNT) {
+        stamps->used++;
+    }
+}
+
+static bool stamp_find(const io_stamps_t *stamps, uint64_t index, uint64_t *ts)
+{
+    if (NULL == ts) {
+        return false;
+    }
+
+    /* Newest first: the answer is almost always one of the last few calls */
+    uint32_t slot = stamps->next;
+    for (uint32_t i = 0; i < stamps->used; i++) {
+        slot = (slot + SERIAL_IO_STAMP_COUNT - 1) % SERIAL_IO_STAMP_COUNT;
+        if (index >= stamps->end[slot]) {
+            break;
+        }
+
+        if (i + 1 == stamps->used) {
+            /* The oldest entry starts at 0 unless older entries were overwritten */
+            if (stamps->used == SERIAL_IO_STAMP_COUNT) {
+                return false;
+            }
+            *ts = stamps->ts[slot];
+            return true;
+        }
+
+        /* This call moved the byte if the one before it ended at or before it */
+        uint32_t prev = (slot + SERIAL_IO_STAMP_COUNT - 1) % SERIAL_IO_STAMP_COUNT;
+        if (index >= stamps->end[prev]) {
+            *ts = stamps->ts[slot];
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -36,6 +36,7 @@ extern "C" {
 
 #include <stdbool.h>
 #include "../buffer/ring_buf.h"
+#include "../buffer/chunk_pool.h"
 
 /*****************************************************************************
  * Definitions
@@ -73,7 +74,15 @@ void serial_close();
 void serial_task();
 
 /**
- * @brief Returns if the RX buffer is empty
+ * @brief File descriptor of the open port, for event loops. -1 if no port is
+ * open (or on Windows).
+ * 
+ * @return int 
+ */
+int serial_get_fd();
+
+/**
+ * @brief Returns if no received chunk is waiting
  * 
  * @return true 
  * @return false 
@@ -81,7 +90,7 @@ void serial_task();
 bool serial_rx_buf_is_empty();
 
 /**
- * @brief Returns if the RX buffer is full
+ * @brief Returns if serial_task() can't read any more until chunks are popped or released
  * 
  * @return true 
  * @return false 
@@ -89,19 +98,39 @@ bool serial_rx_buf_is_empty();
 bool serial_rx_buf_is_full();
 
 /**
- * @brief Clear the RX buffer
+ * @brief Drop the received chunks still waiting
  * 
  */
 void serial_rx_buf_clear();
 
 /**
- * @brief Get a data byte off of the buffer. Returns T if successful.
+ * @brief Get the oldest received chunk, in the order the bytes arrived.
  * 
- * @param data pointer to variable data will be stored at.
- * @return true 
+ * read() fills the chunk directly, the bytes are not copied again. The
+ * caller owns one reference and must chunk_release() it; consumers that
+ * keep the data take their own reference with chunk_ref().
+ * 
+ * @return chunk_t* the chunk, NULL if nothing was received
+ */
+chunk_t *serial_rx_chunk_pop();
+
+/**
+ * @brief Number of bytes popped off the RX buffer since the port was opened.
+ * The last byte popped has stream index serial_rx_pop_count() - 1.
+ * 
+ * @return uint64_t 
+ */
+uint64_t serial_rx_pop_count();
+
+/**
+ * @brief Get the time of the read() call that received an RX byte.
+ * 
+ * @param index stream index of the byte
+ * @param ts_ns CLOCK_MONOTONIC time in ns
+ * @return true if the byte is recent enough to still have a timestamp
  * @return false 
  */
-bool serial_rx_buf_pop(uint8_t *data);
+bool serial_rx_stamp(uint64_t index, uint64_t *ts_ns);
 
 /**
  * @brief Returns if the TX buffer is empty
@@ -134,6 +163,40 @@ void serial_tx_buf_clear();
  */
 bool serial_tx_buf_push(const uint8_t *data);
 
+/**
+ * @brief Returns how many bytes can currently be loaded into the TX buffer
+ * 
+ * @return size_t 
+ */
+size_t serial_tx_buf_space();
+
+/**
+ * @brief Load as many of the given bytes into the TX buffer as will fit.
+ * 
+ * @param data bytes to send
+ * @param len number of bytes at data
+ * @return size_t number of bytes accepted
+ */
+size_t serial_tx_write(const uint8_t *data, size_t len);
+
+/**
+ * @brief Number of bytes loaded into the TX buffer since the port was opened.
+ * The last byte loaded has stream index serial_tx_push_count() - 1.
+ * 
+ * @return uint64_t 
+ */
+uint64_t serial_tx_push_count();
+
+/**
+ * @brief Get the time of the write() call that sent a TX byte.
+ * 
+ * @param index stream index of the byte
+ * @param ts_ns CLOCK_MONOTONIC time in ns
+ * @return true if the byte has been written and is recent enough to still have a timestamp
+ * @return false 
+ */
+bool serial_tx_stamp(uint64_t index, uint64_t *ts_ns);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,441 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        tx_engine.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+
+#include "../time_funcs/time_funcs.h"
+#include "../log/log.h"
+#include "serial.h"
+#include "tx_engine.h"
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Bounds for the token bucket refill tick */
+#define TX_ENGINE_MIN_TICK_NS   (100ULL * NSEC_PER_USEC)
+#define TX_ENGINE_MAX_TICK_NS   (100ULL * 1000ULL * NSEC_PER_USEC)
+
+/* Token bucket depth, in refill ticks */
+#define TX_ENGINE_BUCKET_TICKS  4ULL
+
+/* Retry interval when a frame is due but the TX buffer has no room for it */
+#define TX_ENGINE_RETRY_NS      (1000ULL * NSEC_PER_USEC)
+
+/*****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+static int timer_fd = -1;
+
+static bool active = false;
+static tx_pacing_t pacing;
+
+/* Source data. Either a private copy (owned_buf) or a read-only file mapping. */
+static const uint8_t *src_data = NULL;
+static size_t src_len = 0;
+static size_t src_pos = 0;
+static uint8_t *owned_buf = NULL;
+static void *map_addr = NULL;
+static size_t map_len = 0;
+
+static uint64_t repeats_done = 0;
+
+/* Token bucket, in units of 1e-9 bytes so the refill is exact for any rate */
+static uint64_t credit = 0;
+static uint64_t credit_max = 0;
+static uint64_t last_refill_ns = 0;
+
+static uint64_t next_frame_ns = 0;
+
+static uint64_t start_ns = 0;
+static uint64_t end_ns = 0;
+static uint64_t bytes_sent = 0;
+/* Fixed at start, the source length is gone once the source is released */
+static uint64_t bytes_total = 0;
+
+/*****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+static bool start(const tx_pacing_t *p);
+static void finish(void);
+static void release_source(void);
+static size_t emit(size_t len);
+static void arm_timer(uint64_t value_ns, uint64_t interval_ns, bool absolute);
+static bool timer_expired(void);
+
+/*****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+bool tx_engine_init(void)
+{
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd < 0) {
+        log_error("tx_engine: timerfd_create failed: %s\n", strerror(errno));
+        return false;
+    }
+
+    active = false;
+    return true;
+}
+
+void tx_engine_deinit(void)
+{
+    tx_engine_stop();
+
+    if (timer_fd >= 0) {
+        close(timer_fd);
+        timer_fd = -1;
+    }
+}
+
+bool tx_engine_send_file(const char *path, const tx_pacing_t *p)
+{
+    struct stat st;
+
+    if (NULL == path)
+        return false;
+
+    if (active) {
+        log_error("tx_engine: a transmission is already in progress\n");
+        return false;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        log_error("tx_engine: can't open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    if ((fstat(fd, &st) != 0) || (st.st_size <= 0)) {
+        log_error("tx_engine: %s is empty or not a regular file\n", path);
+        close(fd);
+        return false;
+    }
+
+    /* Map the file instead of reading it. Pages are faulted in as the data is
+     * sent and the kernel is told to read ahead and drop them behind us. */
+    map_len = (size_t)st.st_size;
+    map_addr = mmap(NULL, map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (MAP_FAILED == map_addr) {
+        log_error("tx_engine: mmap of %s failed: %s\n", path, strerror(errno));
+        map_addr = NULL;
+        map_len = 0;
+        return false;
+    }
+
+    madvise(map_addr, map_len, MADV_SEQUENTIAL);
+
+    src_data = map_addr;
+    src_len = map_len;
+
+    return start(p);
+}
+
+bool tx_engine_send_buffer(const uint8_t *data, size_t len, const tx_pacing_t *p)
+{
+    if ((NULL == data) || (0 == len))
+        return false;
+
+    if (active) {
+        log_error("tx_engine: a transmission is already in progress\n");
+        return false;
+    }
+
+    owned_buf = malloc(len);
+    if (NULL == owned_buf) {
+        log_error("tx_engine: out of memory\n");
+        return false;
+    }
+
+    memcpy(owned_buf, data, len);
+    src_data = owned_buf;
+    src_len = len;
+
+    return start(p);
+}
+
+void tx_engine_stop(void)
+{
+    if (!active)
+        return;
+
+    finish();
+}
+
+bool tx_engine_is_busy(void)
+{
+    return active;
+}
+
+void tx_engine_get_status(tx_status_t *status)
+{
+    if (NULL == status)
+        return;
+
+    status->active = active;
+    status->total = bytes_total;
+    status->sent = bytes_sent;
+    status->frames = (pacing.frame_size > 0) ? (bytes_sent / pacing.frame_size) : 0;
+    status->elapsed_us = ((active ? get_nanos() : end_ns) - start_ns) / NSEC_PER_USEC;
+}
+
+int tx_engine_get_fd(void)
+{
+    return timer_fd;
+}
+
+void tx_engine_task(void)
+{
+    uint64_t now;
+    size_t space;
+
+    if (!active)
+        return;
+
+    /* Maximum rate: keep the TX buffer topped up on every call */
+    if ((0 == pacing.rate) && (0 == pacing.frame_gap_us)) {
+        space = serial_tx_buf_space();
+        if (pacing.frame_size > 0) {
+            space -= space % pacing.frame_size;
+        }
+        emit(space);
+        return;
+    }
+
+    /* Paced: nothing to do until the timer fires */
+    if (!timer_expired())
+        return;
+
+    now = get_nanos();
+
+    if (pacing.frame_gap_us > 0) {
+        /* Fixed inter-frame gap, measured start to start */
+        size_t frame = (pacing.frame_size > 0) ? pacing.frame_size : 1;
+
+        if (now < next_frame_ns) {
+            return;
+        }
+
+        if (serial_tx_buf_space() < frame) {
+            arm_timer(now + TX_ENGINE_RETRY_NS, 0, true);
+            return;
+        }
+
+        emit(frame);
+
+        /* Keep the schedule, but don't try to catch up with a burst after a stall */
+        next_frame_ns += pacing.frame_gap_us * NSEC_PER_USEC;
+        if (next_frame_ns < now) {
+            next_frame_ns = now + pacing.frame_gap_us * NSEC_PER_USEC;
+        }
+
+        if (active) {
+            arm_timer(next_frame_ns, 0, true);
+        }
+        return;
+    }
+
+    /* Token bucket: refill for the elapsed time, then spend what the TX buffer will take */
+    uint64_t elapsed = now - last_refill_ns;
+    if (elapsed > NSEC_PER_SEC) {
+        elapsed = NSEC_PER_SEC;
+    }
+    credit += elapsed * pacing.rate;
+    if (credit > credit_max) {
+        credit = credit_max;
+    }
+    last_refill_ns = now;
+
+    size_t allowed = (size_t)(credit / NSEC_PER_SEC);
+    space = serial_tx_buf_space();
+    if (allowed > space) {
+        allowed = space;
+    }
+    if (pacing.frame_size > 0) {
+        allowed -= allowed % pacing.frame_size;
+    }
+
+    credit -= (uint64_t)emit(allowed) * NSEC_PER_SEC;
+}
+
+static bool start(const tx_pacing_t *p)
+{
+    if (NULL != p) {
+        pacing = *p;
+    }
+    else {
+        memset(&pacing, 0, sizeof(pacing));
+        pacing.repeat = 1;
+    }
+
+    if (pacing.frame_size > TX_ENGINE_MAX_FRAME_SIZE) {
+        log_error("tx_engine: frame size %u is larger than %u\n", (unsigned)pacing.frame_size, TX_ENGINE_MAX_FRAME_SIZE);
+        release_source();
+        return false;
+    }
+
+    src_pos = 0;
+    repeats_done = 0;
+    bytes_sent = 0;
+    bytes_total = (pacing.repeat == 0) ? 0 : (uint64_t)src_len * pacing.repeat;
+    start_ns = get_nanos();
+    active = true;
+
+    if (pacing.frame_gap_us > 0) {
+        /* First frame goes out right away */
+        next_frame_ns = start_ns;
+        arm_timer(start_ns, 0, true);
+    }
+    else if (pacing.rate > 0) {
+        /* Tick once per frame (or byte) at the configured rate, within sane bounds */
+        uint64_t unit = (pacing.frame_size > 0) ? pacing.frame_size : 1;
+        uint64_t tick_ns = (unit * NSEC_PER_SEC) / pacing.rate;
+        if (tick_ns < TX_ENGINE_MIN_TICK_NS) tick_ns = TX_ENGINE_MIN_TICK_NS;
+        if (tick_ns > TX_ENGINE_MAX_TICK_NS) tick_ns = TX_ENGINE_MAX_TICK_NS;
+
+        /* The bucket holds a few ticks' worth (at least one frame) so late or
+         * merged timer expirations don't lose throughput */
+        credit_max = TX_ENGINE_BUCKET_TICKS * tick_ns * pacing.rate;
+        if (credit_max < unit * NSEC_PER_SEC) {
+            credit_max = unit * NSEC_PER_SEC;
+        }
+        credit = unit * NSEC_PER_SEC;
+        last_refill_ns = start_ns;
+
+        arm_timer(tick_ns, tick_ns, false);
+    }
+
+    return true;
+}
+
+static void finish(void)
+{
+    end_ns = get_nanos();
+    active = false;
+    arm_timer(0, 0, false);
+    release_source();
+}
+
+static void release_source(void)
+{
+    if (NULL != map_addr) {
+        munmap(map_addr, map_len);
+        map_addr = NULL;
+        map_len = 0;
+    }
+
+    free(owned_buf);
+    owned_buf = NULL;
+
+    src_data = NULL;
+    src_len = 0;
+}
+
+/**
+ * @brief Push up to len bytes from the source into the TX buffer, wrapping and
+ *        counting repeats. Ends the transmission once the last repeat is sent.
+ */
+static size_t emit(size_t len)
+{
+    size_t total = 0;
+
+    while (active && (total < len)) {
+        size_t chunk = src_len - src_pos;
+        if (chunk > (len - total)) {
+            chunk = len - total;
+        }
+
+        size_t accepted = serial_tx_write(&src_data[src_pos], chunk);
+        src_pos += accepted;
+        total += accepted;
+
+        if (src_pos >= src_len) {
+            src_pos = 0;
+            repeats_done++;
+            if ((pacing.repeat != 0) && (repeats_done >= pacing.repeat)) {
+                bytes_sent += total;
+                total = 0;
+                finish();
+                break;
+            }
+        }
+
+        if (accepted < chunk) {
+            break;
+        }
+    }
+
+    bytes_sent += total;
+
+    return total;
+}
+
+static void arm_timer(uint64_t value_ns, uint64_t interval_ns, bool absolute)
+{
+    struct itimerspec its;
+
+    if (timer_fd < 0)
+        return;
+
+    its.it_value.tv_sec = (time_t)(value_ns / NSEC_PER_SEC);
+    its.it_value.tv_nsec = (long)(value_ns % NSEC_PER_SEC);
+    its.it_interval.tv_sec = (time_t)(interval_ns / NSEC_PER_SEC);
+    its.it_interval.tv_nsec = (long)(interval_ns % NSEC_PER_SEC);
+
+    /* An absolute time of 0 would disarm the timer, so make "now" at least 1ns */
+    if (absolute && (0 == value_ns)) {
+        its.it_value.tv_nsec = 1;
+    }
+
+    timerfd_settime(timer_fd, absolute ? TFD_TIMER_ABSTIME : 0, &its, NULL);
+}
+
+static bool timer_expired(void)
+{
+    uint64_t expirations;
+
+    if (timer_fd < 0)
+        return true;
+
+    return (read(timer_fd, &expirations, sizeof(expirations)) == (ssize_t)sizeof(expirations));
+}
@@ -0,0 +1,146 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        tx_engine.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#ifndef TX_ENGINE_H_
+#define TX_ENGINE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* A frame must fit in the serial TX buffer in one go */
+#define TX_ENGINE_MAX_FRAME_SIZE    4096U
+
+/*****************************************************************************
+ * Structs, Unions, Enums, & Typedefs
+ *****************************************************************************/
+
+/**
+ * @brief How the data is paced into the serial TX buffer.
+ *
+ * All zero means maximum rate: the TX buffer is kept full. Passing NULL
+ * instead of a pacing struct sends the source once at the maximum rate.
+ */
+typedef struct tx_pacing_t {
+    uint64_t rate;          /**< Bytes per second (token bucket), 0 = unlimited */
+    uint32_t frame_size;    /**< Bytes per frame, 0 = plain byte stream */
+    uint64_t frame_gap_us;  /**< Time from the start of one frame to the next, 0 = back to back */
+    uint64_t repeat;        /**< Number of times the source is sent, 0 = until stopped */
+} tx_pacing_t;
+
+/**
+ * @brief Snapshot of the current (or last) transmission.
+ */
+typedef struct tx_status_t {
+    bool active;            /**< A transmission is in progress */
+    uint64_t total;         /**< Total bytes to send, 0 if repeating forever */
+    uint64_t sent;          /**< Bytes handed to the serial TX buffer so far */
+    uint64_t frames;        /**< Frames sent (frame mode only) */
+    uint64_t elapsed_us;    /**< Time since the transmission started */
+} tx_status_t;
+
+/*****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Initialize the TX engine and its pacing timer.
+ *
+ * @return true if successful
+ */
+bool tx_engine_init(void);
+
+/**
+ * @brief Stop any transmission and release the pacing timer.
+ */
+void tx_engine_deinit(void);
+
+/**
+ * @brief Send a file. The file is memory mapped and streamed, never read into memory as a whole.
+ *
+ * @param path path to the file
+ * @param pacing pacing options, NULL for maximum rate
+ * @return true if the transmission was started
+ */
+bool tx_engine_send_file(const char *path, const tx_pacing_t *pacing);
+
+/**
+ * @brief Send a copy of the given bytes (hex string, repeated pattern, ...).
+ *
+ * @param data bytes to send
+ * @param len number of bytes
+ * @param pacing pacing options, NULL for maximum rate
+ * @return true if the transmission was started
+ */
+bool tx_engine_send_buffer(const uint8_t *data, size_t len, const tx_pacing_t *pacing);
+
+/**
+ * @brief Abort the current transmission. Bytes already in the TX buffer are still sent.
+ */
+void tx_engine_stop(void);
+
+/**
+ * @brief Returns true while a transmission is in progress.
+ */
+bool tx_engine_is_busy(void);
+
+/**
+ * @brief Get the progress of the current (or last) transmission.
+ *
+ * @param status filled in with the current state
+ */
+void tx_engine_get_status(tx_status_t *status);
+
+/**
+ * @brief Move data into the serial TX buffer as the pacing allows. Call this periodically.
+ *
+ * Paced transmissions only do work when the pacing timer has expired, so
+ * calling this more often than needed is cheap.
+ */
+void tx_engine_task(void);
+
+/**
+ * @brief File descriptor of the pacing timer (timerfd), -1 if unavailable.
+ *
+ * Becomes readable whenever the engine has work to do for a paced transmission.
+ */
+int tx_engine_get_fd(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* TX_ENGINE_H_ */
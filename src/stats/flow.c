@@ -0,0 +1,164 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        flow.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+#include "flow.h"
+#include <string.h>
+
+#include "../time_funcs/time_funcs.h"
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Close every window that ended before now_ns, recovering if they were calm.
+ */
+static bool roll_windows(flow_t *flow, uint64_t now_ns);
+
+/**
+ * @brief Switch to summary mode if the current window is over budget or backlogged.
+ */
+static bool check_overload(flow_t *flow);
+
+/**
+ * @brief Whether a window with this rate and backlog counts towards recovering.
+ */
+static bool is_calm(const flow_t *flow, uint64_t rate, bool backlog);
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+void flow_init(flow_t *flow, const char *name, uint64_t max_rate, uint64_t now_ns)
+{
+    memset(flow, 0, sizeof(*flow));
+    flow->name = name;
+    flow->max_rate = max_rate;
+    flow->window_start_ns = now_ns;
+    flow->mode = FLOW_MODE_FULL;
+}
+
+bool flow_offer(flow_t *flow, size_t len, uint64_t now_ns)
+{
+    bool changed = roll_windows(flow, now_ns);
+
+    flow->window_bytes += len;
+
+    return check_overload(flow) || changed;
+}
+
+bool flow_tick(flow_t *flow, uint64_t now_ns)
+{
+    return roll_windows(flow, now_ns);
+}
+
+bool flow_report_backlog(flow_t *flow, uint64_t now_ns)
+{
+    bool changed = roll_windows(flow, now_ns);
+
+    flow->backlog = true;
+
+    return check_overload(flow) || changed;
+}
+
+void flow_skip(flow_t *flow, size_t len)
+{
+    flow->skipped += len;
+    flow->skipped_total += len;
+}
+
+uint64_t flow_take_skipped(flow_t *flow)
+{
+    uint64_t skipped = flow->skipped;
+    flow->skipped = 0;
+    return skipped;
+}
+
+flow_mode_t flow_get_mode(const flow_t *flow)
+{
+    return flow->mode;
+}
+
+static bool roll_windows(flow_t *flow, uint64_t now_ns)
+{
+    if (now_ns - flow->window_start_ns < FLOW_WINDOW_NS) {
+        return false;
+    }
+
+    uint64_t windows = (now_ns - flow->window_start_ns) / FLOW_WINDOW_NS;
+
+    /* The window that just ended, then any idle ones after it (no bytes, no backlog) */
+    flow->last_rate = (flow->window_bytes * NSEC_PER_SEC) / FLOW_WINDOW_NS;
+    flow->calm_windows = is_calm(flow, flow->last_rate, flow->backlog) ? (flow->calm_windows + 1U) : 0;
+    if (windows > 1) {
+        flow->last_rate = 0;
+        flow->calm_windows = (windows - 1 >= FLOW_RECOVER_WINDOWS)
+                           ? FLOW_RECOVER_WINDOWS : (flow->calm_windows + (uint32_t)(windows - 1));
+    }
+
+    flow->window_start_ns += windows * FLOW_WINDOW_NS;
+    flow->window_bytes = 0;
+    flow->backlog = false;
+
+    if ((FLOW_MODE_SUMMARY == flow->mode) && (flow->calm_windows >= FLOW_RECOVER_WINDOWS)) {
+        flow->mode = FLOW_MODE_FULL;
+        return true;
+    }
+
+    return false;
+}
+
+static bool check_overload(flow_t *flow)
+{
+    /* Bytes the sink can take in one window */
+    const uint64_t budget = (flow->max_rate * FLOW_WINDOW_NS) / NSEC_PER_SEC;
+
+    if ((flow->window_bytes <= budget) && !flow->backlog) {
+        return false;
+    }
+
+    flow->calm_windows = 0;
+    if (FLOW_MODE_SUMMARY == flow->mode) {
+        return false;
+    }
+
+    flow->mode = FLOW_MODE_SUMMARY;
+    flow->degraded_count++;
+    return true;
+}
+
+static bool is_calm(const flow_t *flow, uint64_t rate, bool backlog)
+{
+    return !backlog && ((rate * 100U) <= (flow->max_rate * FLOW_RECOVER_PCT));
+}
@@ -0,0 +1,164 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        flow.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#ifndef FLOW_H_
+#define FLOW_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Length of one rate measurement window */
+#define FLOW_WINDOW_NS          (100ULL * 1000ULL * 1000ULL)
+
+/* A summarising sink goes back to full output once the offered rate has
+ * stayed under this share of its maximum, without backlog, for
+ * FLOW_RECOVER_WINDOWS windows in a row. The gap stops it flapping. */
+#define FLOW_RECOVER_PCT        70U
+#define FLOW_RECOVER_WINDOWS    10U
+
+/*****************************************************************************
+ * Structs, Unions, Enums, & Typedefs
+ *****************************************************************************/
+
+/**
+ * @brief How a sink is fed.
+ */
+typedef enum flow_mode_t {
+    FLOW_MODE_FULL,         /**< Every byte */
+    FLOW_MODE_SUMMARY,      /**< A summary (decimated data, counts, skipped markers) */
+} flow_mode_t;
+
+/**
+ * @brief Flow control state of one sink.
+ *
+ * The sink declares the rate it can sustain. The bytes offered to it are
+ * counted per window; as soon as a window holds more than the sink can take,
+ * or the sink reports a backlog, it switches to summary mode. Only the sink's
+ * output degrades, the caller still sees every byte.
+ */
+typedef struct flow_t {
+    const char *name;           /**< Sink name, for messages */
+    uint64_t max_rate;          /**< Bytes per second the sink can sustain */
+    uint64_t window_start_ns;   /**< Start of the current window */
+    uint64_t window_bytes;      /**< Bytes offered in the current window */
+    uint64_t last_rate;         /**< Offered rate over the last complete window, bytes per second */
+    bool backlog;               /**< The sink reported falling behind in the current window */
+    uint32_t calm_windows;      /**< Consecutive windows that allow recovering */
+    flow_mode_t mode;           /**< Current mode */
+    uint64_t skipped;           /**< Bytes summarised since the last flow_take_skipped() */
+    uint64_t skipped_total;     /**< Bytes summarised since flow_init() */
+    uint64_t degraded_count;    /**< Switches to summary mode */
+} flow_t;
+
+/*****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Initialize a sink in full mode.
+ *
+ * @param flow the flow state
+ * @param name sink name, must stay valid
+ * @param max_rate bytes per second the sink can sustain
+ * @param now_ns current get_nanos() time
+ */
+void flow_init(flow_t *flow, const char *name, uint64_t max_rate, uint64_t now_ns);
+
+/**
+ * @brief Account for bytes about to be given to the sink.
+ *
+ * Switches to summary mode at once if the current window is over the
+ * sink's budget. Call flow_get_mode() afterwards to know how to feed it.
+ *
+ * @param flow the flow state
+ * @param len number of bytes
+ * @param now_ns current get_nanos() time
+ * @return true if the mode changed
+ */
+bool flow_offer(flow_t *flow, size_t len, uint64_t now_ns);
+
+/**
+ * @brief Close the windows that have ended and decide whether the sink has recovered.
+ *
+ * Call periodically, so a sink recovers even when no more data arrives.
+ *
+ * @param flow the flow state
+ * @param now_ns current get_nanos() time
+ * @return true if the mode changed
+ */
+bool flow_tick(flow_t *flow, uint64_t now_ns);
+
+/**
+ * @brief The sink tells it is behind (its queue is full, it dropped data, ...).
+ *
+ * Counts against the current window like too many bytes do.
+ *
+ * @param flow the flow state
+ * @param now_ns current get_nanos() time
+ * @return true if the mode changed
+ */
+bool flow_report_backlog(flow_t *flow, uint64_t now_ns);
+
+/**
+ * @brief Record bytes that were summarised rather than given to the sink.
+ *
+ * @param flow the flow state
+ * @param len number of bytes
+ */
+void flow_skip(flow_t *flow, size_t len);
+
+/**
+ * @brief Return the bytes summarised since the last call, for a "N bytes skipped" marker.
+ *
+ * @param flow the flow state
+ * @return uint64_t bytes skipped
+ */
+uint64_t flow_take_skipped(flow_t *flow);
+
+/**
+ * @brief Current mode of the sink.
+ *
+ * @param flow the flow state
+ * @return flow_mode_t FLOW_MODE_FULL or FLOW_MODE_SUMMARY
+ */
+flow_mode_t flow_get_mode(const flow_t *flow);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* FLOW_H_ */
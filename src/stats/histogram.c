@@ -0,0 +1,173 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        histogram.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#include "histogram.h"
+#include <string.h>
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+void histogram_init(histogram_t *hist)
+{
+    if (hist == NULL) {
+        return;
+    }
+
+    memset(hist, 0, sizeof(histogram_t));
+    hist->min = UINT64_MAX;
+}
+
+uint32_t histogram_bucket_index(uint64_t value)
+{
+    // Values below the first power of two boundary map 1:1
+    if (value < HISTOGRAM_SUB_BUCKET_COUNT) {
+        return (uint32_t)value;
+    }
+
+    // Shift the value down so it lands in the upper half of the sub-buckets
+    uint32_t msb = 63U - (uint32_t)__builtin_clzll(value);
+    uint32_t shift = msb - HISTOGRAM_SUB_BUCKET_BITS + 1U;
+    uint32_t sub = (uint32_t)(value >> shift);
+
+    return (shift * HISTOGRAM_SUB_BUCKET_HALF) + sub;
+}
+
+uint64_t histogram_bucket_high(uint32_t index)
+{
+    if (index < HISTOGRAM_SUB_BUCKET_COUNT) {
+        return index;
+    }
+
+    uint32_t shift = (index / HISTOGRAM_SUB_BUCKET_HALF) - 1U;
+    uint64_t sub = index - (shift * HISTOGRAM_SUB_BUCKET_HALF);
+
+    // The last bucket's upper bound is UINT64_MAX, which this wraps around to
+    return ((sub + 1U) << shift) - 1U;
+}
+
+void histogram_record(histogram_t *hist, uint64_t value)
+{
+    if (hist == NULL) {
+        return;
+    }
+
+    hist->counts[histogram_bucket_index(value)]++;
+    hist->total++;
+    hist->sum += value;
+
+    if (value < hist->min) {
+        hist->min = value;
+    }
+    if (value > hist->max) {
+        hist->max = value;
+    }
+}
+
+void histogram_merge(histogram_t *dst, const histogram_t *src)
+{
+    if (dst == NULL || src == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < HISTOGRAM_BUCKET_COUNT; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+
+    dst->total += src->total;
+    dst->sum += src->sum;
+
+    if (src->min < dst->min) {
+        dst->min = src->min;
+    }
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+}
+
+uint64_t histogram_percentile(const histogram_t *hist, double percentile)
+{
+    if (hist == NULL || hist->total == 0) {
+        return 0;
+    }
+
+    if (percentile < 0.0) {
+        percentile = 0.0;
+    }
+    if (percentile > 100.0) {
+        percentile = 100.0;
+    }
+
+    // Rank of the value we want, counting from 1
+    uint64_t rank = (uint64_t)((percentile / 100.0) * (double)hist->total + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    if (rank > hist->total) {
+        rank = hist->total;
+    }
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < HISTOGRAM_BUCKET_COUNT; i++) {
+        seen += hist->counts[i];
+        if (seen >= rank) {
+            uint64_t value = histogram_bucket_high(i);
+            if (value > hist->max) {
+                value = hist->max;
+            }
+            if (value < hist->min) {
+                value = hist->min;
+            }
+            return value;
+        }
+    }
+
+    return hist->max;
+}
+
+uint64_t histogram_mean(const histogram_t *hist)
+{
+    if (hist == NULL || hist->total == 0) {
+        return 0;
+    }
+
+    return hist->sum / hist->total;
+}
@@ -0,0 +1,133 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        histogram.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/*
+ * Log-bucketed (HDR style) layout: every power of two range is split into
+ * HISTOGRAM_SUB_BUCKET_HALF linear sub-buckets, so any recorded value is
+ * reported within 1/HISTOGRAM_SUB_BUCKET_HALF (about 6%) of its true value,
+ * over the whole uint64_t range, in a fixed amount of memory.
+ */
+#define HISTOGRAM_SUB_BUCKET_BITS   5U
+#define HISTOGRAM_SUB_BUCKET_COUNT  (1U << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_SUB_BUCKET_HALF   (HISTOGRAM_SUB_BUCKET_COUNT / 2U)
+#define HISTOGRAM_BUCKET_COUNT      ((64U - HISTOGRAM_SUB_BUCKET_BITS + 1U) * HISTOGRAM_SUB_BUCKET_HALF + HISTOGRAM_SUB_BUCKET_HALF)
+
+/*****************************************************************************
+ * Structs, Unions, Enums, & Typedefs
+ *****************************************************************************/
+
+typedef struct histogram_t {
+    uint64_t counts[HISTOGRAM_BUCKET_COUNT];    /**< Number of values recorded per bucket */
+    uint64_t total;                             /**< Number of values recorded */
+    uint64_t sum;                               /**< Sum of the values recorded (for the mean) */
+    uint64_t min;                               /**< Smallest value recorded */
+    uint64_t max;                               /**< Largest value recorded */
+} histogram_t;
+
+/*****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Initializes (empties) a histogram.
+ *
+ * @param hist Pointer to the histogram.
+ */
+void histogram_init(histogram_t *hist);
+
+/**
+ * @brief Records one value. O(1): one bit scan and one increment.
+ *
+ * @param hist Pointer to the histogram.
+ * @param value The value to record.
+ */
+void histogram_record(histogram_t *hist, uint64_t value);
+
+/**
+ * @brief Adds all values of src into dst.
+ *
+ * @param dst Histogram to add to.
+ * @param src Histogram to add from.
+ */
+void histogram_merge(histogram_t *dst, const histogram_t *src);
+
+/**
+ * @brief Gets the value at a percentile.
+ *
+ * The result is the highest value that falls in the same bucket as the
+ * percentile, clamped to the recorded min/max.
+ *
+ * @param hist Pointer to the histogram.
+ * @param percentile 0.0 - 100.0
+ * @return uint64_t The value, 0 if the histogram is empty.
+ */
+uint64_t histogram_percentile(const histogram_t *hist, double percentile);
+
+/**
+ * @brief Gets the mean of the recorded values.
+ *
+ * @param hist Pointer to the histogram.
+ * @return uint64_t The mean, 0 if the histogram is empty.
+ */
+uint64_t histogram_mean(const histogram_t *hist);
+
+/**
+ * @brief Gets the bucket a value is counted in.
+ *
+ * @param value The value.
+ * @return uint32_t Index into counts[].
+ */
+uint32_t histogram_bucket_index(uint64_t value);
+
+/**
+ * @brief Gets the largest value that is counted in a bucket.
+ *
+ * @param index Index into counts[].
+ * @return uint64_t The upper bound (inclusive) of the bucket.
+ */
+uint64_t histogram_bucket_high(uint32_t index);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* HISTOGRAM_H_ */
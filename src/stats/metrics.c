@@ -0,0 +1,247 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        metrics.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/**
+ * @brief Output position while formatting. Counts the full length even
+ *        once the buffer is full, like snprintf.
+ */
+typedef struct out_t {
+    char *buf;
+    size_t len;
+    size_t used;
+} out_t;
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+/* Histogram bucket bounds in seconds, the frame times of 60 and 30 fps included */
+static const double bucket_bounds[] = {
+    0.00001, 0.0001, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.0167, 0.0333, 0.05, 0.1, 0.25, 1.0,
+};
+
+static metric_t metrics[METRICS_MAX];
+static uint32_t metric_count = 0;
+
+static const char *const type_names[METRIC_TYPE_MAX] = {"counter", "gauge", "histogram"};
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+static metric_t *add_metric(const char *name, const char *help, metric_type_t type);
+static void out_printf(out_t *out, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void format_histogram(out_t *out, const metric_t *metric);
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+metric_t *metrics_counter(const char *name, const char *help)
+{
+    return add_metric(name, help, METRIC_COUNTER);
+}
+
+metric_t *metrics_gauge(const char *name, const char *help)
+{
+    return add_metric(name, help, METRIC_GAUGE);
+}
+
+metric_t *metrics_histogram(const char *name, const char *help)
+{
+    metric_t *metric = add_metric(name, help, METRIC_HISTOGRAM);
+
+    if ((NULL != metric) && (NULL == metric->hist)) {
+        metric->hist = malloc(sizeof(histogram_t));
+        if (NULL == metric->hist) {
+            /* Only a fresh entry lacks a histogram, and it is the last one */
+            metric_count--;
+            return NULL;
+        }
+        histogram_init(metric->hist);
+    }
+    return metric;
+}
+
+metric_t *metrics_register_fn(const char *name, const char *help, metric_type_t type, metric_read_t read)
+{
+    if ((METRIC_COUNTER != type) && (METRIC_GAUGE != type)) {
+        return NULL;
+    }
+
+    metric_t *metric = add_metric(name, help, type);
+    if (NULL != metric) {
+        metric->read = read;
+    }
+    return metric;
+}
+
+void metrics_add(metric_t *metric, uint64_t n)
+{
+    if (NULL != metric) {
+        atomic_fetch_add_explicit(&metric->value, n, memory_order_relaxed);
+    }
+}
+
+void metrics_set(metric_t *metric, uint64_t value)
+{
+    if (NULL != metric) {
+        atomic_store_explicit(&metric->value, value, memory_order_relaxed);
+    }
+}
+
+void metrics_max(metric_t *metric, uint64_t value)
+{
+    if (NULL == metric) {
+        return;
+    }
+
+    uint64_t cur = atomic_load_explicit(&metric->value, memory_order_relaxed);
+    while ((value > cur) &&
+           !atomic_compare_exchange_weak_explicit(&metric->value, &cur, value,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void metrics_observe(metric_t *metric, uint64_t ns)
+{
+    if ((NULL != metric) && (NULL != metric->hist)) {
+        histogram_record(metric->hist, ns);
+    }
+}
+
+size_t metrics_format(char *buf, size_t len)
+{
+    out_t out = { .buf = buf, .len = len, .used = 0 };
+
+    if ((NULL != buf) && (len > 0)) {
+        buf[0] = '\0';
+    }
+
+    for (uint32_t i = 0; i < metric_count; i++) {
+        const metric_t *metric = &metrics[i];
+
+        out_printf(&out, "# HELP " METRICS_PREFIX "%s %s\n", metric->name, metric->help);
+        out_printf(&out, "# TYPE " METRICS_PREFIX "%s %s\n", metric->name, type_names[metric->type]);
+
+        if (METRIC_HISTOGRAM == metric->type) {
+            format_histogram(&out, metric);
+        }
+        else {
+            uint64_t value = (NULL != metric->read) ? metric->read()
+                                                    : atomic_load_explicit(&metric->value, memory_order_relaxed);
+            out_printf(&out, METRICS_PREFIX "%s %llu\n", metric->name, (unsigned long long)value);
+        }
+    }
+
+    return out.used;
+}
+
+void metrics_deinit(void)
+{
+    for (uint32_t i = 0; i < metric_count; i++) {
+        free(metrics[i].hist);
+    }
+    memset(metrics, 0, sizeof(metrics));
+    metric_count = 0;
+}
+
+static metric_t *add_metric(const char *name, const char *help, metric_type_t type)
+{
+    if ((NULL == name) || (NULL == help)) {
+        return NULL;
+    }
+
+    /* Modules register from their init functions, which may run again */
+    for (uint32_t i = 0; i < metric_count; i++) {
+        if (0 == strcmp(metrics[i].name, name)) {
+            return (type == metrics[i].type) ? &metrics[i] : NULL;
+        }
+    }
+
+    if (metric_count >= METRICS_MAX) {
+        return NULL;
+    }
+
+    metric_t *metric = &metrics[metric_count++];
+    metric->name = name;
+    metric->help = help;
+    metric->type = type;
+    atomic_init(&metric->value, 0);
+    metric->read = NULL;
+    metric->hist = NULL;
+    return metric;
+}
+
+static void out_printf(out_t *out, const char *fmt, ...)
+{
+    va_list args;
+    size_t space = (out->used < out->len) ? (out->len - out->used) : 0;
+
+    va_start(args, fmt);
+    int n = vsnprintf((space > 0) ? (out->buf + out->used) : NULL, space, fmt, args);
+    va_end(args);
+
+    if (n > 0) {
+        out->used += (size_t)n;
+    }
+}
+
+static void format_histogram(out_t *out, const metric_t *metric)
+{
+    const histogram_t *hist = metric->hist;
+    uint64_t cumulative = 0;
+    uint32_t index = 0;
+
+    /* Buckets are cumulative. A value shares its HDR bucket with values up
+     * to ~6% away, so a bound counts the whole bucket it falls in. */
+    for (uint32_t b = 0; b < sizeof(bucket_bounds) / sizeof(bucket_bounds[0]); b++) {
+        uint32_t last = histogram_bucket_index((uint64_t)(bucket_bounds[b] * 1e9));
+        for (; index <= last; index++) {
+            cumulative += hist->counts[index];
+        }
+        out_printf(out, METRICS_PREFIX "%s_bucket{le=\"%g\"} %llu\n",
+                   metric->name, bucket_bounds[b], (unsigned long long)cumulative);
+    }
+
+    out_printf(out, METRICS_PREFIX "%s_bucket{le=\"+Inf\"} %llu\n", metric->name, (unsigned long long)hist->total);
+    out_printf(out, METRICS_PREFIX "%s_sum %.9f\n", metric->name, (double)hist->sum / 1e9);
+    out_printf(out, METRICS_PREFIX "%s_count %llu\n", metric->name, (unsigned long long)hist->total);
+}
@@ -0,0 +1,159 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        metrics.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "histogram.h"
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Metrics that can be registered */
+#define METRICS_MAX             48U
+
+/* Prefix of every exported name */
+#define METRICS_PREFIX          "serial_tool_"
+
+/*****************************************************************************
+ * Structs, Unions, Enums, & Typedefs
+ *****************************************************************************/
+
+typedef enum metric_type_t {
+    METRIC_COUNTER,         /**< Only goes up */
+    METRIC_GAUGE,           /**< Current value or high-water mark */
+    METRIC_HISTOGRAM,       /**< Durations in ns, exported in seconds */
+    METRIC_TYPE_MAX
+} metric_type_t;
+
+/**
+ * @brief Reads a value that is already kept somewhere else, at export time.
+ */
+typedef uint64_t (*metric_read_t)(void);
+
+/**
+ * @brief A registered metric. Use the handle with the update functions.
+ */
+typedef struct metric_t {
+    const char *name;           /**< Name without METRICS_PREFIX, static */
+    const char *help;           /**< One line description, static */
+    metric_type_t type;
+    _Atomic uint64_t value;     /**< Counter or gauge value */
+    metric_read_t read;         /**< If set, called instead of using value */
+    histogram_t *hist;          /**< Histogram metrics only */
+} metric_t;
+
+/*****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Register a counter. Registering a name again returns the same metric.
+ *
+ * @param name name without METRICS_PREFIX, should end in _total
+ * @param help description
+ * @return the metric, NULL if the registry is full (updating NULL does nothing)
+ */
+metric_t *metrics_counter(const char *name, const char *help);
+
+/**
+ * @brief Register a gauge. Registering a name again returns the same metric.
+ */
+metric_t *metrics_gauge(const char *name, const char *help);
+
+/**
+ * @brief Register a duration histogram. Values are recorded in ns and
+ *        exported in seconds, so the name should end in _seconds.
+ */
+metric_t *metrics_histogram(const char *name, const char *help);
+
+/**
+ * @brief Register a counter or gauge whose value is read from a function at export time.
+ *
+ * @param name name without METRICS_PREFIX
+ * @param help description
+ * @param type METRIC_COUNTER or METRIC_GAUGE
+ * @param read returns the current value
+ */
+metric_t *metrics_register_fn(const char *name, const char *help, metric_type_t type, metric_read_t read);
+
+/**
+ * @brief Add to a counter. One relaxed atomic add, safe from any thread.
+ */
+void metrics_add(metric_t *metric, uint64_t n);
+
+/**
+ * @brief Set a gauge.
+ */
+void metrics_set(metric_t *metric, uint64_t value);
+
+/**
+ * @brief Raise a gauge to value if it is higher (high-water mark).
+ *        Only writes when the mark moves, so it is cheap to call per chunk.
+ */
+void metrics_max(metric_t *metric, uint64_t value);
+
+/**
+ * @brief Record a duration in a histogram. Histograms have a single writer:
+ *        only call this from the thread that owns the metric (the main
+ *        loop, or the GUI thread for gui_frame_seconds).
+ *
+ * @param metric histogram metric
+ * @param ns duration in nanoseconds
+ */
+void metrics_observe(metric_t *metric, uint64_t ns);
+
+/**
+ * @brief Write every metric in the Prometheus text exposition format (version 0.0.4).
+ *
+ * @param buf output buffer, may be NULL with len 0 to get the size
+ * @param len size of buf
+ * @return length of the whole text; when it is len or more the output was cut
+ */
+size_t metrics_format(char *buf, size_t len);
+
+/**
+ * @brief Forget every metric and free the histograms.
+ */
+void metrics_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* METRICS_H_ */
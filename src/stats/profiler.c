@@ -0,0 +1,179 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        profiler.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+#include "profiler.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "../time_funcs/time_funcs.h"
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/**
+ * @brief Accumulated runs of one stage in the current window, in cycles.
+ */
+typedef struct prof_acc_t {
+    histogram_t hist;
+    uint64_t busy;
+    uint64_t bytes;
+} prof_acc_t;
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+static const char *const stage_names[PROF_STAGE_MAX] = {
+    "serial io", "decode", "sinks", "lvgl", "flush", "cli",
+};
+
+static prof_acc_t acc[PROF_STAGE_MAX];
+static uint64_t window_start_ns;
+
+/* The GUI thread records the LVGL and flush stages, the main loop the rest
+ * and rolls the window. Held for a few adds, never across any I/O. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+static void reset_window(uint64_t now_ns);
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+void profiler_init(uint64_t now_ns)
+{
+    pthread_mutex_lock(&lock);
+    reset_window(now_ns);
+    pthread_mutex_unlock(&lock);
+}
+
+void profiler_record(prof_stage_t stage, uint64_t cycles, uint64_t bytes)
+{
+    if (stage >= PROF_STAGE_MAX) {
+        return;
+    }
+
+    prof_acc_t *a = &acc[stage];
+    pthread_mutex_lock(&lock);
+    histogram_record(&a->hist, cycles);
+    a->busy += cycles;
+    a->bytes += bytes;
+    pthread_mutex_unlock(&lock);
+}
+
+void profiler_roll(uint64_t now_ns, prof_report_t *report)
+{
+    pthread_mutex_lock(&lock);
+
+    uint64_t window_ns = (now_ns > window_start_ns) ? (now_ns - window_start_ns) : 1;
+
+    if (NULL != report) {
+        report->window_ns = window_ns;
+
+        /* Cycles are converted once per window, not per run */
+        for (uint32_t i = 0; i < PROF_STAGE_MAX; i++) {
+            const prof_acc_t *a = &acc[i];
+            prof_stage_report_t *r = &report->stages[i];
+
+            r->count = a->hist.total;
+            r->busy_ns = cycles_to_nanos(a->busy);
+            r->busy_pct = ((double)r->busy_ns * 100.0) / (double)window_ns;
+            r->max_ns = (a->hist.total > 0) ? cycles_to_nanos(a->hist.max) : 0;
+            r->p99_ns = cycles_to_nanos(histogram_percentile(&a->hist, 99.0));
+            r->bytes = a->bytes;
+            r->bytes_per_sec = ((double)a->bytes * (double)NSEC_PER_SEC) / (double)window_ns;
+        }
+    }
+
+    reset_window(now_ns);
+
+    pthread_mutex_unlock(&lock);
+}
+
+size_t profiler_format(const prof_report_t *report, char *buf, size_t len)
+{
+    size_t used = 0;
+    double total_pct = 0.0;
+    uint32_t top = 0;
+    int n;
+
+    if ((NULL == report) || (NULL == buf) || (0 == len)) {
+        return 0;
+    }
+
+    n = snprintf(buf, len, "%-9s %6s %8s %8s %9s\n", "stage", "busy", "max us", "p99 us", "KB/s");
+    used = (n > 0) ? (size_t)n : 0;
+
+    for (uint32_t i = 0; (i < PROF_STAGE_MAX) && (used < len); i++) {
+        const prof_stage_report_t *r = &report->stages[i];
+
+        n = snprintf(buf + used, len - used, "%-9s %5.1f%% %8llu %8llu %9.1f\n",
+                     stage_names[i], r->busy_pct,
+                     (unsigned long long)(r->max_ns / NSEC_PER_USEC),
+                     (unsigned long long)(r->p99_ns / NSEC_PER_USEC),
+                     r->bytes_per_sec / 1024.0);
+        used += (n > 0) ? (size_t)n : 0;
+
+        total_pct += r->busy_pct;
+        if (r->busy_pct > report->stages[top].busy_pct) {
+            top = i;
+        }
+    }
+
+    /* The one line to look at when throughput drops */
+    if (used < len) {
+        n = snprintf(buf + used, len - used, "busy %.1f%%, most in %s", total_pct,
+                     (report->stages[top].busy_ns > 0) ? stage_names[top] : "-");
+        used += (n > 0) ? (size_t)n : 0;
+    }
+
+    return (used < len) ? used : (len - 1);
+}
+
+const char *profiler_stage_name(prof_stage_t stage)
+{
+    return (stage < PROF_STAGE_MAX) ? stage_names[stage] : "?";
+}
+
+static void reset_window(uint64_t now_ns)
+{
+    for (uint32_t i = 0; i < PROF_STAGE_MAX; i++) {
+        histogram_init(&acc[i].hist);
+        acc[i].busy = 0;
+        acc[i].bytes = 0;
+    }
+    window_start_ns = now_ns;
+}
@@ -0,0 +1,133 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        profiler.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "histogram.h"
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Structs, Unions, Enums, & Typedefs
+ *****************************************************************************/
+
+/**
+ * @brief Main loop stages that are timed.
+ */
+typedef enum prof_stage_t {
+    PROF_STAGE_SERIAL_IO,   /**< read()/write() on the port */
+    PROF_STAGE_DECODE,      /**< Parsers looking at the RX bytes (ping, script expect) */
+    PROF_STAGE_SINKS,       /**< Consumers of the RX bytes (hex dump, text area, chart) */
+    PROF_STAGE_LVGL,        /**< lv_timer_handler, without the flush */
+    PROF_STAGE_FLUSH,       /**< Copying rendered areas to the display */
+    PROF_STAGE_CLI,         /**< Running CLI commands */
+    PROF_STAGE_MAX
+} prof_stage_t;
+
+/**
+ * @brief Results for one stage over one window.
+ */
+typedef struct prof_stage_report_t {
+    uint64_t count;         /**< Times the stage ran */
+    uint64_t busy_ns;       /**< Total time spent in the stage */
+    double busy_pct;        /**< busy_ns as a percentage of the window (time per second / 10ms) */
+    uint64_t max_ns;        /**< Longest single run */
+    uint64_t p99_ns;        /**< 99th percentile of a single run */
+    uint64_t bytes;         /**< Bytes processed */
+    double bytes_per_sec;   /**< bytes over the window */
+} prof_stage_report_t;
+
+/**
+ * @brief Results for all stages over one window.
+ */
+typedef struct prof_report_t {
+    uint64_t window_ns;                             /**< Length of the window */
+    prof_stage_report_t stages[PROF_STAGE_MAX];
+} prof_report_t;
+
+/*****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Start the first window.
+ *
+ * @param now_ns current time (get_nanos())
+ */
+void profiler_init(uint64_t now_ns);
+
+/**
+ * @brief Record one run of a stage. Cheap enough to call for every run:
+ *        a few adds and one histogram_record() under an uncontended lock.
+ *        Safe from any thread.
+ *
+ * @param stage the stage
+ * @param cycles duration as a difference of two now_cycles() readings
+ * @param bytes bytes processed by this run
+ */
+void profiler_record(prof_stage_t stage, uint64_t cycles, uint64_t bytes);
+
+/**
+ * @brief Close the current window and start the next one.
+ *
+ * @param now_ns current time (get_nanos())
+ * @param report filled in with the results of the closed window
+ */
+void profiler_roll(uint64_t now_ns, prof_report_t *report);
+
+/**
+ * @brief Format a report as a small table, one line per stage.
+ *
+ * @param report the report
+ * @param buf output buffer
+ * @param len size of buf
+ * @return length of the text (cut to len - 1)
+ */
+size_t profiler_format(const prof_report_t *report, char *buf, size_t len);
+
+/**
+ * @brief Short name of a stage.
+ */
+const char *profiler_stage_name(prof_stage_t stage);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* PROFILER_H_ */
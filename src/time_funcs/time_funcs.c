@@ -27,30 +27,176 @@
  * 
  */
 
-#include <sys/time.h>
-#include <stdio.h>
+#include <time.h>
+#include <stdbool.h>
 #include "time_funcs.h"
+#include "../log/log.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 /*****************************************************************************
  * Definitions
  *****************************************************************************/
 
+/* How long the cycle counter is compared against the raw clock */
+#define CALIBRATION_NS      (10ULL * NSEC_PER_MSEC)
+
+/* Conversions use 32.32 fixed point factors */
+#define FIXED_SHIFT         32U
+
+/* Not every platform has the unslewed clock */
+#ifndef CLOCK_MONOTONIC_RAW
+#define CLOCK_MONOTONIC_RAW CLOCK_MONOTONIC
+#endif
+
 /*****************************************************************************
  * Variables
  *****************************************************************************/
 
+static bool calibrated = false;
+static uint64_t cycles_hz = NSEC_PER_SEC;
+static uint64_t ns_per_cycle_fp = 1ULL << FIXED_SHIFT;    /* nanoseconds per cycle, 32.32 */
+static uint64_t cycles_per_ns_fp = 1ULL << FIXED_SHIFT;   /* cycles per nanosecond, 32.32 */
+
 /*****************************************************************************
  * Prototypes
  *****************************************************************************/
 
+/**
+ * @brief Read a clock and return it in nanoseconds.
+ */
+static inline uint64_t clock_nanos(clockid_t clock);
+
+/**
+ * @brief Multiply by a 32.32 fixed point factor without overflowing.
+ */
+static inline uint64_t mul_fixed(uint64_t value, uint64_t factor);
+static inline uint64_t mul_div(uint64_t value, uint64_t mul, uint64_t div);
+
 /*****************************************************************************
  * Functions
  *****************************************************************************/
 
+void time_funcs_init(void)
+{
+    uint64_t hz;
+
+    /* A second calibration would change the rate of readings already taken */
+    if (calibrated)
+        return;
+
+#if defined(__aarch64__)
+    /* The generic timer publishes its own frequency */
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(hz));
+#elif defined(__x86_64__) || defined(__i386__)
+    /* Count TSC ticks over a fixed interval of the raw clock. Taking the
+     * clock on both sides of each TSC read bounds the error to one call. */
+    uint64_t ns_start = get_nanos_raw();
+    uint64_t cyc_start = now_cycles();
+    uint64_t ns_end;
+    uint64_t cyc_end;
+
+    do {
+        ns_end = get_nanos_raw();
+        cyc_end = now_cycles();
+    } while (ns_end - ns_start < CALIBRATION_NS);
+
+    hz = mul_div(cyc_end - cyc_start, NSEC_PER_SEC, ns_end - ns_start);
+#else
+    hz = NSEC_PER_SEC;
+#endif
+
+    if (0 == hz) {
+        log_error("time_funcs: cycle counter calibration failed, using the raw clock\n");
+        hz = NSEC_PER_SEC;
+    }
+
+    cycles_hz = hz;
+    ns_per_cycle_fp = (NSEC_PER_SEC << FIXED_SHIFT) / hz;
+    cycles_per_ns_fp = mul_div(hz, 1ULL << FIXED_SHIFT, NSEC_PER_SEC);
+    calibrated = true;
+}
+
+uint64_t get_nanos(void)
+{
+    return clock_nanos(CLOCK_MONOTONIC);
+}
+
+uint64_t get_nanos_raw(void)
+{
+    return clock_nanos(CLOCK_MONOTONIC_RAW);
+}
+
+uint64_t get_micros(void)
+{
+    return clock_nanos(CLOCK_MONOTONIC) / NSEC_PER_USEC;
+}
 
 uint64_t get_millis()
 {
-    struct timeval tv;
-    gettimeofday(&tv,NULL);
-    return (uint64_t)tv.tv_sec*1000+tv.tv_usec/1000;
+    return clock_nanos(CLOCK_MONOTONIC) / NSEC_PER_MSEC;
+}
+
+uint64_t now_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t cnt;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(cnt));
+    return cnt;
+#else
+    return get_nanos_raw();
+#endif
+}
+
+uint64_t cycles_per_sec(void)
+{
+    if (!calibrated)
+        time_funcs_init();
+
+    return cycles_hz;
+}
+
+uint64_t cycles_to_nanos(uint64_t cycles)
+{
+    if (!calibrated)
+        time_funcs_init();
+
+    return mul_fixed(cycles, ns_per_cycle_fp);
+}
+
+uint64_t nanos_to_cycles(uint64_t nanos)
+{
+    if (!calibrated)
+        time_funcs_init();
+
+    return mul_fixed(nanos, cycles_per_ns_fp);
+}
+
+static inline uint64_t clock_nanos(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+/* 64 bit arithmetic only, 32 bit targets have no 128 bit integer type.
+ * Splitting both operands at the binary point gives the exact floor. */
+static inline uint64_t mul_fixed(uint64_t value, uint64_t factor)
+{
+    uint64_t value_hi = value >> FIXED_SHIFT;
+    uint64_t value_lo = value & 0xFFFFFFFFULL;
+    uint64_t factor_hi = factor >> FIXED_SHIFT;
+    uint64_t factor_lo = factor & 0xFFFFFFFFULL;
+
+    return (value * factor_hi) + (value_hi * factor_lo) + ((value_lo * factor_lo) >> FIXED_SHIFT);
+}
+
+/* value * mul / div without overflow as long as (div - 1) * mul fits in 64 bits */
+static inline uint64_t mul_div(uint64_t value, uint64_t mul, uint64_t div)
+{
+    return ((value / div) * mul) + (((value % div) * mul) / div);
 }
\ No newline at end of file
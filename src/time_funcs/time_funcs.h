@@ -40,6 +40,10 @@ extern "C" {
  * Definitions
  *****************************************************************************/
 
+#define NSEC_PER_USEC   1000ULL
+#define NSEC_PER_MSEC   1000000ULL
+#define NSEC_PER_SEC    1000000000ULL
+
 /*****************************************************************************
  * Structs, Unions, Enums, & Typedefs
  *****************************************************************************/
@@ -48,14 +52,85 @@ extern "C" {
  * Function Prototypes
  *****************************************************************************/
 
+/**
+ * @brief Calibrate the cycle counter against the monotonic clock.
+ *
+ * Blocks for about 10ms on the first call, later calls return straight away.
+ * Called automatically by the first cycles conversion if it hasn't been
+ * called, but calling it at start up keeps that delay out of the hot path.
+ */
+void time_funcs_init(void);
 
 /**
- * @brief Get milliseconds since the Epoch
- * 
- * @return uint64_t 
+ * @brief Get nanoseconds from the monotonic clock (CLOCK_MONOTONIC).
+ *
+ * Not affected by changes to the wall clock, but slewed by NTP so that
+ * long intervals match real time.
+ *
+ * @return uint64_t nanoseconds since an arbitrary point (usually boot)
+ */
+uint64_t get_nanos(void);
+
+/**
+ * @brief Get nanoseconds from the raw hardware clock (CLOCK_MONOTONIC_RAW).
+ *
+ * Never slewed, so short intervals are measured at the hardware's own rate.
+ *
+ * @return uint64_t nanoseconds since an arbitrary point (usually boot)
+ */
+uint64_t get_nanos_raw(void);
+
+/**
+ * @brief Get microseconds from the monotonic clock.
+ *
+ * @return uint64_t
+ */
+uint64_t get_micros(void);
+
+/**
+ * @brief Get milliseconds from the monotonic clock.
+ *
+ * Only useful for intervals and deadlines, the value is not related to the
+ * time of day.
+ *
+ * @return uint64_t
  */
 uint64_t get_millis();
 
+/**
+ * @brief Read the CPU cycle counter (TSC on x86-64, CNTVCT on AArch64).
+ *
+ * A few nanoseconds per call, no system call. Use for hot path instrumentation
+ * and convert the difference of two readings with cycles_to_nanos(). Falls
+ * back to get_nanos_raw() on other architectures.
+ *
+ * @return uint64_t counter value
+ */
+uint64_t now_cycles(void);
+
+/**
+ * @brief Cycle counter frequency found by calibration.
+ *
+ * @return uint64_t counts per second
+ */
+uint64_t cycles_per_sec(void);
+
+/**
+ * @brief Convert a number of cycles (a difference of two now_cycles() readings) to nanoseconds.
+ *
+ * @param cycles
+ * @return uint64_t nanoseconds
+ */
+uint64_t cycles_to_nanos(uint64_t cycles);
+
+/**
+ * @brief Convert nanoseconds to a number of cycles.
+ *
+ * @param nanos
+ * @return uint64_t cycles
+ */
+uint64_t nanos_to_cycles(uint64_t nanos);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,285 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        timer_wheel.c
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "timer_wheel.h"
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+#define SLOT_MASK       ((uint64_t)TIMER_WHEEL_SLOTS - 1U)
+
+/* Ticks covered by a whole level, and by the whole wheel */
+#define LEVEL_SPAN(l)   (1ULL << (TIMER_WHEEL_SLOT_BITS * ((l) + 1U)))
+#define WHEEL_SPAN      LEVEL_SPAN(TIMER_WHEEL_LEVELS - 1U)
+
+/*****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Link a timer into the slot that covers its expiry.
+ */
+static void link_timer(timer_wheel_t *tw, tw_timer_t *t);
+
+/**
+ * @brief Remove a timer from its slot.
+ */
+static void unlink_timer(timer_wheel_t *tw, tw_timer_t *t);
+
+/**
+ * @brief Move every timer in a higher level slot down to where it now belongs.
+ */
+static void cascade(timer_wheel_t *tw, uint32_t level, uint32_t slot);
+
+/**
+ * @brief Distance from start to the first occupied slot (wrapping), 64 if none.
+ */
+static inline uint32_t first_occupied(uint64_t bits, uint32_t start);
+
+/*****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+void timer_wheel_init(timer_wheel_t *tw, uint64_t tick_ns, uint64_t now_ns)
+{
+    if (NULL == tw)
+        return;
+
+    memset(tw, 0, sizeof(*tw));
+    tw->tick_ns = (tick_ns > 0) ? tick_ns : 1;
+    tw->now = now_ns / tw->tick_ns;
+}
+
+void timer_wheel_timer_init(tw_timer_t *timer)
+{
+    if (NULL != timer) {
+        memset(timer, 0, sizeof(*timer));
+    }
+}
+
+void timer_wheel_schedule(timer_wheel_t *tw, tw_timer_t *timer, uint64_t delay_ns, tw_callback_t cb, void *ctx)
+{
+    if ((NULL == tw) || (NULL == timer) || (NULL == cb))
+        return;
+
+    if (timer->pending) {
+        unlink_timer(tw, timer);
+    }
+
+    /* Round up, and never schedule into the tick being processed */
+    uint64_t ticks = (delay_ns + tw->tick_ns - 1) / tw->tick_ns;
+    if (0 == ticks) {
+        ticks = 1;
+    }
+
+    timer->expires = tw->now + ticks;
+    timer->cb = cb;
+    timer->ctx = ctx;
+    timer->pending = true;
+    tw->count++;
+
+    link_timer(tw, timer);
+}
+
+void timer_wheel_cancel(timer_wheel_t *tw, tw_timer_t *timer)
+{
+    if ((NULL == tw) || (NULL == timer) || !timer->pending)
+        return;
+
+    unlink_timer(tw, timer);
+    timer->pending = false;
+    tw->count--;
+}
+
+bool timer_wheel_is_pending(const tw_timer_t *timer)
+{
+    return (NULL != timer) && timer->pending;
+}
+
+uint32_t timer_wheel_advance(timer_wheel_t *tw, uint64_t now_ns)
+{
+    uint32_t expired = 0;
+
+    if (NULL == tw)
+        return 0;
+
+    const uint64_t target = now_ns / tw->tick_ns;
+
+    while (tw->now < target) {
+        if (0 == tw->count) {
+            tw->now = target;
+            break;
+        }
+
+        /* Jump to the next occupied level 0 slot, but stop at the next
+         * block boundary where higher levels have to cascade */
+        uint64_t next = (tw->now | SLOT_MASK) + 1;
+        uint32_t dist = first_occupied(tw->occupied[0], (uint32_t)((tw->now + 1) & SLOT_MASK));
+        if ((dist < TIMER_WHEEL_SLOTS) && (tw->now + 1 + dist < next)) {
+            next = tw->now + 1 + dist;
+        }
+        if (next > target) {
+            tw->now = target;
+            break;
+        }
+        tw->now = next;
+
+        /* Each level cascades when every level below it has wrapped */
+        for (uint32_t level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+            uint64_t shift = TIMER_WHEEL_SLOT_BITS * level;
+            if (tw->now & ((1ULL << shift) - 1))
+                break;
+            cascade(tw, level, (uint32_t)((tw->now >> shift) & SLOT_MASK));
+        }
+
+        /* Everything in this slot is due now. Unlink before the callback so it can reschedule. */
+        uint32_t slot = (uint32_t)(tw->now & SLOT_MASK);
+        while (NULL != tw->slots[0][slot]) {
+            tw_timer_t *t = tw->slots[0][slot];
+            unlink_timer(tw, t);
+            t->pending = false;
+            tw->count--;
+            t->cb(t, t->ctx);
+            expired++;
+        }
+    }
+
+    return expired;
+}
+
+uint64_t timer_wheel_next_ns(const timer_wheel_t *tw, uint64_t now_ns)
+{
+    uint64_t due = UINT64_MAX;
+
+    if ((NULL == tw) || (0 == tw->count))
+        return UINT64_MAX;
+
+    for (uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        uint64_t shift = TIMER_WHEEL_SLOT_BITS * level;
+        uint64_t block = tw->now >> shift;
+        uint32_t dist = first_occupied(tw->occupied[level], (uint32_t)((block + 1) & SLOT_MASK));
+        if (dist < TIMER_WHEEL_SLOTS) {
+            /* Level 0 slots are exact ticks, higher levels are due when they cascade */
+            uint64_t tick = (block + 1 + dist) << shift;
+            if (tick < due) {
+                due = tick;
+            }
+        }
+    }
+
+    if (UINT64_MAX == due)
+        return UINT64_MAX;
+
+    uint64_t due_ns = due * tw->tick_ns;
+    return (due_ns > now_ns) ? (due_ns - now_ns) : 0;
+}
+
+static void link_timer(timer_wheel_t *tw, tw_timer_t *t)
+{
+    uint64_t expires = t->expires;
+    uint32_t level = 0;
+
+    /* Only happens when cascading a timer due on the current tick */
+    if (expires < tw->now) {
+        expires = tw->now;
+    }
+
+    /* Beyond the wheel: park in the furthest slot, it is re-linked when it cascades */
+    if (expires - tw->now >= WHEEL_SPAN) {
+        expires = tw->now + WHEEL_SPAN - 1;
+    }
+
+    while ((level < TIMER_WHEEL_LEVELS - 1) && ((expires - tw->now) >= LEVEL_SPAN(level))) {
+        level++;
+    }
+
+    uint32_t slot = (uint32_t)((expires >> (TIMER_WHEEL_SLOT_BITS * level)) & SLOT_MASK);
+
+    t->level = (uint8_t)level;
+    t->slot = (uint8_t)slot;
+    t->prev = NULL;
+    t->next = tw->slots[level][slot];
+    if (NULL != t->next) {
+        t->next->prev = t;
+    }
+    tw->slots[level][slot] = t;
+    tw->occupied[level] |= (1ULL << slot);
+}
+
+static void unlink_timer(timer_wheel_t *tw, tw_timer_t *t)
+{
+    if (NULL != t->prev) {
+        t->prev->next = t->next;
+    }
+    else {
+        tw->slots[t->level][t->slot] = t->next;
+    }
+
+    if (NULL != t->next) {
+        t->next->prev = t->prev;
+    }
+
+    if (NULL == tw->slots[t->level][t->slot]) {
+        tw->occupied[t->level] &= ~(1ULL << t->slot);
+    }
+
+    t->next = NULL;
+    t->prev = NULL;
+}
+
+static void cascade(timer_wheel_t *tw, uint32_t level, uint32_t slot)
+{
+    tw_timer_t *t = tw->slots[level][slot];
+
+    tw->slots[level][slot] = NULL;
+    tw->occupied[level] &= ~(1ULL << slot);
+
+    while (NULL != t) {
+        tw_timer_t *next = t->next;
+        link_timer(tw, t);
+        t = next;
+    }
+}
+
+static inline uint32_t first_occupied(uint64_t bits, uint32_t start)
+{
+    if (0 == bits)
+        return TIMER_WHEEL_SLOTS;
+
+    /* Rotate so bit 0 is the start slot, then count up to the first set bit */
+    uint64_t rotated = (start == 0) ? bits : ((bits >> start) | (bits << (TIMER_WHEEL_SLOTS - start)));
+    return (uint32_t)__builtin_ctzll(rotated);
+}
\ No newline at end of file
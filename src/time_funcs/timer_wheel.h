@@ -0,0 +1,167 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        timer_wheel.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Slots per level. Each level's occupancy fits in one 64 bit word. */
+#define TIMER_WHEEL_SLOT_BITS   6U
+#define TIMER_WHEEL_SLOTS       (1U << TIMER_WHEEL_SLOT_BITS)
+
+/* Number of levels. 4 levels of 64 slots cover 2^24 ticks (4.6 hours at 1 ms). */
+#define TIMER_WHEEL_LEVELS      4U
+
+/*****************************************************************************
+ * Structs, Unions, Enums, & Typedefs
+ *****************************************************************************/
+
+struct tw_timer_t;
+
+/**
+ * @brief Called when a timer expires. The timer may be rescheduled from the callback.
+ *
+ * @param timer the timer that expired
+ * @param ctx context given when the timer was scheduled
+ */
+typedef void (*tw_callback_t)(struct tw_timer_t *timer, void *ctx);
+
+/**
+ * @brief A timer. Owned by the caller (usually embedded in its own struct),
+ * the wheel never allocates. Zero it (or call timer_wheel_timer_init) before first use.
+ */
+typedef struct tw_timer_t {
+    struct tw_timer_t *next;    /**< Slot list links */
+    struct tw_timer_t *prev;
+    uint64_t expires;           /**< Tick the timer is due on */
+    tw_callback_t cb;           /**< Called on expiry */
+    void *ctx;                  /**< Passed to the callback */
+    uint8_t level;              /**< Where the timer is linked while pending */
+    uint8_t slot;
+    bool pending;               /**< Scheduled and not yet expired or cancelled */
+} tw_timer_t;
+
+/**
+ * @brief Hierarchical timer wheel.
+ *
+ * Level 0 has one slot per tick, each higher level has slots 64 times
+ * wider. Timers are linked into the slot covering their expiry, and are moved
+ * down a level when the wheel reaches their slot. Insert and cancel are O(1);
+ * empty slots are skipped using the occupancy bitmaps.
+ */
+typedef struct timer_wheel_t {
+    uint64_t tick_ns;                                           /**< Length of one tick */
+    uint64_t now;                                               /**< Last tick processed */
+    uint64_t occupied[TIMER_WHEEL_LEVELS];                      /**< Bit per non-empty slot */
+    tw_timer_t *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];   /**< Slot list heads */
+    uint32_t count;                                             /**< Pending timers */
+} timer_wheel_t;
+
+/*****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Initialize a wheel.
+ *
+ * @param tw the wheel
+ * @param tick_ns resolution, timers expire on tick boundaries
+ * @param now_ns current time (get_nanos())
+ */
+void timer_wheel_init(timer_wheel_t *tw, uint64_t tick_ns, uint64_t now_ns);
+
+/**
+ * @brief Reset a timer so it can be scheduled or cancelled safely.
+ *
+ * @param timer the timer
+ */
+void timer_wheel_timer_init(tw_timer_t *timer);
+
+/**
+ * @brief Schedule a timer to expire after a delay. A pending timer is moved.
+ *
+ * The delay is rounded up to whole ticks, so the timer never fires early.
+ *
+ * @param tw the wheel
+ * @param timer the timer
+ * @param delay_ns time from the wheel's current time
+ * @param cb called on expiry
+ * @param ctx passed to the callback
+ */
+void timer_wheel_schedule(timer_wheel_t *tw, tw_timer_t *timer, uint64_t delay_ns, tw_callback_t cb, void *ctx);
+
+/**
+ * @brief Cancel a pending timer. Does nothing if the timer isn't pending.
+ *
+ * @param tw the wheel
+ * @param timer the timer
+ */
+void timer_wheel_cancel(timer_wheel_t *tw, tw_timer_t *timer);
+
+/**
+ * @brief Returns true if the timer is scheduled and hasn't expired yet.
+ */
+bool timer_wheel_is_pending(const tw_timer_t *timer);
+
+/**
+ * @brief Advance the wheel to the given time and run every timer that is due.
+ *
+ * @param tw the wheel
+ * @param now_ns current time (get_nanos())
+ * @return uint32_t number of timers that expired
+ */
+uint32_t timer_wheel_advance(timer_wheel_t *tw, uint64_t now_ns);
+
+/**
+ * @brief Time until the wheel next needs to be advanced.
+ *
+ * Exact for timers in the lowest level. For timers further out it is the time
+ * they move down a level, which is never later than their expiry.
+ *
+ * @param tw the wheel
+ * @param now_ns current time (get_nanos())
+ * @return uint64_t nanoseconds, UINT64_MAX if no timers are pending
+ */
+uint64_t timer_wheel_next_ns(const timer_wheel_t *tw, uint64_t now_ns);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* TIMER_WHEEL_H_ */
@@ -0,0 +1,334 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2024 David Burke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * File        trace.c
+ * Created by  David Burke
+ * Version     1.0
+ * 
+ */
+
+
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+
+#include "../time_funcs/time_funcs.h"
+#include "../log/log.h"
+
+/****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* stdio buffer used when dumping to a file */
+#define TRACE_FILE_BUF_BYTES    (256U * 1024U)
+
+/**
+ * @brief Single producer event ring. Only the owning thread writes events;
+ *        the exporter reads them while recording is paused.
+ */
+typedef struct trace_ring_t {
+    _Atomic size_t head;                        /**< Events ever recorded, written by the owner */
+    size_t start;                               /**< Value of head at the last clear */
+    const char *thread_name;                    /**< Set by trace_set_thread_name() */
+    trace_event_t events[TRACE_RING_EVENTS];
+} trace_ring_t;
+
+/****************************************************************************
+ * Variables
+ *****************************************************************************/
+
+static trace_ring_t rings[TRACE_MAX_THREADS];
+static _Atomic uint32_t ring_count = 0;
+static atomic_bool running = false;
+
+static __thread trace_ring_t *my_ring = NULL;
+static __thread bool my_ring_failed = false;
+
+/****************************************************************************
+ * Prototypes
+ *****************************************************************************/
+
+static trace_ring_t *get_ring(void);
+static size_t first_event(trace_ring_t *ring, size_t head);
+static void write_string(FILE *out, const char *s);
+
+/****************************************************************************
+ * Functions
+ *****************************************************************************/
+
+void trace_init(void)
+{
+    /* The first conversion would otherwise calibrate in the middle of an
+     * export. Runs before app_init, whose call then finds it done. */
+    time_funcs_init();
+}
+
+void trace_start(void)
+{
+    atomic_store(&running, true);
+}
+
+void trace_stop(void)
+{
+    atomic_store(&running, false);
+}
+
+bool trace_is_running(void)
+{
+    return atomic_load(&running);
+}
+
+void trace_clear(void)
+{
+    uint32_t count = atomic_load(&ring_count);
+
+    trace_stop();
+
+    /* Only the owner moves head, so the old events are skipped rather than reset */
+    for (uint32_t i = 0; (i < count) && (i < TRACE_MAX_THREADS); i++) {
+        rings[i].start = atomic_load_explicit(&rings[i].head, memory_order_acquire);
+    }
+}
+
+void trace_record(trace_type_t type, const char *name, int64_t value)
+{
+    trace_ring_t *ring;
+
+    if (!atomic_load_explicit(&running, memory_order_relaxed)) {
+        return;
+    }
+
+    ring = my_ring;
+    if (NULL == ring) {
+        ring = get_ring();
+        if (NULL == ring) {
+            return;
+        }
+    }
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    trace_event_t *ev = &ring->events[head & (TRACE_RING_EVENTS - 1)];
+
+    ev->ts = now_cycles();
+    ev->name = name;
+    ev->value = value;
+    ev->type = (uint32_t)type;
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void trace_set_thread_name(const char *name)
+{
+    trace_ring_t *ring = (NULL != my_ring) ? my_ring : get_ring();
+
+    if (NULL != ring) {
+        ring->thread_name = name;
+    }
+}
+
+size_t trace_get_count(void)
+{
+    uint32_t count = atomic_load(&ring_count);
+    size_t total = 0;
+
+    for (uint32_t i = 0; (i < count) && (i < TRACE_MAX_THREADS); i++) {
+        size_t head = atomic_load_explicit(&rings[i].head, memory_order_acquire);
+        total += head - first_event(&rings[i], head);
+    }
+    return total;
+}
+
+size_t trace_export_chrome(FILE *out)
+{
+    uint32_t count = atomic_load(&ring_count);
+    bool was_running = atomic_exchange(&running, false);
+    uint64_t base = UINT64_MAX;
+    size_t written = 0;
+    bool first = true;
+
+    if (count > TRACE_MAX_THREADS) {
+        count = TRACE_MAX_THREADS;
+    }
+
+    /* Timestamps are relative to the oldest event */
+    for (uint32_t i = 0; i < count; i++) {
+        size_t head = atomic_load_explicit(&rings[i].head, memory_order_acquire);
+        size_t n = first_event(&rings[i], head);
+        if (n != head) {
+            uint64_t ts = rings[i].events[n & (TRACE_RING_EVENTS - 1)].ts;
+            if (ts < base) {
+                base = ts;
+            }
+        }
+    }
+
+    fputs("{\"traceEvents\":[", out);
+
+    for (uint32_t i = 0; i < count; i++) {
+        trace_ring_t *ring = &rings[i];
+        size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        unsigned tid = i + 1;
+        unsigned depth = 0;
+
+        if (NULL != ring->thread_name) {
+            fprintf(out, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                    first ? "" : ",", tid);
+            write_string(out, ring->thread_name);
+            fputs("}}", out);
+            first = false;
+        }
+
+        for (size_t n = first_event(ring, head); n != head; n++) {
+            const trace_event_t *ev = &ring->events[n & (TRACE_RING_EVENTS - 1)];
+            uint64_t ns = (ev->ts > base) ? cycles_to_nanos(ev->ts - base) : 0;
+            const char *ph;
+
+            switch (ev->type) {
+            case TRACE_TYPE_BEGIN:
+                ph = "B";
+                depth++;
+                break;
+
+            case TRACE_TYPE_END:
+                /* Its begin was overwritten, the viewer can't pair it */
+                if (0 == depth) {
+                    continue;
+                }
+                ph = "E";
+                depth--;
+                break;
+
+            case TRACE_TYPE_INSTANT:
+                ph = "i";
+                break;
+
+            case TRACE_TYPE_COUNTER:
+                ph = "C";
+                break;
+
+            default:
+                continue;
+            }
+
+            fprintf(out, "%s\n{\"name\":", first ? "" : ",");
+            write_string(out, ev->name);
+            fprintf(out, ",\"ph\":\"%s\",\"ts\":%llu.%03u,\"pid\":1,\"tid\":%u",
+                    ph, (unsigned long long)(ns / NSEC_PER_USEC), (unsigned)(ns % NSEC_PER_USEC), tid);
+
+            if (TRACE_TYPE_INSTANT == ev->type) {
+                fputs(",\"s\":\"t\"", out);
+            }
+            else if (TRACE_TYPE_COUNTER == ev->type) {
+                fprintf(out, ",\"args\":{\"value\":%lld}", (long long)ev->value);
+            }
+            fputc('}', out);
+
+            first = false;
+            written++;
+        }
+    }
+
+    fputs("\n],\"displayTimeUnit\":\"ns\"}\n", out);
+
+    if (was_running) {
+        trace_start();
+    }
+    return written;
+}
+
+bool trace_dump_chrome(const char *path)
+{
+    FILE *out = fopen(path, "w");
+    if (NULL == out) {
+        log_error("trace: can't create %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    /* One large buffer instead of a write() every 4K */
+    char *buf = malloc(TRACE_FILE_BUF_BYTES);
+    if (NULL != buf) {
+        setvbuf(out, buf, _IOFBF, TRACE_FILE_BUF_BYTES);
+    }
+
+    trace_export_chrome(out);
+
+    bool ok = (0 == ferror(out));
+    if (0 != fclose(out)) {
+        ok = false;
+    }
+    free(buf);
+
+    if (!ok) {
+        log_error("trace: error writing %s\n", path);
+    }
+    return ok;
+}
+
+static trace_ring_t *get_ring(void)
+{
+    if (my_ring_failed) {
+        return NULL;
+    }
+
+    uint32_t index = atomic_fetch_add(&ring_count, 1);
+    if (index >= TRACE_MAX_THREADS) {
+        my_ring_failed = true;
+        return NULL;
+    }
+
+    my_ring = &rings[index];
+    return my_ring;
+}
+
+static size_t first_event(trace_ring_t *ring, size_t head)
+{
+    size_t n = ring->start;
+
+    /* Leave out the oldest slot as well: with recording paused it is the
+     * one a thread that was mid-record could still be writing. */
+    if (head - n >= TRACE_RING_EVENTS) {
+        n = head - TRACE_RING_EVENTS + 1;
+    }
+    return n;
+}
+
+static void write_string(FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; (NULL != s) && ('\0' != *s); s++) {
+        if (('"' == *s) || ('\\' == *s)) {
+            fputc('\\', out);
+            fputc(*s, out);
+        }
+        else if ((unsigned char)*s < 0x20) {
+            fprintf(out, "\\u%04x", (unsigned)(unsigned char)*s);
+        }
+        else {
+            fputc(*s, out);
+        }
+    }
+    fputc('"', out);
+}
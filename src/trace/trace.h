@@ -0,0 +1,170 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 David Burke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the 'Software'), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * File        trace.h
+ * Created by  David Burke
+ * Version     1.0
+ *
+ */
+
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/*****************************************************************************
+ * Definitions
+ *****************************************************************************/
+
+/* Set to 0 (cmake -DTRACE=OFF) to compile the trace points out completely */
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED       1
+#endif
+
+/* Events kept per thread, power of 2. Older events are overwritten. */
+#define TRACE_RING_EVENTS   16384U
+
+/* Threads that can record events */
+#define TRACE_MAX_THREADS   8U
+
+/* Trace points. Names must be string literals: only the pointer is stored. */
+#if TRACE_ENABLED
+#define TRACE_BEGIN(name)           trace_record(TRACE_TYPE_BEGIN, (name), 0)
+#define TRACE_END(name)             trace_record(TRACE_TYPE_END, (name), 0)
+#define TRACE_INSTANT(name)         trace_record(TRACE_TYPE_INSTANT, (name), 0)
+#define TRACE_COUNTER(name, value)  trace_record(TRACE_TYPE_COUNTER, (name), (int64_t)(value))
+#define TRACE_THREAD_NAME(name)     trace_set_thread_name(name)
+#else
+#define TRACE_BEGIN(name)           ((void)0)
+#define TRACE_END(name)             ((void)0)
+#define TRACE_INSTANT(name)         ((void)0)
+#define TRACE_COUNTER(name, value)  ((void)0)
+#define TRACE_THREAD_NAME(name)     ((void)0)
+#endif
+
+/*****************************************************************************
+ * Structs, Unions, Enums, & Typedefs
+ *****************************************************************************/
+
+typedef enum trace_type_t {
+    TRACE_TYPE_BEGIN,       /**< Start of a slice */
+    TRACE_TYPE_END,         /**< End of the innermost open slice */
+    TRACE_TYPE_INSTANT,     /**< A point in time */
+    TRACE_TYPE_COUNTER,     /**< A value over time */
+    TRACE_TYPE_MAX
+} trace_type_t;
+
+/**
+ * @brief One recorded event, 32 bytes.
+ */
+typedef struct trace_event_t {
+    uint64_t ts;            /**< now_cycles() when recorded */
+    const char *name;       /**< Static name */
+    int64_t value;          /**< Counter value */
+    uint32_t type;          /**< trace_type_t */
+    uint32_t reserved;
+} trace_event_t;
+
+/*****************************************************************************
+ * Function Prototypes
+ *****************************************************************************/
+
+/**
+ * @brief Calibrate the timestamp counter, once per process (app_init finds it
+ * done). Recording starts with trace_start().
+ */
+void trace_init(void);
+
+/**
+ * @brief Start recording. Events are added to the calling thread's ring.
+ */
+void trace_start(void);
+
+/**
+ * @brief Stop recording. The recorded events are kept until trace_clear().
+ */
+void trace_stop(void);
+
+/**
+ * @brief Returns true while recording.
+ */
+bool trace_is_running(void);
+
+/**
+ * @brief Stop recording and forget every recorded event.
+ */
+void trace_clear(void);
+
+/**
+ * @brief Record an event. Use the TRACE_* macros instead.
+ *
+ * A counter read and a few stores into the calling thread's ring, no locks.
+ *
+ * @param type event type
+ * @param name static name shown in the viewer
+ * @param value counter value, ignored for other types
+ */
+void trace_record(trace_type_t type, const char *name, int64_t value);
+
+/**
+ * @brief Name the calling thread in the exported trace.
+ *
+ * @param name static name
+ */
+void trace_set_thread_name(const char *name);
+
+/**
+ * @brief Number of events currently held in all rings.
+ */
+size_t trace_get_count(void);
+
+/**
+ * @brief Write the recorded events as Chrome trace JSON (chrome://tracing, Perfetto).
+ *
+ * Recording is paused while exporting and resumed afterwards.
+ *
+ * @param out stream to write to
+ * @return number of events written
+ */
+size_t trace_export_chrome(FILE *out);
+
+/**
+ * @brief trace_export_chrome() to a file.
+ *
+ * @param path file to create
+ * @return true if the file was written
+ */
+bool trace_dump_chrome(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* TRACE_H_ */
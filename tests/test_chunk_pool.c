@@ -0,0 +1,151 @@
+#include "unity.h"
+#include "chunk_pool.h"
+#include "chunk_pool.c"
+#include "mpsc_queue.c"
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define CHUNK_COUNT 8U
+#define CHUNK_SIZE 64U
+
+#define RELEASERS 3U
+#define ROUNDS 20000U
+
+static chunk_pool_t pool;
+
+/* Chunks handed to the releasing threads */
+static mpsc_queue_t handoff[RELEASERS];
+static chunk_t *handoff_items[RELEASERS][CHUNK_COUNT];
+static atomic_size_t handoff_seq[RELEASERS][CHUNK_COUNT];
+static atomic_bool handoff_done;
+
+/**
+ * @brief Set up function that is called before each test case.
+ */
+void setUp(void)
+{
+    chunk_pool_init(&pool, CHUNK_COUNT, CHUNK_SIZE);
+}
+
+/**
+ * @brief Tear down function that is called after each test case.
+ */
+void tearDown(void)
+{
+    chunk_pool_deinit(&pool);
+}
+
+void test_chunk_pool_init(void)
+{
+    chunk_pool_t p;
+
+    TEST_ASSERT_TRUE(chunk_pool_init(&p, CHUNK_COUNT, CHUNK_SIZE));
+    TEST_ASSERT_EQUAL(CHUNK_COUNT, chunk_pool_available(&p));
+    chunk_pool_deinit(&p);
+
+    // The free queue needs a power of two
+    TEST_ASSERT_FALSE(chunk_pool_init(&p, 6, CHUNK_SIZE));
+    TEST_ASSERT_FALSE(chunk_pool_init(&p, CHUNK_COUNT, 0));
+    TEST_ASSERT_FALSE(chunk_pool_init(NULL, CHUNK_COUNT, CHUNK_SIZE));
+}
+
+void test_chunk_pool_exhausted(void)
+{
+    chunk_t *chunks[CHUNK_COUNT];
+
+    for (uint32_t i = 0; i < CHUNK_COUNT; i++) {
+        chunks[i] = chunk_pool_get(&pool);
+        TEST_ASSERT_NOT_NULL(chunks[i]);
+        TEST_ASSERT_EQUAL(1, atomic_load(&chunks[i]->refs));
+        TEST_ASSERT_EQUAL(0, chunks[i]->len);
+    }
+
+    // Every chunk has its own data
+    for (uint32_t i = 1; i < CHUNK_COUNT; i++) {
+        TEST_ASSERT_TRUE(chunks[i]->data != chunks[0]->data);
+    }
+
+    TEST_ASSERT_NULL(chunk_pool_get(&pool));
+    TEST_ASSERT_EQUAL(1, chunk_pool_exhausted(&pool));
+
+    chunk_release(chunks[3]);
+    TEST_ASSERT_TRUE(chunks[3] == chunk_pool_get(&pool));
+}
+
+void test_chunk_pool_last_release_returns(void)
+{
+    chunk_t *chunk = chunk_pool_get(&pool);
+
+    // Three consumers share it
+    chunk_ref(chunk);
+    chunk_ref(chunk);
+    TEST_ASSERT_EQUAL(CHUNK_COUNT - 1, chunk_pool_available(&pool));
+
+    chunk_release(chunk);
+    chunk_release(chunk);
+    TEST_ASSERT_EQUAL(CHUNK_COUNT - 1, chunk_pool_available(&pool));
+
+    chunk_release(chunk);
+    TEST_ASSERT_EQUAL(CHUNK_COUNT, chunk_pool_available(&pool));
+
+    chunk_release(NULL);
+}
+
+static void *releaser(void *arg)
+{
+    mpsc_queue_t *q = arg;
+    chunk_t *chunk;
+
+    for (;;) {
+        // Read before popping, so done and empty means nothing is left
+        bool done = atomic_load(&handoff_done);
+
+        if (mpsc_queue_pop(q, &chunk)) {
+            chunk_release(chunk);
+        }
+        else if (done) {
+            break;
+        }
+        else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void test_chunk_pool_release_from_other_threads(void)
+{
+    pthread_t threads[RELEASERS];
+
+    atomic_store(&handoff_done, false);
+    for (uint32_t t = 0; t < RELEASERS; t++) {
+        mpsc_queue_init(&handoff[t], handoff_items[t], handoff_seq[t], CHUNK_COUNT, sizeof(chunk_t *));
+        pthread_create(&threads[t], NULL, releaser, &handoff[t]);
+    }
+
+    // Each chunk goes to every thread, the last one to let go returns it
+    for (uint32_t i = 0; i < ROUNDS; i++) {
+        chunk_t *chunk;
+        while ((chunk = chunk_pool_get(&pool)) == NULL) {
+            sched_yield();
+        }
+        chunk->data[0] = (uint8_t)i;
+
+        for (uint32_t t = 1; t < RELEASERS; t++) {
+            chunk_ref(chunk);
+        }
+        for (uint32_t t = 0; t < RELEASERS; t++) {
+            while (!mpsc_queue_push(&handoff[t], &chunk)) {
+                sched_yield();
+            }
+        }
+    }
+
+    atomic_store(&handoff_done, true);
+    for (uint32_t t = 0; t < RELEASERS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    TEST_ASSERT_EQUAL(CHUNK_COUNT, chunk_pool_available(&pool));
+}
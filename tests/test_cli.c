@@ -0,0 +1,204 @@
+#include "unity.h"
+#include "cli.h"
+#include "cli.c"
+#include "cli_args.h"
+#include "cli_args.c"
+#include <stdarg.h>
+#include <stdio.h>
+
+static cli_t cli;
+static uint8_t rx_buf[128];
+static int calls;
+static int last_argc;
+
+static void quiet_println(const char *format, ...)
+{
+    (void)format;
+}
+
+static cli_status_t count_func(int argc, char **argv)
+{
+    (void)argv;
+    calls++;
+    last_argc = argc;
+    return CLI_OK;
+}
+
+static cmd_t table[] = {
+    { .cmd = "help",   .func = count_func },
+    { .cmd = "send",   .func = count_func, .help_text = "send <x>", .min_args = 1, .max_args = CLI_ARGS_ANY },
+    { .cmd = "status", .func = count_func, .min_args = 0, .max_args = 1 },
+    { .cmd = "stop",   .func = count_func },
+};
+
+static cli_status_t run(const char *line)
+{
+    for (const char *c = line; *c != '\0'; c++) {
+        cli_put(&cli, *c);
+    }
+    cli_put(&cli, CMD_TERMINATOR);
+    return cli_process(&cli);
+}
+
+/**
+ * @brief Set up function that is called before each test case.
+ */
+void setUp(void)
+{
+    memset(&cli, 0, sizeof(cli));
+    cli.println = quiet_println;
+    cli.cmd_tbl = table;
+    cli.cmd_cnt = sizeof(table) / sizeof(table[0]);
+    cli_init(&cli, rx_buf, sizeof(rx_buf));
+    calls = 0;
+    last_argc = 0;
+}
+
+/**
+ * @brief Tear down function that is called after each test case.
+ */
+void tearDown(void)
+{
+}
+
+void test_cli_find_registered(void)
+{
+    static const cmd_t ping = { .cmd = "ping", .func = count_func };
+
+    TEST_ASSERT_EQUAL(CLI_OK, cli_register(&cli, &ping));
+    TEST_ASSERT_EQUAL_PTR(&ping, cli_find(&cli, "ping"));
+    TEST_ASSERT_EQUAL_PTR(&table[1], cli_find(&cli, "send"));
+    TEST_ASSERT_NULL(cli_find(&cli, "pin"));
+    TEST_ASSERT_NULL(cli_find(&cli, "nope"));
+}
+
+void test_cli_rejects_duplicates(void)
+{
+    static const cmd_t again = { .cmd = "send", .func = count_func };
+
+    TEST_ASSERT_NOT_EQUAL(CLI_OK, cli_register(&cli, &again));
+    TEST_ASSERT_EQUAL_PTR(&table[1], cli_find(&cli, "send"));
+}
+
+void test_cli_commands_are_sorted(void)
+{
+    TEST_ASSERT_EQUAL_STRING("help", cli_get_cmd(&cli, 0)->cmd);
+    TEST_ASSERT_EQUAL_STRING("send", cli_get_cmd(&cli, 1)->cmd);
+    TEST_ASSERT_EQUAL_STRING("status", cli_get_cmd(&cli, 2)->cmd);
+    TEST_ASSERT_EQUAL_STRING("stop", cli_get_cmd(&cli, 3)->cmd);
+    TEST_ASSERT_NULL(cli_get_cmd(&cli, 4));
+}
+
+void test_cli_complete_prefix(void)
+{
+    const cmd_t *matches[4];
+
+    TEST_ASSERT_EQUAL(3, cli_complete(&cli, "s", matches, 4));
+    TEST_ASSERT_EQUAL_STRING("send", matches[0]->cmd);
+    TEST_ASSERT_EQUAL(2, cli_complete(&cli, "st", matches, 4));
+    TEST_ASSERT_EQUAL(1, cli_complete(&cli, "he", matches, 4));
+    TEST_ASSERT_EQUAL(0, cli_complete(&cli, "x", matches, 4));
+}
+
+void test_cli_process_runs_exact_names_only(void)
+{
+    TEST_ASSERT_EQUAL(CLI_E_CMD_NOT_FOUND, run("he"));
+    TEST_ASSERT_EQUAL(CLI_E_CMD_NOT_FOUND, run("st"));
+    TEST_ASSERT_EQUAL(CLI_E_CMD_NOT_FOUND, run("sto"));
+    TEST_ASSERT_EQUAL(0, calls);
+    TEST_ASSERT_EQUAL(CLI_OK, run("stop"));
+    TEST_ASSERT_EQUAL(1, calls);
+}
+
+void test_cli_process_checks_arg_count(void)
+{
+    TEST_ASSERT_EQUAL(CLI_E_INVALID_ARGS, run("send"));
+    TEST_ASSERT_EQUAL(CLI_OK, run("send a b c"));
+    TEST_ASSERT_EQUAL(4, last_argc);
+    TEST_ASSERT_EQUAL(CLI_OK, run("status"));
+    TEST_ASSERT_EQUAL(CLI_E_INVALID_ARGS, run("status a b"));
+    TEST_ASSERT_EQUAL(2, calls);
+}
+
+void test_cli_parse_args(void)
+{
+    uint64_t value;
+    uint8_t bytes[4];
+    size_t len = 0;
+
+    TEST_ASSERT_TRUE(cli_parse_u64("10k", &value));
+    TEST_ASSERT_EQUAL_UINT64(10000, value);
+    TEST_ASSERT_TRUE(cli_parse_u64("0x10", &value));
+    TEST_ASSERT_EQUAL_UINT64(16, value);
+    TEST_ASSERT_FALSE(cli_parse_u64("-1", &value));
+    TEST_ASSERT_FALSE(cli_parse_u64("12x", &value));
+
+    TEST_ASSERT_TRUE(cli_parse_hex("0xDEAD", bytes, sizeof(bytes), &len));
+    TEST_ASSERT_TRUE(cli_parse_hex("beef", bytes, sizeof(bytes), &len));
+    TEST_ASSERT_EQUAL(4, len);
+    TEST_ASSERT_EQUAL_HEX8(0xEF, bytes[3]);
+    TEST_ASSERT_FALSE(cli_parse_hex("00", bytes, sizeof(bytes), &len));
+    TEST_ASSERT_FALSE(cli_parse_hex("abc", bytes, sizeof(bytes), &len));
+
+    len = 0;
+    TEST_ASSERT_FALSE(cli_parse_hex("0x+1", bytes, sizeof(bytes), &len));
+    TEST_ASSERT_FALSE(cli_parse_hex(" 1", bytes, sizeof(bytes), &len));
+    TEST_ASSERT_FALSE(cli_parse_hex("-1", bytes, sizeof(bytes), &len));
+    TEST_ASSERT_FALSE(cli_parse_hex("01zz", bytes, sizeof(bytes), &len));
+    TEST_ASSERT_EQUAL(0, len);
+    TEST_ASSERT_EQUAL_HEX8(0xDE, bytes[0]);
+}
+
+void test_cli_tokenize_in_place(void)
+{
+    char line[] = "  send\thex  DEAD  ";
+    char *argv[8];
+    int argc;
+
+    TEST_ASSERT_EQUAL(CLI_OK, cli_tokenize(line, &argc, argv, 8));
+    TEST_ASSERT_EQUAL(3, argc);
+    TEST_ASSERT_EQUAL_STRING("send", argv[0]);
+    TEST_ASSERT_EQUAL_STRING("hex", argv[1]);
+    TEST_ASSERT_EQUAL_STRING("DEAD", argv[2]);
+    TEST_ASSERT_TRUE((argv[0] >= line) && (argv[2] < line + sizeof(line)));
+}
+
+void test_cli_tokenize_quotes_and_escapes(void)
+{
+    char line[] = "a \"b c\" 'd \\x41' e\\ f \"\\x41\\t\" \"\"";
+    char *argv[8];
+    int argc;
+
+    TEST_ASSERT_EQUAL(CLI_OK, cli_tokenize(line, &argc, argv, 8));
+    TEST_ASSERT_EQUAL(6, argc);
+    TEST_ASSERT_EQUAL_STRING("b c", argv[1]);
+    TEST_ASSERT_EQUAL_STRING("d \\x41", argv[2]);
+    TEST_ASSERT_EQUAL_STRING("e f", argv[3]);
+    TEST_ASSERT_EQUAL_STRING("A\t", argv[4]);
+    TEST_ASSERT_EQUAL_STRING("", argv[5]);
+}
+
+void test_cli_tokenize_errors(void)
+{
+    char unterminated[] = "send \"abc";
+    char bad_hex[] = "send \\xZZ";
+    char nul_byte[] = "send \\x00";
+    char many[] = "a b c d";
+    char *argv[3];
+    int argc;
+
+    TEST_ASSERT_EQUAL(CLI_E_INVALID_ARGS, cli_tokenize(unterminated, &argc, argv, 3));
+    TEST_ASSERT_EQUAL(CLI_E_INVALID_ARGS, cli_tokenize(bad_hex, &argc, argv, 3));
+    TEST_ASSERT_EQUAL(CLI_E_INVALID_ARGS, cli_tokenize(nul_byte, &argc, argv, 3));
+    TEST_ASSERT_EQUAL(CLI_E_BUF_FULL, cli_tokenize(many, &argc, argv, 3));
+}
+
+void test_cli_lines_do_not_leak(void)
+{
+    TEST_ASSERT_EQUAL(CLI_OK, run("send abcdef x"));
+    TEST_ASSERT_EQUAL(3, last_argc);
+    TEST_ASSERT_EQUAL(CLI_OK, run("send a"));
+    TEST_ASSERT_EQUAL(2, last_argc);
+    TEST_ASSERT_EQUAL(CLI_OK, run("sendx\b a\bb"));
+    TEST_ASSERT_EQUAL(2, last_argc);
+}
@@ -0,0 +1,106 @@
+#include "unity.h"
+#include "flow.h"
+#include "flow.c"
+#include "time_funcs.h"
+#include <string.h>
+
+/* 10000 B/s is 1000 bytes per window */
+#define MAX_RATE    10000U
+#define BUDGET      ((MAX_RATE * FLOW_WINDOW_NS) / NSEC_PER_SEC)
+
+static flow_t flow;
+
+void setUp(void)
+{
+    flow_init(&flow, "test", MAX_RATE, 0);
+}
+
+void tearDown(void)
+{
+}
+
+void test_flow_under_budget_stays_full(void)
+{
+    for (uint32_t i = 0; i < 50; i++) {
+        TEST_ASSERT_FALSE(flow_offer(&flow, BUDGET / 2, i * FLOW_WINDOW_NS));
+    }
+    TEST_ASSERT_EQUAL(FLOW_MODE_FULL, flow_get_mode(&flow));
+    TEST_ASSERT_EQUAL(0, flow.degraded_count);
+}
+
+void test_flow_degrades_within_the_window(void)
+{
+    TEST_ASSERT_FALSE(flow_offer(&flow, BUDGET, 0));
+
+    // One byte over the window's budget switches at once
+    TEST_ASSERT_TRUE(flow_offer(&flow, 1, FLOW_WINDOW_NS / 2));
+    TEST_ASSERT_EQUAL(FLOW_MODE_SUMMARY, flow_get_mode(&flow));
+    TEST_ASSERT_EQUAL(1, flow.degraded_count);
+
+    // Staying overloaded isn't another change
+    TEST_ASSERT_FALSE(flow_offer(&flow, BUDGET * 2, FLOW_WINDOW_NS / 2));
+    TEST_ASSERT_EQUAL(1, flow.degraded_count);
+}
+
+void test_flow_backlog_degrades(void)
+{
+    TEST_ASSERT_TRUE(flow_report_backlog(&flow, 10));
+    TEST_ASSERT_EQUAL(FLOW_MODE_SUMMARY, flow_get_mode(&flow));
+}
+
+void test_flow_recovers_after_calm_windows(void)
+{
+    uint64_t now = 0;
+
+    flow_offer(&flow, BUDGET * 3, now);
+    TEST_ASSERT_EQUAL(FLOW_MODE_SUMMARY, flow_get_mode(&flow));
+
+    // Just under the budget isn't calm enough to recover
+    for (uint32_t i = 0; i < 2 * FLOW_RECOVER_WINDOWS; i++) {
+        now += FLOW_WINDOW_NS;
+        flow_offer(&flow, BUDGET - 1, now);
+    }
+    TEST_ASSERT_EQUAL(FLOW_MODE_SUMMARY, flow_get_mode(&flow));
+
+    // Under the recovery level for FLOW_RECOVER_WINDOWS full windows
+    bool changed = false;
+    uint32_t windows = 0;
+    while (!changed && (windows < 2 * FLOW_RECOVER_WINDOWS)) {
+        now += FLOW_WINDOW_NS;
+        changed = flow_offer(&flow, BUDGET / 2, now);
+        windows++;
+    }
+    TEST_ASSERT_TRUE(changed);
+    TEST_ASSERT_EQUAL(FLOW_RECOVER_WINDOWS + 1, windows);
+    TEST_ASSERT_EQUAL(FLOW_MODE_FULL, flow_get_mode(&flow));
+}
+
+void test_flow_recovers_when_idle(void)
+{
+    flow_offer(&flow, BUDGET * 3, 0);
+
+    // Nothing arrives any more: a tick long enough later recovers
+    TEST_ASSERT_FALSE(flow_tick(&flow, FLOW_WINDOW_NS / 2));
+    TEST_ASSERT_TRUE(flow_tick(&flow, (FLOW_RECOVER_WINDOWS + 2) * FLOW_WINDOW_NS));
+    TEST_ASSERT_EQUAL(FLOW_MODE_FULL, flow_get_mode(&flow));
+    TEST_ASSERT_EQUAL(0, flow.last_rate);
+}
+
+void test_flow_last_rate(void)
+{
+    flow_offer(&flow, 500, 0);
+    flow_tick(&flow, FLOW_WINDOW_NS);
+    TEST_ASSERT_EQUAL(500 * (NSEC_PER_SEC / FLOW_WINDOW_NS), flow.last_rate);
+}
+
+void test_flow_skipped_markers(void)
+{
+    flow_skip(&flow, 100);
+    flow_skip(&flow, 20);
+    TEST_ASSERT_EQUAL(120, flow_take_skipped(&flow));
+    TEST_ASSERT_EQUAL(0, flow_take_skipped(&flow));
+
+    flow_skip(&flow, 5);
+    TEST_ASSERT_EQUAL(5, flow_take_skipped(&flow));
+    TEST_ASSERT_EQUAL(125, flow.skipped_total);
+}
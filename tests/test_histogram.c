@@ -0,0 +1,112 @@
+#include "unity.h"
+#include "histogram.h"
+#include "histogram.c"
+#include <stdint.h>
+
+
+static histogram_t hist;
+
+/**
+ * @brief Set up function that is called before each test case.
+ */
+void setUp(void)
+{
+    histogram_init(&hist);
+}
+
+/**
+ * @brief Tear down function that is called after each test case.
+ */
+void tearDown(void)
+{
+
+}
+
+void test_histogram_init(void)
+{
+    // Test an initialized histogram is empty
+    TEST_ASSERT_EQUAL(0, hist.total);
+    TEST_ASSERT_EQUAL(0, hist.max);
+    TEST_ASSERT_EQUAL(0, histogram_percentile(&hist, 50.0));
+    TEST_ASSERT_EQUAL(0, histogram_mean(&hist));
+
+    // Test initialization with NULL
+    histogram_init(NULL);
+    // No assertions, just checking for any crashes
+}
+
+void test_histogram_bucket_index(void)
+{
+    // Small values are exact
+    TEST_ASSERT_EQUAL(0, histogram_bucket_index(0));
+    TEST_ASSERT_EQUAL(31, histogram_bucket_index(31));
+    TEST_ASSERT_EQUAL(31, histogram_bucket_high(31));
+
+    // Values past the first boundary share buckets two at a time, then four at a time, ...
+    TEST_ASSERT_EQUAL(32, histogram_bucket_index(32));
+    TEST_ASSERT_EQUAL(32, histogram_bucket_index(33));
+    TEST_ASSERT_EQUAL(33, histogram_bucket_high(32));
+    TEST_ASSERT_EQUAL(48, histogram_bucket_index(64));
+    TEST_ASSERT_EQUAL(67, histogram_bucket_high(48));
+
+    // The whole 64-bit range fits
+    TEST_ASSERT_EQUAL(HISTOGRAM_BUCKET_COUNT - 1, histogram_bucket_index(UINT64_MAX));
+    TEST_ASSERT_TRUE(histogram_bucket_high(HISTOGRAM_BUCKET_COUNT - 1) == UINT64_MAX);
+}
+
+void test_histogram_bucket_bounds_are_contiguous(void)
+{
+    // Every bucket starts right after the previous one ends
+    for (uint32_t i = 1; i < HISTOGRAM_BUCKET_COUNT; i++) {
+        uint64_t low = histogram_bucket_high(i - 1) + 1;
+        TEST_ASSERT_EQUAL(i, histogram_bucket_index(low));
+        TEST_ASSERT_EQUAL(i, histogram_bucket_index(histogram_bucket_high(i)));
+    }
+}
+
+void test_histogram_record(void)
+{
+    histogram_record(&hist, 10);
+    histogram_record(&hist, 30);
+
+    TEST_ASSERT_EQUAL(2, hist.total);
+    TEST_ASSERT_EQUAL(10, hist.min);
+    TEST_ASSERT_EQUAL(30, hist.max);
+    TEST_ASSERT_EQUAL(20, histogram_mean(&hist));
+
+    // Test recording into a NULL histogram
+    histogram_record(NULL, 10);
+    // No assertions, just checking for any crashes
+}
+
+void test_histogram_percentile(void)
+{
+    // 1..1000 microseconds, in nanoseconds
+    for (uint64_t i = 1; i <= 1000; i++) {
+        histogram_record(&hist, i * 1000);
+    }
+
+    // Within the bucket resolution (1/16) of the exact answer
+    TEST_ASSERT_UINT64_WITHIN(500000 / 16, 500000, histogram_percentile(&hist, 50.0));
+    TEST_ASSERT_UINT64_WITHIN(990000 / 16, 990000, histogram_percentile(&hist, 99.0));
+
+    // The top is clamped to the largest value recorded
+    TEST_ASSERT_UINT64_WITHIN(1000 / 16, 1000, histogram_percentile(&hist, 0.0));
+    TEST_ASSERT_EQUAL(1000000, histogram_percentile(&hist, 100.0));
+    TEST_ASSERT_EQUAL(1000000, histogram_percentile(&hist, 99.9));
+}
+
+void test_histogram_merge(void)
+{
+    histogram_t other;
+    histogram_init(&other);
+
+    histogram_record(&hist, 5);
+    histogram_record(&other, 500);
+    histogram_merge(&hist, &other);
+
+    TEST_ASSERT_EQUAL(2, hist.total);
+    TEST_ASSERT_EQUAL(5, hist.min);
+    TEST_ASSERT_EQUAL(500, hist.max);
+    TEST_ASSERT_EQUAL(500, histogram_percentile(&hist, 100.0));
+}
@@ -0,0 +1,115 @@
+#include "unity.h"
+#include "history.h"
+#include "history.c"
+#include <stdint.h>
+
+#define CHUNK_SIZE 16U
+#define MAX_BYTES (4U * CHUNK_SIZE)
+
+static history_t history;
+
+/**
+ * @brief Set up function that is called before each test case.
+ */
+void setUp(void)
+{
+    history_init(&history, CHUNK_SIZE, MAX_BYTES);
+}
+
+/**
+ * @brief Tear down function that is called after each test case.
+ */
+void tearDown(void)
+{
+    history_deinit(&history);
+}
+
+static void append_counting(uint64_t from, size_t len)
+{
+    uint8_t data[256];
+
+    for (size_t i = 0; i < len; i++) {
+        data[i] = (uint8_t)(from + i);
+    }
+    TEST_ASSERT_EQUAL(len, history_append(&history, data, len));
+}
+
+void test_history_init(void)
+{
+    history_t h;
+
+    TEST_ASSERT_TRUE(history_init(&h, CHUNK_SIZE, MAX_BYTES));
+    TEST_ASSERT_EQUAL(4, h.max_chunks);
+    TEST_ASSERT_EQUAL(0, history_start(&h));
+    TEST_ASSERT_EQUAL(0, history_end(&h));
+    history_deinit(&h);
+
+    // A cap below one chunk still keeps one
+    TEST_ASSERT_TRUE(history_init(&h, CHUNK_SIZE, 1));
+    TEST_ASSERT_EQUAL(1, h.max_chunks);
+    history_deinit(&h);
+
+    TEST_ASSERT_FALSE(history_init(&h, 0, MAX_BYTES));
+    TEST_ASSERT_FALSE(history_init(NULL, CHUNK_SIZE, MAX_BYTES));
+}
+
+void test_history_read_across_chunks(void)
+{
+    uint8_t out[64];
+
+    append_counting(0, 5);
+    append_counting(5, 30);
+    TEST_ASSERT_EQUAL(35, history_end(&history));
+
+    // Spans chunks 0, 1 and 2
+    TEST_ASSERT_EQUAL(30, history_read(&history, 3, out, 30));
+    for (size_t i = 0; i < 30; i++) {
+        TEST_ASSERT_EQUAL((uint8_t)(3 + i), out[i]);
+    }
+
+    // Limited to what has been written
+    TEST_ASSERT_EQUAL(5, history_read(&history, 30, out, sizeof(out)));
+    TEST_ASSERT_EQUAL(0, history_read(&history, 35, out, sizeof(out)));
+}
+
+void test_history_evicts_oldest_chunk(void)
+{
+    uint8_t out[8];
+
+    // Fill the cap exactly, nothing is evicted yet
+    append_counting(0, MAX_BYTES);
+    TEST_ASSERT_EQUAL(0, history_start(&history));
+
+    // The first byte of a fifth chunk reuses the first one
+    append_counting(MAX_BYTES, 1);
+    TEST_ASSERT_EQUAL(CHUNK_SIZE, history_start(&history));
+    TEST_ASSERT_EQUAL(0, history_read(&history, 0, out, sizeof(out)));
+
+    TEST_ASSERT_EQUAL(1, history_read(&history, MAX_BYTES, out, sizeof(out)));
+    TEST_ASSERT_EQUAL((uint8_t)MAX_BYTES, out[0]);
+    TEST_ASSERT_EQUAL(8, history_read(&history, CHUNK_SIZE, out, sizeof(out)));
+    TEST_ASSERT_EQUAL(CHUNK_SIZE, out[0]);
+}
+
+void test_history_long_run_stays_bounded(void)
+{
+    uint8_t out[MAX_BYTES];
+    uint64_t end = 0;
+
+    for (uint32_t i = 0; i < 100; i++) {
+        append_counting(end, 37);
+        end += 37;
+    }
+
+    // Only whole chunks are held, and never more than the cap
+    uint64_t start = history_start(&history);
+    TEST_ASSERT_EQUAL(0, start % CHUNK_SIZE);
+    TEST_ASSERT_TRUE(end - start <= MAX_BYTES);
+    TEST_ASSERT_TRUE(end - start > MAX_BYTES - CHUNK_SIZE);
+
+    size_t n = history_read(&history, start, out, sizeof(out));
+    TEST_ASSERT_EQUAL(end - start, n);
+    for (size_t i = 0; i < n; i++) {
+        TEST_ASSERT_EQUAL((uint8_t)(start + i), out[i]);
+    }
+}
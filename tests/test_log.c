@@ -0,0 +1,105 @@
+#include "unity.h"
+#include "log.h"
+#include "log.c"
+#include <stdarg.h>
+#include <stdio.h>
+
+static _Alignas(8) uint8_t rec[LOG_MAX_RECORD];
+static char out[LOG_LINE_BYTES];
+static char expected[LOG_LINE_BYTES];
+
+/**
+ * @brief Encode a message as log_write would.
+ */
+static size_t encode(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    size_t size = log_encode_record(rec, LOG_LEVEL_INFO, 7, fmt, args);
+    va_end(args);
+    return size;
+}
+
+/**
+ * @brief Encode a message as log_write would, format it back and compare with snprintf.
+ */
+static void check(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    size_t size = log_encode_record(rec, LOG_LEVEL_INFO, 7, fmt, args);
+    va_end(args);
+
+    va_start(args, fmt);
+    vsnprintf(expected, sizeof(expected), fmt, args);
+    va_end(args);
+
+    TEST_ASSERT_TRUE(size <= LOG_MAX_RECORD);
+    TEST_ASSERT_EQUAL(0, size % 8);
+    log_format_record(rec, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING(expected, out);
+}
+
+/**
+ * @brief Set up function that is called before each test case.
+ */
+void setUp(void)
+{
+    memset(rec, 0xA5, sizeof(rec));
+}
+
+/**
+ * @brief Tear down function that is called after each test case.
+ */
+void tearDown(void)
+{
+}
+
+void test_log_integers(void)
+{
+    check("plain text\n");
+    check("%d %i %u %x %X %o", -5, 42, 3000000000U, 0xBEEF, 0xBEEF, 8);
+    check("%02X %-6d| %+d %ld %llu %zu", 0x0A, 12, 7, -123456789L, 18446744073709551615ULL, (size_t)99);
+    check("%hhx %hd %hhu", 0x1FF, 70000, 300);
+    check("%c%c %% %5.2f %e %g", 'o', 'k', 3.14159, 12345.678, 0.0001);
+}
+
+void test_log_strings_are_copied(void)
+{
+    char temp[16] = "temporary";
+
+    check("[%s] [%10s] [%-4s] [%.3s]", temp, "right", "l", "truncate");
+    check("%.*s|%*d|%-*d|", 4, "abcdefgh", 6, 42, 5, 7);
+
+    /* The record keeps its own copy */
+    strcpy(temp, "changed");
+    log_format_record(rec, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING(expected, out);
+}
+
+void test_log_long_strings_are_cut(void)
+{
+    static char big[3000];
+    memset(big, 'x', sizeof(big) - 1);
+
+    size_t size = encode("%s!", big);
+    size_t len = log_format_record(rec, out, sizeof(out));
+
+    /* The copy stops at the end of the record, the rest of the format still prints */
+    TEST_ASSERT_TRUE(size <= LOG_MAX_RECORD);
+    TEST_ASSERT_TRUE(len > LOG_MAX_RECORD / 2);
+    TEST_ASSERT_TRUE(len < LOG_MAX_RECORD);
+    TEST_ASSERT_EQUAL('x', out[len - 2]);
+    TEST_ASSERT_EQUAL('!', out[len - 1]);
+}
+
+void test_log_output_buffer_is_bounded(void)
+{
+    char small[8];
+
+    check("%s %d", "abcdefghij", 12345);
+    TEST_ASSERT_EQUAL(7, log_format_record(rec, small, sizeof(small)));
+    TEST_ASSERT_EQUAL_STRING("abcdefg", small);
+}
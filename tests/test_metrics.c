@@ -0,0 +1,130 @@
+#include "unity.h"
+#include "metrics.h"
+#include "metrics.c"
+#include "histogram.h"
+#include <string.h>
+
+static char text[8192];
+
+static uint64_t read_42(void)
+{
+    return 42;
+}
+
+void setUp(void)
+{
+    metrics_deinit();
+}
+
+void tearDown(void)
+{
+    metrics_deinit();
+}
+
+void test_counter_and_gauge(void)
+{
+    metric_t *bytes = metrics_counter("rx_bytes_total", "Bytes read");
+    metric_t *fill = metrics_gauge("rx_fill_bytes", "Bytes waiting");
+
+    metrics_add(bytes, 100);
+    metrics_add(bytes, 28);
+    metrics_set(fill, 7);
+
+    size_t len = metrics_format(text, sizeof(text));
+    TEST_ASSERT_EQUAL(strlen(text), len);
+    TEST_ASSERT_NOT_NULL(strstr(text, "# HELP serial_tool_rx_bytes_total Bytes read\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "# TYPE serial_tool_rx_bytes_total counter\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\nserial_tool_rx_bytes_total 128\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "# TYPE serial_tool_rx_fill_bytes gauge\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\nserial_tool_rx_fill_bytes 7\n"));
+}
+
+void test_register_twice_returns_same(void)
+{
+    metric_t *a = metrics_counter("x_total", "X");
+    metric_t *b = metrics_counter("x_total", "X");
+
+    TEST_ASSERT_TRUE(a == b);
+
+    /* Same name, different type is refused */
+    TEST_ASSERT_NULL(metrics_gauge("x_total", "X"));
+}
+
+void test_high_water_mark(void)
+{
+    metric_t *hw = metrics_gauge("hw_bytes", "High water");
+
+    metrics_max(hw, 10);
+    metrics_max(hw, 5);
+    metrics_max(hw, 12);
+    metrics_max(hw, 11);
+
+    TEST_ASSERT_EQUAL(12, atomic_load(&hw->value));
+}
+
+void test_null_metric_ignored(void)
+{
+    metrics_add(NULL, 1);
+    metrics_set(NULL, 1);
+    metrics_max(NULL, 1);
+    metrics_observe(NULL, 1);
+
+    TEST_ASSERT_EQUAL(0, metrics_format(text, sizeof(text)));
+    TEST_ASSERT_EQUAL('\0', text[0]);
+}
+
+void test_registry_full(void)
+{
+    static char names[METRICS_MAX + 1][16];
+
+    for (uint32_t i = 0; i < METRICS_MAX; i++) {
+        snprintf(names[i], sizeof(names[i]), "m%u_total", i);
+        TEST_ASSERT_NOT_NULL(metrics_counter(names[i], "M"));
+    }
+    snprintf(names[METRICS_MAX], sizeof(names[METRICS_MAX]), "extra_total");
+    TEST_ASSERT_NULL(metrics_counter(names[METRICS_MAX], "M"));
+}
+
+void test_read_function(void)
+{
+    metrics_register_fn("dropped_total", "Dropped", METRIC_COUNTER, read_42);
+    TEST_ASSERT_NULL(metrics_register_fn("hist", "H", METRIC_HISTOGRAM, read_42));
+
+    metrics_format(text, sizeof(text));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\nserial_tool_dropped_total 42\n"));
+}
+
+void test_histogram_buckets(void)
+{
+    metric_t *lat = metrics_histogram("latency_seconds", "Latency");
+
+    metrics_observe(lat, 50000);        /* 50 us */
+    metrics_observe(lat, 50000);
+    metrics_observe(lat, 20000000);     /* 20 ms */
+    metrics_observe(lat, 3000000000);   /* 3 s */
+
+    metrics_format(text, sizeof(text));
+    TEST_ASSERT_NOT_NULL(strstr(text, "# TYPE serial_tool_latency_seconds histogram\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "serial_tool_latency_seconds_bucket{le=\"1e-05\"} 0\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "serial_tool_latency_seconds_bucket{le=\"0.0001\"} 2\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "serial_tool_latency_seconds_bucket{le=\"0.01\"} 2\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "serial_tool_latency_seconds_bucket{le=\"0.0333\"} 3\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "serial_tool_latency_seconds_bucket{le=\"1\"} 3\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "serial_tool_latency_seconds_bucket{le=\"+Inf\"} 4\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "serial_tool_latency_seconds_sum 3.020100000\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "serial_tool_latency_seconds_count 4\n"));
+}
+
+void test_format_reports_full_length(void)
+{
+    char small[16];
+    metric_t *bytes = metrics_counter("rx_bytes_total", "Bytes read");
+    metrics_add(bytes, 1);
+
+    size_t full = metrics_format(NULL, 0);
+    TEST_ASSERT_TRUE(full > sizeof(small));
+    TEST_ASSERT_EQUAL(full, metrics_format(small, sizeof(small)));
+    TEST_ASSERT_EQUAL(sizeof(small) - 1, strlen(small));
+    TEST_ASSERT_EQUAL(full, metrics_format(text, sizeof(text)));
+    TEST_ASSERT_EQUAL(full, strlen(text));
+}
@@ -0,0 +1,146 @@
+#include "unity.h"
+#include "mpsc_queue.h"
+#include "mpsc_queue.c"
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define QUEUE_SIZE 8U
+
+#define PRODUCERS 4U
+#define ITEMS_PER_PRODUCER 20000U
+
+static mpsc_queue_t queue;
+static uint32_t items[QUEUE_SIZE];
+static atomic_size_t seq[QUEUE_SIZE];
+
+/**
+ * @brief Set up function that is called before each test case.
+ */
+void setUp(void)
+{
+    mpsc_queue_init(&queue, items, seq, QUEUE_SIZE, sizeof(uint32_t));
+}
+
+/**
+ * @brief Tear down function that is called after each test case.
+ */
+void tearDown(void)
+{
+
+}
+
+void test_mpsc_queue_init(void)
+{
+    mpsc_queue_t q;
+
+    TEST_ASSERT_TRUE(mpsc_queue_init(&q, items, seq, QUEUE_SIZE, sizeof(uint32_t)));
+    TEST_ASSERT_EQUAL(0, mpsc_queue_count(&q));
+    TEST_ASSERT_EQUAL(0, mpsc_queue_dropped(&q));
+
+    // The size must be a power of two
+    TEST_ASSERT_FALSE(mpsc_queue_init(&q, items, seq, 6, sizeof(uint32_t)));
+    TEST_ASSERT_FALSE(mpsc_queue_init(&q, items, seq, 0, sizeof(uint32_t)));
+    TEST_ASSERT_FALSE(mpsc_queue_init(NULL, items, seq, QUEUE_SIZE, sizeof(uint32_t)));
+    TEST_ASSERT_FALSE(mpsc_queue_init(&q, NULL, seq, QUEUE_SIZE, sizeof(uint32_t)));
+}
+
+void test_mpsc_queue_push_pop(void)
+{
+    uint32_t item;
+
+    TEST_ASSERT_FALSE(mpsc_queue_pop(&queue, &item));
+
+    for (uint32_t i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(mpsc_queue_push(&queue, &i));
+    }
+    TEST_ASSERT_EQUAL(3, mpsc_queue_count(&queue));
+
+    // First in, first out
+    for (uint32_t i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(mpsc_queue_pop(&queue, &item));
+        TEST_ASSERT_EQUAL(i, item);
+    }
+    TEST_ASSERT_FALSE(mpsc_queue_pop(&queue, &item));
+    TEST_ASSERT_EQUAL(0, mpsc_queue_count(&queue));
+}
+
+void test_mpsc_queue_full_drops(void)
+{
+    uint32_t item = 0;
+
+    for (uint32_t i = 0; i < QUEUE_SIZE; i++) {
+        TEST_ASSERT_TRUE(mpsc_queue_push(&queue, &i));
+    }
+
+    // A full queue fails the push instead of waiting and counts it
+    item = 99;
+    TEST_ASSERT_FALSE(mpsc_queue_push(&queue, &item));
+    TEST_ASSERT_FALSE(mpsc_queue_push(&queue, &item));
+    TEST_ASSERT_EQUAL(2, mpsc_queue_dropped(&queue));
+    TEST_ASSERT_EQUAL(QUEUE_SIZE, mpsc_queue_count(&queue));
+
+    // Popping one makes room for one
+    TEST_ASSERT_TRUE(mpsc_queue_pop(&queue, &item));
+    TEST_ASSERT_EQUAL(0, item);
+    item = 100;
+    TEST_ASSERT_TRUE(mpsc_queue_push(&queue, &item));
+}
+
+void test_mpsc_queue_wraps(void)
+{
+    uint32_t item;
+
+    // Many laps around the slots keep the order
+    for (uint32_t i = 0; i < QUEUE_SIZE * 10; i++) {
+        TEST_ASSERT_TRUE(mpsc_queue_push(&queue, &i));
+        TEST_ASSERT_TRUE(mpsc_queue_pop(&queue, &item));
+        TEST_ASSERT_EQUAL(i, item);
+    }
+    TEST_ASSERT_EQUAL(0, mpsc_queue_dropped(&queue));
+}
+
+static void *producer(void *arg)
+{
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+
+    for (uint32_t i = 0; i < ITEMS_PER_PRODUCER; i++) {
+        uint32_t item = (id << 24) | i;
+        // Retry so the consumer sees every item
+        while (!mpsc_queue_push(&queue, &item)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void test_mpsc_queue_threads(void)
+{
+    pthread_t threads[PRODUCERS];
+    uint32_t next[PRODUCERS] = {0};
+    uint32_t received = 0;
+    uint32_t item;
+
+    for (uint32_t i = 0; i < PRODUCERS; i++) {
+        pthread_create(&threads[i], NULL, producer, (void *)(uintptr_t)i);
+    }
+
+    // Each producer's items arrive complete and in the order it pushed them
+    while (received < PRODUCERS * ITEMS_PER_PRODUCER) {
+        if (mpsc_queue_pop(&queue, &item)) {
+            uint32_t id = item >> 24;
+            TEST_ASSERT_LESS_THAN(PRODUCERS, id);
+            TEST_ASSERT_EQUAL(next[id], item & 0xFFFFFFU);
+            next[id]++;
+            received++;
+        }
+        else {
+            sched_yield();
+        }
+    }
+
+    for (uint32_t i = 0; i < PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    TEST_ASSERT_FALSE(mpsc_queue_pop(&queue, &item));
+}
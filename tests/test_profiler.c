@@ -0,0 +1,115 @@
+#include "unity.h"
+#include "profiler.h"
+#include "profiler.c"
+#include "histogram.h"
+#include "time_funcs.h"
+#include <string.h>
+
+#define WINDOW_NS   (500ULL * NSEC_PER_MSEC)
+
+static prof_report_t report;
+static char text[1024];
+
+/**
+ * @brief True if a is within 10% of b (cycle conversions round, histogram buckets are ~6%).
+ */
+static bool close_to(uint64_t a, uint64_t b)
+{
+    uint64_t diff = (a > b) ? (a - b) : (b - a);
+    return (diff * 10) <= b;
+}
+
+void setUp(void)
+{
+    memset(&report, 0xA5, sizeof(report));
+    profiler_init(0);
+}
+
+void tearDown(void)
+{
+}
+
+void test_empty_window(void)
+{
+    profiler_roll(WINDOW_NS, &report);
+
+    TEST_ASSERT_EQUAL(WINDOW_NS, report.window_ns);
+    for (uint32_t i = 0; i < PROF_STAGE_MAX; i++) {
+        TEST_ASSERT_EQUAL(0, report.stages[i].count);
+        TEST_ASSERT_EQUAL(0, report.stages[i].busy_ns);
+        TEST_ASSERT_EQUAL(0, report.stages[i].max_ns);
+        TEST_ASSERT_EQUAL(0, report.stages[i].p99_ns);
+        TEST_ASSERT_EQUAL(0, report.stages[i].bytes);
+    }
+}
+
+void test_busy_max_and_bytes(void)
+{
+    /* 99 runs of 100us and one of 5ms: 14.9ms busy in 500ms */
+    for (int i = 0; i < 99; i++) {
+        profiler_record(PROF_STAGE_SINKS, nanos_to_cycles(100 * NSEC_PER_USEC), 1000);
+    }
+    profiler_record(PROF_STAGE_SINKS, nanos_to_cycles(5 * NSEC_PER_MSEC), 1000);
+
+    profiler_roll(WINDOW_NS, &report);
+    const prof_stage_report_t *r = &report.stages[PROF_STAGE_SINKS];
+
+    TEST_ASSERT_EQUAL(100, r->count);
+    TEST_ASSERT_TRUE(close_to(r->busy_ns, 14900 * NSEC_PER_USEC));
+    TEST_ASSERT_TRUE((r->busy_pct > 2.8) && (r->busy_pct < 3.2));
+    TEST_ASSERT_TRUE(close_to(r->max_ns, 5 * NSEC_PER_MSEC));
+    TEST_ASSERT_TRUE(close_to(r->p99_ns, 100 * NSEC_PER_USEC));
+    TEST_ASSERT_EQUAL(100000, r->bytes);
+    TEST_ASSERT_TRUE((r->bytes_per_sec > 199999.0) && (r->bytes_per_sec < 200001.0));
+
+    /* Other stages are untouched */
+    TEST_ASSERT_EQUAL(0, report.stages[PROF_STAGE_LVGL].count);
+}
+
+void test_roll_starts_new_window(void)
+{
+    profiler_record(PROF_STAGE_CLI, nanos_to_cycles(NSEC_PER_MSEC), 10);
+    profiler_roll(WINDOW_NS, &report);
+    TEST_ASSERT_EQUAL(1, report.stages[PROF_STAGE_CLI].count);
+
+    profiler_roll(2 * WINDOW_NS, &report);
+    TEST_ASSERT_EQUAL(WINDOW_NS, report.window_ns);
+    TEST_ASSERT_EQUAL(0, report.stages[PROF_STAGE_CLI].count);
+    TEST_ASSERT_EQUAL(0, report.stages[PROF_STAGE_CLI].bytes);
+}
+
+void test_bad_stage_ignored(void)
+{
+    profiler_record(PROF_STAGE_MAX, 1000, 1000);
+    profiler_roll(WINDOW_NS, &report);
+
+    for (uint32_t i = 0; i < PROF_STAGE_MAX; i++) {
+        TEST_ASSERT_EQUAL(0, report.stages[i].count);
+    }
+}
+
+void test_format_names_busiest_stage(void)
+{
+    profiler_record(PROF_STAGE_LVGL, nanos_to_cycles(200 * NSEC_PER_MSEC), 0);
+    profiler_record(PROF_STAGE_SERIAL_IO, nanos_to_cycles(NSEC_PER_MSEC), 4096);
+    profiler_roll(WINDOW_NS, &report);
+
+    size_t len = profiler_format(&report, text, sizeof(text));
+    TEST_ASSERT_EQUAL(strlen(text), len);
+
+    for (uint32_t i = 0; i < PROF_STAGE_MAX; i++) {
+        TEST_ASSERT_NOT_NULL(strstr(text, profiler_stage_name((prof_stage_t)i)));
+    }
+    TEST_ASSERT_NOT_NULL(strstr(text, "most in lvgl"));
+}
+
+void test_format_cut_to_buffer(void)
+{
+    char small[32];
+
+    profiler_roll(WINDOW_NS, &report);
+    size_t len = profiler_format(&report, small, sizeof(small));
+
+    TEST_ASSERT_EQUAL(sizeof(small) - 1, len);
+    TEST_ASSERT_EQUAL(len, strlen(small));
+}
@@ -166,3 +166,93 @@ void test_ring_buf_pop(void)
     TEST_ASSERT_FALSE(ring_buf_pop(NULL, &item));
 }
 
+
+void test_ring_buf_count_and_space(void)
+{
+    ring_buf_t buf;
+    uint8_t buffer[10];
+    uint8_t item = 0x55;
+
+    // Initialize the buffer
+    ring_buf_init(&buf, buffer, sizeof(buffer), sizeof(uint8_t));
+
+    // One slot is reserved, so an empty buffer of 10 holds 9 items
+    TEST_ASSERT_EQUAL(0, ring_buf_count(&buf));
+    TEST_ASSERT_EQUAL(9, ring_buf_space(&buf));
+
+    ring_buf_push(&buf, &item);
+    ring_buf_push(&buf, &item);
+    TEST_ASSERT_EQUAL(2, ring_buf_count(&buf));
+    TEST_ASSERT_EQUAL(7, ring_buf_space(&buf));
+
+    // Test a wrapped buffer
+    buf.head = 2;
+    buf.tail = 8;
+    TEST_ASSERT_EQUAL(4, ring_buf_count(&buf));
+    TEST_ASSERT_EQUAL(5, ring_buf_space(&buf));
+
+    // Test a NULL buffer
+    TEST_ASSERT_EQUAL(0, ring_buf_count(NULL));
+    TEST_ASSERT_EQUAL(0, ring_buf_space(NULL));
+}
+
+void test_ring_buf_push_n_pop_n(void)
+{
+    ring_buf_t buf;
+    uint8_t buffer[10];
+    uint8_t in[12] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    uint8_t out[12] = {0};
+
+    // Initialize the buffer and move the indices close to the end so the copy wraps
+    ring_buf_init(&buf, buffer, sizeof(buffer), sizeof(uint8_t));
+    buf.head = 7;
+    buf.tail = 7;
+
+    // Test pushing more than fits
+    TEST_ASSERT_EQUAL(9, ring_buf_push_n(&buf, in, sizeof(in)));
+    TEST_ASSERT_TRUE(ring_buf_is_full(&buf));
+    TEST_ASSERT_EQUAL(6, buf.head);
+
+    // Test popping across the wrap
+    TEST_ASSERT_EQUAL(4, ring_buf_pop_n(&buf, out, 4));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(in, out, 4);
+    TEST_ASSERT_EQUAL(9, ring_buf_pop_n(&buf, out, sizeof(out)) + 4);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&in[4], out, 5);
+    TEST_ASSERT_TRUE(ring_buf_is_empty(&buf));
+
+    // Test NULL arguments
+    TEST_ASSERT_EQUAL(0, ring_buf_push_n(NULL, in, 1));
+    TEST_ASSERT_EQUAL(0, ring_buf_pop_n(&buf, NULL, 1));
+}
+
+void test_ring_buf_peek_contig_and_skip(void)
+{
+    ring_buf_t buf;
+    uint8_t buffer[10];
+    uint8_t in[6] = {1, 2, 3, 4, 5, 6};
+    void *span = NULL;
+
+    // Initialize the buffer so the data wraps after 3 items
+    ring_buf_init(&buf, buffer, sizeof(buffer), sizeof(uint8_t));
+    buf.head = 7;
+    buf.tail = 7;
+    ring_buf_push_n(&buf, in, sizeof(in));
+
+    // The first span runs to the end of the storage
+    TEST_ASSERT_EQUAL(3, ring_buf_peek_contig(&buf, &span));
+    TEST_ASSERT_EQUAL_PTR(&buffer[7], span);
+    TEST_ASSERT_EQUAL(3, ring_buf_skip(&buf, 3));
+
+    // The second span starts at the beginning
+    TEST_ASSERT_EQUAL(3, ring_buf_peek_contig(&buf, &span));
+    TEST_ASSERT_EQUAL_PTR(&buffer[0], span);
+    TEST_ASSERT_EQUAL(4, *(uint8_t *)span);
+
+    // Test skipping more than is available
+    TEST_ASSERT_EQUAL(3, ring_buf_skip(&buf, 100));
+    TEST_ASSERT_EQUAL(0, ring_buf_peek_contig(&buf, &span));
+
+    // Test NULL arguments
+    TEST_ASSERT_EQUAL(0, ring_buf_peek_contig(NULL, &span));
+    TEST_ASSERT_EQUAL(0, ring_buf_skip(NULL, 1));
+}
@@ -0,0 +1,67 @@
+#include "unity.h"
+#include "time_funcs.h"
+#include "time_funcs.c"
+#include <stdint.h>
+#include <time.h>
+
+
+/**
+ * @brief Set up function that is called before each test case.
+ */
+void setUp(void)
+{
+    time_funcs_init();
+}
+
+/**
+ * @brief Tear down function that is called after each test case.
+ */
+void tearDown(void)
+{
+
+}
+
+static void sleep_ms(uint32_t ms)
+{
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+void test_time_funcs_monotonic(void)
+{
+    // Test successive readings never go backwards
+    uint64_t prev = get_nanos();
+    for (int i = 0; i < 1000; i++) {
+        uint64_t now = get_nanos();
+        TEST_ASSERT_TRUE(now >= prev);
+        prev = now;
+    }
+
+    // Test the coarser clocks agree with the nanosecond clock
+    uint64_t ns = get_nanos();
+    uint64_t ms = get_millis();
+    TEST_ASSERT_UINT64_WITHIN(2, ns / NSEC_PER_MSEC, ms);
+}
+
+void test_time_funcs_cycles_to_nanos(void)
+{
+    // Test cycles measured over a sleep convert to about the same time as the clock
+    uint64_t ns_start = get_nanos_raw();
+    uint64_t cyc_start = now_cycles();
+    sleep_ms(20);
+    uint64_t cyc_end = now_cycles();
+    uint64_t ns_end = get_nanos_raw();
+
+    uint64_t clock_ns = ns_end - ns_start;
+    uint64_t cycle_ns = cycles_to_nanos(cyc_end - cyc_start);
+    TEST_ASSERT_UINT64_WITHIN(clock_ns / 100, clock_ns, cycle_ns);
+}
+
+void test_time_funcs_round_trip(void)
+{
+    // Test converting to cycles and back loses less than a cycle or two
+    TEST_ASSERT_TRUE(cycles_per_sec() > 0);
+    uint64_t cycles = nanos_to_cycles(NSEC_PER_SEC);
+    TEST_ASSERT_UINT64_WITHIN(cycles_per_sec() / 1000000, cycles_per_sec(), cycles);
+    TEST_ASSERT_UINT64_WITHIN(1000, NSEC_PER_SEC, cycles_to_nanos(cycles));
+}
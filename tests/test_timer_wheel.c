@@ -0,0 +1,153 @@
+#include "unity.h"
+#include "timer_wheel.h"
+#include "timer_wheel.c"
+#include <stdint.h>
+#include <stdlib.h>
+
+#define TICK_NS     1000000ULL
+#define MANY        5000U
+
+static timer_wheel_t wheel;
+static tw_timer_t timers[MANY];
+static uint64_t due_tick[MANY];
+static uint64_t fired_tick[MANY];
+static uint32_t fired_count;
+static uint64_t now_ns;
+
+static void on_expire(tw_timer_t *t, void *ctx)
+{
+    (void)ctx;
+    fired_tick[t - timers] = now_ns / TICK_NS;
+    fired_count++;
+}
+
+static void on_expire_again(tw_timer_t *t, void *ctx)
+{
+    uint32_t *remaining = ctx;
+    fired_count++;
+    if (--(*remaining) > 0) {
+        timer_wheel_schedule(&wheel, t, 10 * TICK_NS, on_expire_again, ctx);
+    }
+}
+
+/**
+ * @brief Set up function that is called before each test case.
+ */
+void setUp(void)
+{
+    now_ns = 12345ULL * TICK_NS;
+    timer_wheel_init(&wheel, TICK_NS, now_ns);
+    for (uint32_t i = 0; i < MANY; i++) {
+        timer_wheel_timer_init(&timers[i]);
+        fired_tick[i] = 0;
+    }
+    fired_count = 0;
+}
+
+/**
+ * @brief Tear down function that is called after each test case.
+ */
+void tearDown(void)
+{
+
+}
+
+void test_timer_wheel_single(void)
+{
+    // Test nothing pending reports no deadline
+    TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, timer_wheel_next_ns(&wheel, now_ns));
+
+    timer_wheel_schedule(&wheel, &timers[0], 5 * TICK_NS, on_expire, NULL);
+    TEST_ASSERT_TRUE(timer_wheel_is_pending(&timers[0]));
+    TEST_ASSERT_EQUAL_UINT64(5 * TICK_NS, timer_wheel_next_ns(&wheel, now_ns));
+
+    // Test it doesn't fire early
+    now_ns += 4 * TICK_NS;
+    TEST_ASSERT_EQUAL(0, timer_wheel_advance(&wheel, now_ns));
+
+    // Test it fires on time, once
+    now_ns += TICK_NS;
+    TEST_ASSERT_EQUAL(1, timer_wheel_advance(&wheel, now_ns));
+    TEST_ASSERT_FALSE(timer_wheel_is_pending(&timers[0]));
+    now_ns += 100 * TICK_NS;
+    TEST_ASSERT_EQUAL(0, timer_wheel_advance(&wheel, now_ns));
+}
+
+void test_timer_wheel_cancel(void)
+{
+    timer_wheel_schedule(&wheel, &timers[0], 3 * TICK_NS, on_expire, NULL);
+    timer_wheel_schedule(&wheel, &timers[1], 300 * TICK_NS, on_expire, NULL);
+    timer_wheel_cancel(&wheel, &timers[0]);
+    timer_wheel_cancel(&wheel, &timers[1]);
+
+    // Test cancelling twice is harmless
+    timer_wheel_cancel(&wheel, &timers[1]);
+
+    now_ns += 1000 * TICK_NS;
+    TEST_ASSERT_EQUAL(0, timer_wheel_advance(&wheel, now_ns));
+    TEST_ASSERT_EQUAL(0, wheel.count);
+}
+
+void test_timer_wheel_reschedule_from_callback(void)
+{
+    uint32_t remaining = 5;
+
+    timer_wheel_schedule(&wheel, &timers[0], 10 * TICK_NS, on_expire_again, &remaining);
+
+    // Test a periodic timer made by rescheduling from the callback
+    for (int i = 0; i < 100; i++) {
+        now_ns += TICK_NS;
+        timer_wheel_advance(&wheel, now_ns);
+    }
+    TEST_ASSERT_EQUAL(5, fired_count);
+    TEST_ASSERT_EQUAL(0, remaining);
+}
+
+void test_timer_wheel_many(void)
+{
+    srand(1);
+
+    // Test thousands of timers across every level fire exactly on their tick
+    for (uint32_t i = 0; i < MANY; i++) {
+        uint64_t delay = 1 + (uint64_t)(rand() % 300000);
+        if (i % 4 == 0) {
+            delay %= 64;
+            delay++;
+        }
+        timer_wheel_schedule(&wheel, &timers[i], delay * TICK_NS, on_expire, NULL);
+        due_tick[i] = now_ns / TICK_NS + delay;
+    }
+
+    // Advance in uneven steps, checking the deadline never overshoots a timer
+    uint64_t end_ns = now_ns + 310000ULL * TICK_NS;
+    while (now_ns < end_ns) {
+        uint64_t next = timer_wheel_next_ns(&wheel, now_ns);
+        uint64_t step = (1 + (uint64_t)(rand() % 7)) * TICK_NS;
+        if (next < step) {
+            step = (next == 0) ? TICK_NS : next;
+        }
+        now_ns += step;
+        timer_wheel_advance(&wheel, now_ns);
+    }
+
+    TEST_ASSERT_EQUAL(MANY, fired_count);
+    for (uint32_t i = 0; i < MANY; i++) {
+        TEST_ASSERT_EQUAL_UINT64(due_tick[i], fired_tick[i]);
+    }
+}
+
+void test_timer_wheel_beyond_span(void)
+{
+    // Test a timer further out than the wheel covers still fires on its tick
+    uint64_t delay = WHEEL_SPAN + 12345ULL;
+    timer_wheel_schedule(&wheel, &timers[0], delay * TICK_NS, on_expire, NULL);
+    due_tick[0] = now_ns / TICK_NS + delay;
+
+    while (0 == fired_count) {
+        uint64_t next = timer_wheel_next_ns(&wheel, now_ns);
+        TEST_ASSERT_TRUE(next != UINT64_MAX);
+        now_ns += (next > 0) ? next : TICK_NS;
+        timer_wheel_advance(&wheel, now_ns);
+    }
+    TEST_ASSERT_EQUAL_UINT64(due_tick[0], fired_tick[0]);
+}
@@ -0,0 +1,136 @@
+#include "unity.h"
+#include "trace.h"
+#include "trace.c"
+#include "time_funcs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char *json;
+static size_t json_len;
+
+/**
+ * @brief Export into a memory buffer, returns the number of events written.
+ */
+static size_t export(void)
+{
+    free(json);
+    json = NULL;
+
+    FILE *out = open_memstream(&json, &json_len);
+    TEST_ASSERT_NOT_NULL(out);
+    size_t written = trace_export_chrome(out);
+    fclose(out);
+    return written;
+}
+
+static size_t count_of(const char *needle)
+{
+    size_t n = 0;
+    for (const char *p = strstr(json, needle); NULL != p; p = strstr(p + 1, needle)) {
+        n++;
+    }
+    return n;
+}
+
+void setUp(void)
+{
+    trace_clear();
+}
+
+void tearDown(void)
+{
+    trace_stop();
+}
+
+void test_nothing_recorded_while_stopped(void)
+{
+    TRACE_BEGIN("stopped");
+    TRACE_END("stopped");
+
+    TEST_ASSERT_EQUAL(0, trace_get_count());
+    TEST_ASSERT_EQUAL(0, export());
+    TEST_ASSERT_NULL(strstr(json, "stopped"));
+}
+
+void test_event_types_exported(void)
+{
+    trace_start();
+    TRACE_BEGIN("outer");
+    TRACE_BEGIN("inner");
+    TRACE_COUNTER("bytes", 42);
+    TRACE_END("inner");
+    TRACE_INSTANT("mark");
+    TRACE_END("outer");
+
+    TEST_ASSERT_EQUAL(6, trace_get_count());
+    TEST_ASSERT_EQUAL(6, export());
+
+    TEST_ASSERT_EQUAL(0, strncmp(json, "{\"traceEvents\":[", 16));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"displayTimeUnit\":\"ns\"}"));
+    TEST_ASSERT_EQUAL(2, count_of("\"ph\":\"B\""));
+    TEST_ASSERT_EQUAL(2, count_of("\"ph\":\"E\""));
+    TEST_ASSERT_NOT_NULL(strstr(json, "{\"name\":\"bytes\",\"ph\":\"C\""));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"args\":{\"value\":42}"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "{\"name\":\"mark\",\"ph\":\"i\""));
+
+    /* Export resumes recording */
+    TEST_ASSERT_TRUE(trace_is_running());
+}
+
+void test_unmatched_end_dropped(void)
+{
+    trace_start();
+    TRACE_END("orphan");
+    TRACE_BEGIN("slice");
+    TRACE_END("slice");
+
+    TEST_ASSERT_EQUAL(2, export());
+    TEST_ASSERT_NULL(strstr(json, "orphan"));
+}
+
+void test_ring_keeps_newest(void)
+{
+    trace_start();
+    TRACE_INSTANT("old");
+    for (uint32_t i = 0; i < TRACE_RING_EVENTS + 100; i++) {
+        TRACE_COUNTER("new", i);
+    }
+
+    /* The oldest slot is never exported once the ring has wrapped */
+    TEST_ASSERT_EQUAL(TRACE_RING_EVENTS - 1, trace_get_count());
+    TEST_ASSERT_EQUAL(TRACE_RING_EVENTS - 1, export());
+    TEST_ASSERT_NULL(strstr(json, "\"old\""));
+    char last[64];
+    snprintf(last, sizeof(last), "\"args\":{\"value\":%u}", TRACE_RING_EVENTS + 99);
+    TEST_ASSERT_NOT_NULL(strstr(json, last));
+}
+
+void test_thread_name_escaped(void)
+{
+    trace_set_thread_name("ma\"in");
+    trace_start();
+    TRACE_INSTANT("x");
+
+    TEST_ASSERT_EQUAL(1, export());
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"ph\":\"M\""));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"args\":{\"name\":\"ma\\\"in\"}"));
+
+    trace_set_thread_name(NULL);
+}
+
+void test_timestamps_increase(void)
+{
+    trace_start();
+    TRACE_BEGIN("a");
+    for (volatile int i = 0; i < 100000; i++) {
+    }
+    TRACE_END("a");
+    export();
+
+    char *b = strstr(json, "\"ph\":\"B\",\"ts\":");
+    char *e = strstr(json, "\"ph\":\"E\",\"ts\":");
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT_TRUE(strtod(e + 14, NULL) > strtod(b + 14, NULL));
+}